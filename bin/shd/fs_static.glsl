@@ -34,35 +34,81 @@ layout(std430, binding = 4) readonly buffer VisibleProbesIndicesBuffer
 	VisibleIndex data[];
 } visibleProbesIndicesBuffer;
 
+// first light index and light count per cluster
+layout(std430, binding = 6) readonly buffer LightClustersBuffer
+{
+	uvec2 data[];
+} lightClustersBuffer;
+
+layout(std430, binding = 7) readonly buffer LightClusterIndicesBuffer
+{
+	uint data[];
+} lightClusterIndicesBuffer;
+
+// clusters in x, y and depth, zero if the lights are binned into screen tiles
+uniform uvec3 LightClusterCount;
+// slice = log(viewDepth) * x + y, viewDepth = z / (gl_FragCoord.z + w)
+uniform vec4 LightClusterSlicing;
+
 // V = view vector, N = surface normal, P = fragment point in world space
 vec3 CalculateGlobalLight(vec3 V, vec3 N, vec3 P, vec4 diffuseColor)
 {
     float diffuse = max(dot(GlobalLightDirection, N), 0.0);
-    vec4 shadowCoords = GlobalShadowMatrix * vec4(P, 1);
-    shadowCoords.xyzw /= shadowCoords.w;
-    shadowCoords = shadowCoords * 0.5f + 0.5f;
-    float shadowDepth = texture(GlobalShadowMap,shadowCoords.xy).r;
-    float geoDepth = shadowCoords.z;
-    // bias based on incidence angle
-    float bias = max(0.0003 * (1.0 - diffuse), 0.00035);  
-
-    // simple PCF with 3x3 kernel for now
+    vec2 texelSize = 1.0 / textureSize(GlobalShadowMap, 0).xy;
+
+    // use the first cascade that contains the point, with a texel of margin for the PCF kernel
+    int cascade = -1;
+    vec3 shadowCoords = vec3(0.0);
+    for (int i = 0; i < NumShadowCascades && cascade < 0; i++)
+    {
+        vec4 coords = GlobalShadowMatrices[i] * vec4(P, 1);
+        shadowCoords = coords.xyz / coords.w * 0.5f + 0.5f;
+        if (all(greaterThan(shadowCoords.xy, texelSize)) && all(lessThan(shadowCoords.xy, 1.0 - texelSize)) && shadowCoords.z < 1.0)
+            cascade = i;
+    }
+
+    // beyond the last cascade nothing is shadowed
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(GlobalShadowMap, 0);
-    for(int x = -1; x <= 1; ++x)
+    if (cascade >= 0)
     {
-        for(int y = -1; y <= 1; ++y)
+        float geoDepth = shadowCoords.z;
+        // bias based on incidence angle
+        float bias = max(0.0003 * (1.0 - diffuse), 0.00035);
+
+        // simple PCF with 3x3 kernel for now
+        for(int x = -1; x <= 1; ++x)
         {
-            float d = texture(GlobalShadowMap, shadowCoords.xy + vec2(x, y) * texelSize).r; 
-            shadow += geoDepth - bias > d ? 1.0 : 0.0;        
-        }    
+            for(int y = -1; y <= 1; ++y)
+            {
+                float d = texture(GlobalShadowMap, vec3(shadowCoords.xy + vec2(x, y) * texelSize, cascade)).r;
+                shadow += geoDepth - bias > d ? 1.0 : 0.0;
+            }
+        }
+        shadow /= 9.0;
     }
-    shadow /= 9.0;
 
     float shadowFactor = 1.0f - shadow;
     return shadowFactor * (GlobalLightColor * diffuse * diffuseColor.rgb);
 }
 
+vec3 CalculatePointLight(uint lightIndex, vec3 N, vec3 P)
+{
+    vec3 LightPos = pointLightPositionsBuffer.data[lightIndex].xyz;
+    vec3 LightColor = pointLightColorsBuffer.data[lightIndex].rgb;
+    float LightRadius = pointLightRadiiBuffer.data[lightIndex];
+
+    vec3 L = LightPos - P;
+
+    float lightDistance = length(L);
+    float x = lightDistance / LightRadius;
+    float attenuation = -0.05 + 1.05/(1+23.0f*x*x);
+    vec3 radiance = LightColor.rgb * max(attenuation, 0.0);
+
+    float diffuse = max(dot(normalize(L), N), 0.0);
+
+    return diffuse * radiance;
+}
+
 vec3 CalcNormal(in vec4 tangent, in vec3 binormal, in vec3 normal, in vec3 bumpData)
 {
     mat3 tangentViewMatrix = mat3(tangent.xyz, binormal.xyz, normal.xyz);
@@ -73,14 +119,13 @@ const vec3 AmbientLight = vec3(0.15f);
 
 void main()
 {
-	// Determine which tile this fragment belongs to
 	ivec2 location = ivec2(gl_FragCoord.xy);
-	ivec2 tileID = location / ivec2(TILE_SIZE, TILE_SIZE);
-	uint index = tileID.y * NumTiles.x + tileID.x;
 
     vec4 baseColor = texture(BaseColorTexture, in_TexCoords).rgba * BaseColorFactor;
     baseColor = pow(baseColor, vec4(1.0f/2.2f));
-    vec3 normal = texture(NormalTexture, in_TexCoords).xyz;
+    // only xy is stored, normal maps are two channel BC5 when compressed
+    vec2 normalXY = texture(NormalTexture, in_TexCoords).xy * 2.0f - 1.0f;
+    vec3 normal = vec3(normalXY, sqrt(max(1.0f - dot(normalXY, normalXY), 0.0f))) * 0.5f + 0.5f;
 	vec2 metallicRoughness = texture(MetallicRoughnessTexture, in_TexCoords).xy;
 	vec3 emissive = texture(EmissiveTexture, in_TexCoords).xyz;
 	vec3 occlusion = texture(OcclusionTexture, in_TexCoords).xyz;
@@ -93,24 +138,29 @@ void main()
 
     light += CalculateGlobalLight(V, N, in_WorldSpacePos, baseColor);
 
-    uint offset = index * MaxTileLights;
-    for (uint i = 0; i < MaxTileLights && visiblePointLightIndicesBuffer.data[offset + i].index != -1; i++)
-	{
-        uint lightIndex = visiblePointLightIndicesBuffer.data[offset + i].index;
-		vec3 LightPos = pointLightPositionsBuffer.data[lightIndex].xyz;
-        vec3 LightColor = pointLightColorsBuffer.data[lightIndex].rgb;
-        float LightRadius = pointLightRadiiBuffer.data[lightIndex];
-        
-        vec3 L = LightPos - in_WorldSpacePos;
-
-        float lightDistance = length(L);
-        float x = lightDistance / LightRadius;
-        float attenuation = -0.05 + 1.05/(1+23.0f*x*x);
-        vec3 radiance = LightColor.rgb * max(attenuation, 0.0);
-        
-        float diffuse = max(dot(normalize(L), N), 0.0);
-        
-        light += diffuse * radiance;
+    if (LightClusterCount.z > 0)
+    {
+        // Determine which cluster this fragment belongs to
+        float viewDepth = LightClusterSlicing.z / (gl_FragCoord.z + LightClusterSlicing.w);
+        uint slice = uint(clamp(log(viewDepth) * LightClusterSlicing.x + LightClusterSlicing.y, 0.0, float(LightClusterCount.z - 1)));
+        uvec2 tile = min(uvec2(location) / CLUSTER_TILE_SIZE, LightClusterCount.xy - 1);
+        uvec2 cluster = lightClustersBuffer.data[(slice * LightClusterCount.y + tile.y) * LightClusterCount.x + tile.x];
+        for (uint i = 0; i < cluster.y; i++)
+        {
+            light += CalculatePointLight(lightClusterIndicesBuffer.data[cluster.x + i], N, in_WorldSpacePos);
+        }
+    }
+    else
+    {
+        // Determine which tile this fragment belongs to
+        ivec2 tileID = location / ivec2(TILE_SIZE, TILE_SIZE);
+        uint index = tileID.y * NumTiles.x + tileID.x;
+
+        uint offset = index * MaxTileLights;
+        for (uint i = 0; i < MaxTileLights && visiblePointLightIndicesBuffer.data[offset + i].index != -1; i++)
+        {
+            light += CalculatePointLight(visiblePointLightIndicesBuffer.data[offset + i].index, N, in_WorldSpacePos);
+        }
     }
 
     out_Color = vec4(light.rgb * baseColor.rgb + emissive, 1.0f);
@@ -1,4 +1,6 @@
 #define TILE_SIZE 32
+// Must be same as CPU side ClusterTileSize
+#define CLUSTER_TILE_SIZE 64
 
 struct VisibleIndex 
 {
@@ -20,8 +22,13 @@ layout(std430, binding = 2) readonly buffer PointLightRadiiBuffer
 	float data[];
 } pointLightRadiiBuffer;
 
-layout(location=16) uniform sampler2D GlobalShadowMap;
-layout(location=17) uniform mat4 GlobalShadowMatrix;
+// Must be same as CPU side MaxShadowCascades
+#define MAX_SHADOW_CASCADES 4
+
+// one layer per cascade, ordered from near to far
+layout(location=16) uniform sampler2DArray GlobalShadowMap;
+uniform mat4 GlobalShadowMatrices[MAX_SHADOW_CASCADES];
+uniform int NumShadowCascades;
 layout(location=18) uniform vec3 GlobalLightDirection;
 layout(location=19) uniform vec3 GlobalLightColor;
 
@@ -11,12 +11,20 @@ layout(location=2) out vec4 out_Tangent;
 layout(location=3) out vec2 out_TexCoords;
 
 uniform mat4 ViewProjection;
-uniform mat4 Model;
+
+// base instance + instance id, see GeometryArena::InstanceIndexSlot
+layout(location=9) in uint in_InstanceIndex;
+
+layout(std430, binding = 5) readonly buffer InstanceTransformsBuffer
+{
+	mat4 InstanceTransforms[];
+};
 
 invariant gl_Position;
 
 void main()
 {
+	mat4 Model = InstanceTransforms[in_InstanceIndex];
 	vec4 wPos = (Model * vec4(in_Position, 1.0f));
 	out_WorldSpacePos = wPos.xyz;
 	out_TexCoords = in_TexCoord_0;
@@ -5,12 +5,20 @@ layout(location=3) in vec2 in_TexCoord_0;
 layout(location=3) out vec2 out_TexCoords;
 
 uniform mat4 ViewProjection;
-uniform mat4 Model;
+
+// base instance + instance id, see GeometryArena::InstanceIndexSlot
+layout(location=9) in uint in_InstanceIndex;
+
+layout(std430, binding = 5) readonly buffer InstanceTransformsBuffer
+{
+	mat4 InstanceTransforms[];
+};
 
 invariant gl_Position;
 
 void main()
 {
+	mat4 Model = InstanceTransforms[in_InstanceIndex];
 	out_TexCoords = in_TexCoord_0;
 	// BUG: this must be calculated EXACTLY the same way as in our vs_static shader, otherwise, we get zbuffer fighting since the write to gl_Position is not invariant.
 	// 	    check out https://stackoverflow.com/a/46920273
@@ -86,7 +86,7 @@ namespace Util
         this->freeIds.push(i.index);
 #if _DEBUG
         // if you get this warning, you might want to consider reserving more bits for the generation.
-        if (this->generations[i.index] <= 0x3FF) printf("WARNING: Id generation overflow!");
+        if (this->generations[i.index] >= 0x3FF) printf("WARNING: Id generation overflow!");
 #endif
         this->generations[i.index]++;
 
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+//  jobsystem.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "jobsystem.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+
+struct Job
+{
+    std::function<void()> func;
+    JobCounter* counter;
+};
+
+struct JobSystem
+{
+    ~JobSystem() { JobSystemShutdown(); }
+
+    std::vector<std::thread> workers;
+    std::deque<Job> queue;
+    std::mutex mutex;
+    /// signalled when a job is queued or the workers should stop
+    std::condition_variable jobAvailable;
+    /// signalled when a counter reaches zero
+    std::condition_variable jobsDone;
+    bool stopping = false;
+};
+
+static JobSystem jobSystem;
+
+//------------------------------------------------------------------------------
+/**
+    Runs a job taken from the queue, the lock is held on entry and on return.
+*/
+static void
+RunJob(Job job, std::unique_lock<std::mutex>& lock)
+{
+    lock.unlock();
+    job.func();
+    lock.lock();
+    // decrement under the lock, so a waiter can't miss the wakeup between its check and its wait
+    if (job.counter != nullptr && --job.counter->pending == 0)
+        jobSystem.jobsDone.notify_all();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(jobSystem.mutex);
+    while (true)
+    {
+        jobSystem.jobAvailable.wait(lock, [] { return jobSystem.stopping || !jobSystem.queue.empty(); });
+        if (jobSystem.queue.empty())
+            return; // stopping, and everything queued has been run
+
+        Job job = std::move(jobSystem.queue.front());
+        jobSystem.queue.pop_front();
+        RunJob(std::move(job), lock);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JobSystemInit(uint numWorkers)
+{
+    std::lock_guard<std::mutex> lock(jobSystem.mutex);
+    if (!jobSystem.workers.empty())
+        return;
+
+    if (numWorkers == 0)
+    {
+        uint const hardwareThreads = std::thread::hardware_concurrency();
+        numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    jobSystem.stopping = false;
+    for (uint i = 0; i < numWorkers; i++)
+        jobSystem.workers.emplace_back(WorkerLoop);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JobSystemShutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        jobSystem.stopping = true;
+    }
+    jobSystem.jobAvailable.notify_all();
+    for (std::thread& worker : jobSystem.workers)
+        worker.join();
+    jobSystem.workers.clear();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint
+JobSystemNumWorkers()
+{
+    std::lock_guard<std::mutex> lock(jobSystem.mutex);
+    return (uint)jobSystem.workers.size();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ScheduleJob(std::function<void()> job, JobCounter* counter)
+{
+    JobSystemInit();
+    if (counter != nullptr)
+        counter->pending++;
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        jobSystem.queue.push_back({ std::move(job), counter });
+    }
+    jobSystem.jobAvailable.notify_one();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+WaitForJobs(JobCounter& counter)
+{
+    std::unique_lock<std::mutex> lock(jobSystem.mutex);
+    while (counter.pending > 0)
+    {
+        if (!jobSystem.queue.empty())
+        {
+            Job job = std::move(jobSystem.queue.front());
+            jobSystem.queue.pop_front();
+            RunJob(std::move(job), lock);
+        }
+        else
+        {
+            jobSystem.jobsDone.wait(lock, [&counter] { return counter.pending == 0 || !jobSystem.queue.empty(); });
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ParallelFor(uint count, std::function<void(uint)> const& func)
+{
+    if (count == 0)
+        return;
+
+    JobCounter counter;
+    for (uint i = 1; i < count; i++)
+        ScheduleJob([&func, i] { func(i); }, &counter);
+    func(0);
+    WaitForJobs(counter);
+}
+
+} // namespace Core
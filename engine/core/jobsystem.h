@@ -0,0 +1,46 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file jobsystem.h
+
+    A pool of worker threads running queued jobs.
+
+    Jobs must not touch the GL context, leave uploads to the thread that owns it.
+    The pool is started on first use with one worker less than the number of
+    hardware threads, since the waiting thread runs jobs as well.
+
+    @copyright
+    (C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <atomic>
+#include <functional>
+
+namespace Core
+{
+
+/// Number of jobs not yet finished. Jobs scheduled with a counter increment it and decrement it when done.
+struct JobCounter
+{
+    std::atomic<uint32_t> pending{ 0 };
+};
+
+/// Start the worker threads, zero picks a count from the hardware. Does nothing if already started.
+void JobSystemInit(uint numWorkers = 0);
+
+/// Finish all queued jobs and join the worker threads.
+void JobSystemShutdown();
+
+/// Number of worker threads, not counting threads that wait for jobs.
+uint JobSystemNumWorkers();
+
+/// Queue a job on the worker threads.
+void ScheduleJob(std::function<void()> job, JobCounter* counter = nullptr);
+
+/// Block until all jobs of the counter are done, running queued jobs on this thread in the meantime.
+void WaitForJobs(JobCounter& counter);
+
+/// Run func(i) for every i in [0, count) spread over the workers and the calling thread, returns when all are done.
+void ParallelFor(uint count, std::function<void(uint)> const& func);
+
+} // namespace Core
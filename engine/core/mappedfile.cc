@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------
+//  mappedfile.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "mappedfile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <utility>
+
+namespace Core
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+MappedFile::~MappedFile()
+{
+    this->Close();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+MappedFile::MappedFile(MappedFile&& rhs) noexcept
+{
+    *this = std::move(rhs);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+MappedFile&
+MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        this->Close();
+        std::swap(this->data, rhs.data);
+        std::swap(this->size, rhs.size);
+#ifdef _WIN32
+        std::swap(this->file, rhs.file);
+        std::swap(this->mapping, rhs.mapping);
+#endif
+    }
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+MappedFile::Open(const std::string& path)
+{
+    this->Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    this->file = file;
+    this->mapping = mapping;
+    this->data = view;
+    this->size = (size_t)fileSize.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping keeps its own reference to the file
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    this->data = view;
+    this->size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+MappedFile::Close()
+{
+    if (this->data == nullptr)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(this->data);
+    CloseHandle(this->mapping);
+    CloseHandle(this->file);
+    this->file = nullptr;
+    this->mapping = nullptr;
+#else
+    munmap(this->data, this->size);
+#endif
+    this->data = nullptr;
+    this->size = 0;
+}
+
+} // namespace Core
@@ -0,0 +1,48 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file mappedfile.h
+
+    @class Core::MappedFile
+
+    Read only memory mapping of a whole file. Several processes mapping the same
+    file share the same physical pages.
+
+    @copyright
+    (C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <string>
+
+namespace Core
+{
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    void operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& rhs) noexcept;
+    MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+    /// map the file at path, returns false if it does not exist or can't be mapped
+    bool Open(const std::string& path);
+    /// unmap the file, pointers into it become invalid
+    void Close();
+
+    bool IsOpen() const { return this->data != nullptr; }
+    const void* GetData() const { return this->data; }
+    size_t GetSize() const { return this->size; }
+
+private:
+    void* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+} // namespace Core
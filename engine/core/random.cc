@@ -13,25 +13,43 @@ union RandomUnion
     float f;
 };
 
+//------------------------------------------------------------------------------
+/**
+*/
+RandomState
+SeedRandom(uint seed)
+{
+    RandomState state;
+    // xorshift128 must never have an all zero state
+    state.x = seed != 0 ? seed : RandomState().x;
+    return state;
+}
+
 //------------------------------------------------------------------------------
 /**
     XorShift128 implementation.
 */
 uint
+FastRandom(RandomState& state)
+{
+    uint t;
+    t = state.x ^ (state.x << 11);
+    state.x = state.y;
+    state.y = state.z;
+    state.z = state.w;
+    return state.w = state.w ^ (state.w >> 19) ^ (t ^ (t >> 8));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint
 FastRandom()
 {
     // These are predefined to give us the largest
     // possible sequence of random numbers
-    static uint x = 123456789;
-    static uint y = 362436069;
-    static uint z = 521288629;
-    static uint w = 88675123;
-    uint t;
-    t = x ^ (x << 11);
-    x = y;
-    y = z;
-    z = w;
-    return w = w ^ (w >> 19) ^ (t ^ (t >> 8));
+    static RandomState state;
+    return FastRandom(state);
 }
 
 //------------------------------------------------------------------------------
@@ -57,4 +75,26 @@ RandomFloatNTP()
     return r.f - 3.0f;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+float
+RandomFloat(RandomState& state)
+{
+    RandomUnion r;
+    r.i = FastRandom(state) & 0x007fffff | 0x3f800000;
+    return r.f - 1.0f;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+float
+RandomFloatNTP(RandomState& state)
+{
+    RandomUnion r;
+    r.i = FastRandom(state) & 0x007fffff | 0x40000000;
+    return r.f - 3.0f;
+}
+
 } // namespace Core
@@ -13,9 +13,24 @@
 namespace Core
 {
 
+/// State of an xorshift128 generator. Use this when a sequence must be reproducible from a seed.
+struct RandomState
+{
+    uint x = 123456789;
+    uint y = 362436069;
+    uint z = 521288629;
+    uint w = 88675123;
+};
+
+/// Creates a generator state from a seed. The default seed gives the same sequence as the global generator.
+RandomState SeedRandom(uint seed);
+
 /// Produces an xorshift128 pseudo random number.
 uint FastRandom();
 
+/// Produces an xorshift128 pseudo random number from the given state.
+uint FastRandom(RandomState& state);
+
 /// Produces an xorshift128 psuedo based floating point random number in range 0..1
 /// Note that this is not a truely random random number generator
 float RandomFloat();
@@ -24,4 +39,10 @@ float RandomFloat();
 /// Note that this is not a truely random random number generator
 float RandomFloatNTP();
 
+/// Produces a floating point random number in range 0..1 from the given state.
+float RandomFloat(RandomState& state);
+
+/// Produces a floating point random number in range -1..1 from the given state.
+float RandomFloatNTP(RandomState& state);
+
 } // namespace Core
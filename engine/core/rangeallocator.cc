@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------
+//  rangeallocator.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "rangeallocator.h"
+
+namespace Util
+{
+    //------------------------------------------------------------------------------
+    /**
+    */
+    RangeAllocator::RangeAllocator(uint32_t capacity) :
+        capacity(capacity)
+    {
+        if (capacity > 0)
+            this->freeRanges.emplace(0, capacity);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    uint32_t
+    RangeAllocator::Allocate(uint32_t size)
+    {
+        if (size == 0)
+            return InvalidOffset;
+
+        auto best = this->freeRanges.end();
+        for (auto it = this->freeRanges.begin(); it != this->freeRanges.end(); it++)
+        {
+            if (it->second >= size && (best == this->freeRanges.end() || it->second < best->second))
+            {
+                best = it;
+                if (best->second == size)
+                    break;
+            }
+        }
+        if (best == this->freeRanges.end())
+            return InvalidOffset;
+
+        uint32_t const offset = best->first;
+        uint32_t const remaining = best->second - size;
+        this->freeRanges.erase(best);
+        if (remaining > 0)
+            this->freeRanges.emplace(offset + size, remaining);
+
+        this->used += size;
+        return offset;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void
+    RangeAllocator::Free(uint32_t offset, uint32_t size)
+    {
+        if (size == 0)
+            return;
+        assert(offset + size <= this->capacity);
+        assert(this->used >= size);
+        this->used -= size;
+        this->AddFreeRange(offset, size);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void
+    RangeAllocator::Grow(uint32_t newCapacity)
+    {
+        assert(newCapacity >= this->capacity);
+        if (newCapacity == this->capacity)
+            return;
+        uint32_t const oldCapacity = this->capacity;
+        this->capacity = newCapacity;
+        this->AddFreeRange(oldCapacity, newCapacity - oldCapacity);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    uint32_t
+    RangeAllocator::GetLargestFreeRange() const
+    {
+        uint32_t largest = 0;
+        for (auto const& range : this->freeRanges)
+            largest = range.second > largest ? range.second : largest;
+        return largest;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Inserts a free range and merges it with the ranges directly before and after it.
+    */
+    void
+    RangeAllocator::AddFreeRange(uint32_t offset, uint32_t size)
+    {
+        auto next = this->freeRanges.lower_bound(offset);
+        // must not overlap any free range, that would be a double free
+        assert(next == this->freeRanges.end() || offset + size <= next->first);
+
+        if (next != this->freeRanges.begin())
+        {
+            auto prev = std::prev(next);
+            assert(prev->first + prev->second <= offset);
+            if (prev->first + prev->second == offset)
+            {
+                offset = prev->first;
+                size += prev->second;
+                this->freeRanges.erase(prev);
+            }
+        }
+
+        if (next != this->freeRanges.end() && offset + size == next->first)
+        {
+            size += next->second;
+            this->freeRanges.erase(next);
+        }
+
+        this->freeRanges.emplace(offset, size);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file rangeallocator.h
+
+    @copyright
+    (C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <map>
+
+namespace Util
+{
+    //------------------------------------------------------------------------------
+    /**
+        Hands out ranges of a linear resource, such as elements of a GPU buffer.
+        Only does the bookkeeping, so it can be used for any kind of memory.
+        Free ranges are kept sorted by offset and merged with their neighbours when freed,
+        allocations take the smallest free range they fit in.
+    */
+    class RangeAllocator
+    {
+    public:
+        static constexpr uint32_t InvalidOffset = UINT32_MAX;
+
+        explicit RangeAllocator(uint32_t capacity = 0);
+
+        /// returns the offset of a free range of size elements, or InvalidOffset if none is large enough
+        uint32_t Allocate(uint32_t size);
+        /// return a range handed out by Allocate
+        void Free(uint32_t offset, uint32_t size);
+        /// make the resource larger, existing allocations stay where they are
+        void Grow(uint32_t newCapacity);
+
+        uint32_t GetCapacity() const { return this->capacity; }
+        uint32_t GetUsed() const { return this->used; }
+        size_t GetNumFreeRanges() const { return this->freeRanges.size(); }
+        uint32_t GetLargestFreeRange() const;
+
+    private:
+        void AddFreeRange(uint32_t offset, uint32_t size);
+
+        /// offset -> size
+        std::map<uint32_t, uint32_t> freeRanges;
+        uint32_t capacity;
+        uint32_t used = 0;
+    };
+}
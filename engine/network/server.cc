@@ -5,11 +5,13 @@
 
 namespace Net {
     bool
-    Server::Create(const uint16 port) {
+    Server::Create(const uint16 port, const uint32 maxPeers, const uint32 incomingBandwidth,
+                   const uint32 outgoingBandwidth) {
         m_Address.host = ENET_HOST_ANY;
         m_Address.port = port;
 
-        m_Server = enet_host_create(&m_Address, 32, 1, 0, 0);
+        m_Server = enet_host_create(&m_Address, std::min<uint32>(maxPeers, ENET_PROTOCOL_MAXIMUM_PEER_ID), 1,
+                                    incomingBandwidth, outgoingBandwidth);
         if (!m_Server) {
             std::cout << "Failed to create ENet server host.\n";
             return false;
@@ -64,12 +66,20 @@ namespace Net {
 
     void
     Server::BroadCast(const uint8 *data, const size_t size) const {
+        if (!m_Active) {
+            return;
+        }
+
         ENetPacket *packet = enet_packet_create(data, size, ENET_PACKET_FLAG_RELIABLE);
         enet_host_broadcast(m_Server, 0, packet);
     }
 
     void
     Server::Send(ENetPeer *peer, const uint8 *data, const size_t size) const {
+        if (!m_Active) {
+            return;
+        }
+
         ENetPacket *packet = enet_packet_create(data, size, ENET_PACKET_FLAG_RELIABLE);
         enet_peer_send(peer, 0, packet);
     }
@@ -13,7 +13,8 @@ namespace Net {
 
         ~Server();
 
-        bool Create(uint16 port);
+        // Bandwidth limits are in bytes per second for the whole host, 0 means unlimited.
+        bool Create(uint16 port, uint32 maxPeers = 32, uint32 incomingBandwidth = 0, uint32 outgoingBandwidth = 0);
 
         void Poll(uint32 timeout = 0) const;
 
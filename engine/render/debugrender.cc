@@ -54,7 +54,7 @@ struct TextCommand
 
 static std::queue<RenderCommand*> cmds;
 static std::queue<TextCommand> textcmds;
-static GLuint shaders[NUM_DEBUG_SHAPES];
+static Render::ShaderProgramId shaders[NUM_DEBUG_SHAPES];
 static GLuint vao[NUM_DEBUG_SHAPES];
 static GLuint ib[NUM_DEBUG_SHAPES];
 static GLuint vbo[NUM_DEBUG_SHAPES];
@@ -126,12 +126,12 @@ void SetupShaders()
 	Render::ShaderResourceId const vsDebug = Render::ShaderResource::LoadShader(Render::ShaderResource::ShaderType::VERTEXSHADER, "shd/debug.vs");
 	Render::ShaderResourceId const psDebug = Render::ShaderResource::LoadShader(Render::ShaderResource::ShaderType::FRAGMENTSHADER, "shd/debug.fs");
 	Render::ShaderProgramId const progDebug = Render::ShaderResource::CompileShaderProgram({ vsDebug, psDebug });
-	shaders[DebugShape::BOX] = Render::ShaderResource::GetProgramHandle(progDebug);
+	shaders[DebugShape::BOX] = progDebug;
 
 	Render::ShaderResourceId const vsLine = Render::ShaderResource::LoadShader(Render::ShaderResource::ShaderType::VERTEXSHADER, "shd/debug_lines.vs");
 	Render::ShaderResourceId const psLine = Render::ShaderResource::LoadShader(Render::ShaderResource::ShaderType::FRAGMENTSHADER, "shd/debug_lines.fs");
 	Render::ShaderProgramId const progLine = Render::ShaderResource::CompileShaderProgram({ vsLine, psLine });
-	shaders[DebugShape::LINE] = Render::ShaderResource::GetProgramHandle(progLine);
+	shaders[DebugShape::LINE] = progLine;
 }
 
 void SetupLine()
@@ -231,7 +231,7 @@ void RenderLine(RenderCommand* command)
 {
 	LineCommand* lineCommand = (LineCommand*)command;
 
-	glUseProgram(shaders[DebugShape::LINE]);
+	glUseProgram(Render::ShaderResource::GetProgramHandle(shaders[DebugShape::LINE]));
 
 	if ((lineCommand->rendermode & RenderMode::AlwaysOnTop) == RenderMode::AlwaysOnTop)
 	{
@@ -245,20 +245,16 @@ void RenderLine(RenderCommand* command)
 	glBindVertexArray(vao[DebugShape::LINE]);
 
 	// This is so dumb, yet so much fun
-	static GLuint v0pos = glGetUniformLocation(shaders[DebugShape::LINE], "v0pos");
-	static GLuint v1pos = glGetUniformLocation(shaders[DebugShape::LINE], "v1pos");
-	static GLuint v0color = glGetUniformLocation(shaders[DebugShape::LINE], "v0color");
-	static GLuint v1color = glGetUniformLocation(shaders[DebugShape::LINE], "v1color");
-	static GLuint viewProjection = glGetUniformLocation(shaders[DebugShape::LINE], "viewProjection");
+	Render::ShaderProgramId const program = shaders[DebugShape::LINE];
 
 	// Upload uniforms for positions and colors
-	glUniform4fv(v0pos, 1, &lineCommand->startpoint[0]);
-	glUniform4fv(v1pos, 1, &lineCommand->endpoint[0]);
-	glUniform4fv(v0color, 1, &lineCommand->startcolor[0]);
-	glUniform4fv(v1color, 1, &lineCommand->endcolor[0]);
+	Render::ShaderResource::SetUniform(program, "v0pos", glm::vec4(lineCommand->startpoint, 1.0f));
+	Render::ShaderResource::SetUniform(program, "v1pos", glm::vec4(lineCommand->endpoint, 1.0f));
+	Render::ShaderResource::SetUniform(program, "v0color", lineCommand->startcolor);
+	Render::ShaderResource::SetUniform(program, "v1color", lineCommand->endcolor);
 
 	Render::Camera* const mainCamera = Render::CameraManager::GetCamera(CAMERA_MAIN);
-	glUniformMatrix4fv(viewProjection, 1, GL_FALSE, &mainCamera->viewProjection[0][0]);
+	Render::ShaderResource::SetUniform(program, "viewProjection", mainCamera->viewProjection);
 
 	glDrawArrays(GL_LINES, 0, 2);
 
@@ -278,18 +274,16 @@ void RenderBox(RenderCommand* command)
 {
 	BoxCommand* cmd = (BoxCommand*)command;
 
-	glUseProgram(shaders[DebugShape::BOX]);
+	glUseProgram(Render::ShaderResource::GetProgramHandle(shaders[DebugShape::BOX]));
 
 	glBindVertexArray(vao[DebugShape::BOX]);
 
-	GLuint loc = glGetUniformLocation(shaders[DebugShape::BOX], "color");
-	glUniform4fv(loc, 1, &cmd->color.x);
+	Render::ShaderProgramId const program = shaders[DebugShape::BOX];
+	Render::ShaderResource::SetUniform(program, "color", cmd->color);
 
-	static GLuint model = glGetUniformLocation(shaders[DebugShape::BOX], "model");
-	static GLuint viewProjection = glGetUniformLocation(shaders[DebugShape::BOX], "viewProjection");
 	Render::Camera* const mainCamera = Render::CameraManager::GetCamera(CAMERA_MAIN);
-	glUniformMatrix4fv(model, 1, GL_FALSE, &cmd->transform[0][0]);
-	glUniformMatrix4fv(viewProjection, 1, GL_FALSE, &mainCamera->viewProjection[0][0]);
+	Render::ShaderResource::SetUniform(program, "model", cmd->transform);
+	Render::ShaderResource::SetUniform(program, "viewProjection", mainCamera->viewProjection);
 
 	if ((cmd->rendermode & RenderMode::AlwaysOnTop) == RenderMode::AlwaysOnTop)
 	{
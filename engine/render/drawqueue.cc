@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+//  drawqueue.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "drawqueue.h"
+#include <cassert>
+
+namespace Render
+{
+
+static constexpr uint32_t IndexBits = 20;
+static constexpr uint64_t IndexMask = (1ull << IndexBits) - 1;
+static constexpr uint32_t KeyShift = 28;
+static constexpr uint32_t RadixBits = 12;
+static constexpr uint32_t RadixSize = 1 << RadixBits;
+static constexpr uint32_t NumDigits = (64 - KeyShift) / RadixBits;
+
+//------------------------------------------------------------------------------
+/**
+	The item index is packed into the unused low bits of the key so that only eight bytes move
+	per item and pass, the items are gathered once at the end. The sort is LSD over the 36 used
+	key bits in three 12 bit digits. All histograms are built in one read, and digits that are
+	the same for every item are skipped, which usually is the queue and program.
+*/
+void
+SortDrawItems(std::vector<DrawItem>& items, DrawSortScratch& scratch)
+{
+	size_t const count = items.size();
+	if (count < 2)
+		return;
+	assert(count <= MaxDrawItems);
+
+	scratch.keys[0].resize(count);
+	scratch.keys[1].resize(count);
+	uint64_t* src = scratch.keys[0].data();
+	uint64_t* dst = scratch.keys[1].data();
+
+	scratch.histograms.assign(NumDigits * RadixSize, 0);
+	uint32_t* histograms = scratch.histograms.data();
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t const key = (items[i].key & ~IndexMask) | i;
+		src[i] = key;
+		for (uint32_t digit = 0; digit < NumDigits; digit++)
+			histograms[digit * RadixSize + ((key >> (KeyShift + digit * RadixBits)) & (RadixSize - 1))]++;
+	}
+
+	for (uint32_t digit = 0; digit < NumDigits; digit++)
+	{
+		uint32_t* histogram = histograms + digit * RadixSize;
+		uint32_t const shift = KeyShift + digit * RadixBits;
+		if (histogram[(src[0] >> shift) & (RadixSize - 1)] == count)
+			continue; // every item has the same digit
+
+		// counts to start offsets
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < RadixSize; i++)
+		{
+			uint32_t const n = histogram[i];
+			histogram[i] = offset;
+			offset += n;
+		}
+
+		for (size_t i = 0; i < count; i++)
+			dst[histogram[(src[i] >> shift) & (RadixSize - 1)]++] = src[i];
+		std::swap(src, dst);
+	}
+
+	scratch.items.resize(count);
+	for (size_t i = 0; i < count; i++)
+		scratch.items[i] = items[src[i] & IndexMask];
+	items.swap(scratch.items);
+}
+
+} // namespace Render
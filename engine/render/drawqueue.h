@@ -0,0 +1,87 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file drawqueue.h
+
+	Sort keys for the frame's draws. Items are sorted once per frame by a 64 bit key
+	so that draws sharing state end up next to each other, and the passes only change
+	state when the key changes.
+
+	Key layout, most significant first:
+		63..62  queue, opaque before alpha masked
+		61..56  shader program
+		55..40  material
+		39..28  view depth, front to back
+		27..0   free, the sort packs the item index in here
+
+	The geometry arena gives every model the same vertex array, so it has no field.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <vector>
+
+namespace Render
+{
+
+enum class DrawQueue : uint8_t
+{
+	Opaque,
+	Mask,
+	NumQueues
+};
+
+/// one primitive of one instance batch
+struct DrawItem
+{
+	uint64_t key;
+	uint32_t batch;
+	uint16_t mesh;
+	uint16_t primitive;
+};
+
+//------------------------------------------------------------------------------
+/**
+	depth is the view space distance divided by the far plane, values outside 0..1 are clamped
+*/
+inline uint64_t
+MakeDrawKey(DrawQueue queue, uint32_t program, uint32_t material, float depth)
+{
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	uint64_t const quantizedDepth = (uint64_t)(depth * 4095.0f);
+	return ((uint64_t)queue << 62)
+		| ((uint64_t)(program & 0x3F) << 56)
+		| ((uint64_t)(material & 0xFFFF) << 40)
+		| (quantizedDepth << 28);
+}
+
+inline DrawQueue GetDrawKeyQueue(uint64_t key) { return (DrawQueue)(key >> 62); }
+inline uint32_t GetDrawKeyProgram(uint64_t key) { return (uint32_t)(key >> 56) & 0x3F; }
+inline uint32_t GetDrawKeyMaterial(uint64_t key) { return (uint32_t)(key >> 40) & 0xFFFF; }
+
+/// layout of GL's DrawElementsIndirectCommand
+struct DrawIndirectCommand
+{
+	uint32_t count;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t baseInstance;
+};
+
+/// at most this many items can be sorted, the index has to fit in the free key bits
+constexpr size_t MaxDrawItems = 1 << 20;
+
+/// scratch memory for SortDrawItems, kept between frames so that sorting does not allocate
+struct DrawSortScratch
+{
+	std::vector<uint64_t> keys[2];
+	std::vector<DrawItem> items;
+	std::vector<uint32_t> histograms;
+};
+
+/// stable radix sort on the keys
+void SortDrawItems(std::vector<DrawItem>& items, DrawSortScratch& scratch);
+
+} // namespace Render
@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------
+//  frustumcull.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "frustumcull.h"
+
+namespace Render
+{
+
+//------------------------------------------------------------------------------
+/**
+	Gribb and Hartmann, the planes are rows of the matrix added to or subtracted from the w row.
+*/
+Frustum
+ExtractFrustum(glm::mat4 const& viewProjection)
+{
+	glm::mat4 const m = glm::transpose(viewProjection);
+	Frustum frustum;
+	frustum.planes[0] = m[3] + m[0]; // left
+	frustum.planes[1] = m[3] - m[0]; // right
+	frustum.planes[2] = m[3] + m[1]; // bottom
+	frustum.planes[3] = m[3] - m[1]; // top
+	frustum.planes[4] = m[3] + m[2]; // near
+	frustum.planes[5] = m[3] - m[2]; // far
+
+	// normalize so that plane distances are in world units and can be compared to radii
+	for (glm::vec4& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+	return frustum;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BoundingSpheres::Clear()
+{
+	this->x.clear();
+	this->y.clear();
+	this->z.clear();
+	this->radius.clear();
+	this->count = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Padding spheres have a negative radius, which no plane accepts.
+*/
+void
+BoundingSpheres::Add(glm::vec3 const& center, float r)
+{
+	if ((this->count & 3) == 0)
+	{
+		this->x.resize(this->count + 4, 0.0f);
+		this->y.resize(this->count + 4, 0.0f);
+		this->z.resize(this->count + 4, 0.0f);
+		this->radius.resize(this->count + 4, -FLT_MAX);
+	}
+	this->x[this->count] = center.x;
+	this->y[this->count] = center.y;
+	this->z[this->count] = center.z;
+	this->radius[this->count] = r;
+	this->count++;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BoundingSpheres::Resize(size_t count)
+{
+	size_t const padded = (count + 3) & ~(size_t)3;
+	this->x.resize(padded);
+	this->y.resize(padded);
+	this->z.resize(padded);
+	this->radius.resize(padded);
+	for (size_t i = count; i < padded; i++)
+		this->radius[i] = -FLT_MAX;
+	this->count = count;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BoundingSpheres::Set(size_t i, glm::vec3 const& center, float r)
+{
+	this->x[i] = center.x;
+	this->y[i] = center.y;
+	this->z[i] = center.z;
+	this->radius[i] = r;
+}
+
+//------------------------------------------------------------------------------
+/**
+	A sphere is culled when it is entirely behind any plane. This is conservative near the
+	frustum corners, where a sphere can be outside while not being fully behind one plane.
+*/
+void
+CullSpheres(Frustum const& frustum, BoundingSpheres const& spheres, std::vector<uint32_t>& visible)
+{
+	visible.clear();
+
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+
+	float const* const xs = spheres.x.data();
+	float const* const ys = spheres.y.data();
+	float const* const zs = spheres.z.data();
+	float const* const rs = spheres.radius.data();
+	for (size_t i = 0; i < spheres.count; i += 4)
+	{
+		__m128 const x = _mm_loadu_ps(xs + i);
+		__m128 const y = _mm_loadu_ps(ys + i);
+		__m128 const z = _mm_loadu_ps(zs + i);
+		__m128 const negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(rs + i));
+
+		__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[0], x), _mm_mul_ps(planeY[0], y)), _mm_add_ps(_mm_mul_ps(planeZ[0], z), planeW[0])), negativeRadius);
+		for (int p = 1; p < 6; p++)
+		{
+			__m128 const distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		int const mask = _mm_movemask_ps(inside);
+		if (mask == 0)
+			continue;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (mask & (1 << lane))
+				visible.push_back((uint32_t)(i + lane));
+		}
+	}
+}
+
+} // namespace Render
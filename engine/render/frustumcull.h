@@ -0,0 +1,46 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file frustumcull.h
+
+	Bounding sphere versus frustum culling on the cpu. The spheres are kept in
+	structure of arrays layout so that four of them are tested per instruction.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <vector>
+
+namespace Render
+{
+
+/// planes point inwards, a point p is inside a plane if dot(plane.xyz, p) + plane.w >= 0
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+/// planes of a perspective or orthographic view projection matrix with GL clip space depth
+Frustum ExtractFrustum(glm::mat4 const& viewProjection);
+
+/// world space bounding spheres, every array is padded to a multiple of four
+struct BoundingSpheres
+{
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> radius;
+	size_t count = 0;
+
+	void Clear();
+	void Add(glm::vec3 const& center, float r);
+	/// resize to count spheres, set them with Set, which is safe to call from several threads for different spheres
+	void Resize(size_t count);
+	void Set(size_t i, glm::vec3 const& center, float r);
+};
+
+/// clears visible and fills it with the indices of all spheres intersecting the frustum, in ascending order
+void CullSpheres(Frustum const& frustum, BoundingSpheres const& spheres, std::vector<uint32_t>& visible);
+
+} // namespace Render
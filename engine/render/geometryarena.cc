@@ -0,0 +1,234 @@
+//------------------------------------------------------------------------------
+//  geometryarena.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "geometryarena.h"
+#include "core/rangeallocator.h"
+#include <cstddef>
+#include <vector>
+
+namespace Render
+{
+
+namespace GeometryArena
+{
+
+static constexpr uint32_t InitialVertexCapacity = 1 << 18;
+static constexpr uint32_t InitialIndexCapacity = 1 << 20;
+static constexpr uint32_t InitialInstanceCapacity = 1 << 10;
+
+static GLuint vertexArray = 0;
+static GLuint vertexBuffer = 0;
+static GLuint indexBuffer = 0;
+/// holds 0, 1, 2... read with a divisor of one, so the attribute becomes base instance + instance id
+static GLuint instanceIndexBuffer = 0;
+static uint32_t instanceCapacity = 0;
+static Util::RangeAllocator vertexRanges;
+static Util::RangeAllocator indexRanges;
+
+//------------------------------------------------------------------------------
+/**
+	Replaces the buffer with one of the new size and copies the old contents over.
+*/
+static GLuint
+ResizeBuffer(GLuint buffer, GLsizeiptr oldSize, GLsizeiptr newSize)
+{
+	GLuint newBuffer;
+	glCreateBuffers(1, &newBuffer);
+	glNamedBufferData(newBuffer, newSize, nullptr, GL_STATIC_DRAW);
+	if (buffer != 0)
+	{
+		if (oldSize > 0)
+			glCopyNamedBufferSubData(buffer, newBuffer, 0, 0, oldSize);
+		glDeleteBuffers(1, &buffer);
+	}
+	return newBuffer;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+GrowVertices(uint32_t minCapacity)
+{
+	uint32_t const oldCapacity = vertexRanges.GetCapacity();
+	uint32_t newCapacity = oldCapacity > 0 ? oldCapacity : InitialVertexCapacity;
+	while (newCapacity < minCapacity)
+		newCapacity *= 2;
+
+	vertexBuffer = ResizeBuffer(vertexBuffer, oldCapacity * sizeof(Vertex), newCapacity * sizeof(Vertex));
+	vertexRanges.Grow(newCapacity);
+	glVertexArrayVertexBuffer(vertexArray, 0, vertexBuffer, 0, sizeof(Vertex));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+GrowIndices(uint32_t minCapacity)
+{
+	uint32_t const oldCapacity = indexRanges.GetCapacity();
+	uint32_t newCapacity = oldCapacity > 0 ? oldCapacity : InitialIndexCapacity;
+	while (newCapacity < minCapacity)
+		newCapacity *= 2;
+
+	indexBuffer = ResizeBuffer(indexBuffer, oldCapacity * sizeof(uint32_t), newCapacity * sizeof(uint32_t));
+	indexRanges.Grow(newCapacity);
+	glVertexArrayElementBuffer(vertexArray, indexBuffer);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Create()
+{
+	glCreateVertexArrays(1, &vertexArray);
+
+	struct { GLuint slot; GLint components; GLuint offset; } const attributes[] = {
+		{ 0, 3, offsetof(Vertex, position) },
+		{ 1, 3, offsetof(Vertex, normal) },
+		{ 2, 4, offsetof(Vertex, tangent) },
+		{ 3, 2, offsetof(Vertex, texCoord) }
+	};
+	for (auto const& attribute : attributes)
+	{
+		glEnableVertexArrayAttrib(vertexArray, attribute.slot);
+		glVertexArrayAttribFormat(vertexArray, attribute.slot, attribute.components, GL_FLOAT, GL_FALSE, attribute.offset);
+		glVertexArrayAttribBinding(vertexArray, attribute.slot, 0);
+	}
+
+	glEnableVertexArrayAttrib(vertexArray, InstanceIndexSlot);
+	glVertexArrayAttribIFormat(vertexArray, InstanceIndexSlot, 1, GL_UNSIGNED_INT, 0);
+	glVertexArrayAttribBinding(vertexArray, InstanceIndexSlot, 1);
+	glVertexArrayBindingDivisor(vertexArray, 1, 1);
+
+	GrowVertices(InitialVertexCapacity);
+	GrowIndices(InitialIndexCapacity);
+	ReserveInstances(InitialInstanceCapacity);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Destroy()
+{
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	glDeleteBuffers(1, &instanceIndexBuffer);
+	vertexArray = vertexBuffer = indexBuffer = instanceIndexBuffer = 0;
+	instanceCapacity = 0;
+	vertexRanges = Util::RangeAllocator();
+	indexRanges = Util::RangeAllocator();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Allocation
+Allocate(uint32_t numVertices, uint32_t numIndices)
+{
+	Allocation allocation;
+	allocation.numVertices = numVertices;
+	allocation.numIndices = numIndices;
+
+	if (numVertices > 0)
+	{
+		allocation.baseVertex = vertexRanges.Allocate(numVertices);
+		if (allocation.baseVertex == Util::RangeAllocator::InvalidOffset)
+		{
+			GrowVertices(vertexRanges.GetCapacity() + numVertices);
+			allocation.baseVertex = vertexRanges.Allocate(numVertices);
+		}
+	}
+
+	if (numIndices > 0)
+	{
+		allocation.firstIndex = indexRanges.Allocate(numIndices);
+		if (allocation.firstIndex == Util::RangeAllocator::InvalidOffset)
+		{
+			GrowIndices(indexRanges.GetCapacity() + numIndices);
+			allocation.firstIndex = indexRanges.Allocate(numIndices);
+		}
+	}
+
+	return allocation;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Free(Allocation const& allocation)
+{
+	vertexRanges.Free(allocation.baseVertex, allocation.numVertices);
+	indexRanges.Free(allocation.firstIndex, allocation.numIndices);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Upload(Allocation const& allocation, Vertex const* vertices, uint32_t const* indices)
+{
+	if (allocation.numVertices > 0)
+		glNamedBufferSubData(vertexBuffer, allocation.baseVertex * sizeof(Vertex), allocation.numVertices * sizeof(Vertex), vertices);
+	if (allocation.numIndices > 0)
+		glNamedBufferSubData(indexBuffer, allocation.firstIndex * sizeof(uint32_t), allocation.numIndices * sizeof(uint32_t), indices);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ReserveInstances(uint32_t count)
+{
+	if (count <= instanceCapacity)
+		return;
+
+	uint32_t newCapacity = instanceCapacity > 0 ? instanceCapacity : InitialInstanceCapacity;
+	while (newCapacity < count)
+		newCapacity *= 2;
+
+	std::vector<uint32_t> indices(newCapacity);
+	for (uint32_t i = 0; i < newCapacity; i++)
+		indices[i] = i;
+
+	glDeleteBuffers(1, &instanceIndexBuffer);
+	glCreateBuffers(1, &instanceIndexBuffer);
+	glNamedBufferData(instanceIndexBuffer, newCapacity * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+	glVertexArrayVertexBuffer(vertexArray, 1, instanceIndexBuffer, 0, sizeof(uint32_t));
+	instanceCapacity = newCapacity;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+GLuint
+GetVertexArray()
+{
+	return vertexArray;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+GLuint
+GetVertexBuffer()
+{
+	return vertexBuffer;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+GLuint
+GetIndexBuffer()
+{
+	return indexBuffer;
+}
+
+} // namespace GeometryArena
+} // namespace Render
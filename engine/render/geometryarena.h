@@ -0,0 +1,60 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file geometryarena.h
+
+	All static geometry lives in one vertex buffer and one index buffer with a shared
+	vertex format, so a single vertex array object serves every model. Primitives are
+	drawn with their base vertex and first index into the shared buffers, and instanced
+	draws with their base instance to find their per instance data.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "GL/glew.h"
+
+namespace Render
+{
+
+namespace GeometryArena
+{
+	/// the shared vertex format, attribute slots match the static shaders
+	struct Vertex
+	{
+		glm::vec3 position;		// slot 0
+		glm::vec3 normal;		// slot 1
+		glm::vec4 tangent;		// slot 2
+		glm::vec2 texCoord;		// slot 3
+	};
+
+	/// per instance attribute holding base instance + instance id, for indexing per instance data in shaders
+	static constexpr GLuint InstanceIndexSlot = 9;
+
+	struct Allocation
+	{
+		uint32_t baseVertex = 0;
+		uint32_t numVertices = 0;
+		uint32_t firstIndex = 0;
+		uint32_t numIndices = 0;
+	};
+
+	void Create();
+	void Destroy();
+
+	/// reserve room for vertices and 32 bit indices, the buffers grow when full
+	Allocation Allocate(uint32_t numVertices, uint32_t numIndices);
+	void Free(Allocation const& allocation);
+
+	/// copy data into an allocation, indices are relative to the allocation's base vertex
+	void Upload(Allocation const& allocation, Vertex const* vertices, uint32_t const* indices);
+
+	/// make sure instance indices up to count can be drawn, see InstanceIndexSlot
+	void ReserveInstances(uint32_t count);
+
+	GLuint GetVertexArray();
+	GLuint GetVertexBuffer();
+	GLuint GetIndexBuffer();
+
+} // namespace GeometryArena
+} // namespace Render
@@ -0,0 +1,42 @@
+//------------------------------------------------------------------------------
+//  instancebatch.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "instancebatch.h"
+#include <algorithm>
+
+namespace Render
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BuildInstanceBatches(std::vector<DrawCommand> const& commands, std::vector<InstanceBatch>& batches, std::vector<glm::mat4>& transforms)
+{
+	batches.clear();
+	transforms.clear();
+	if (commands.empty())
+		return;
+
+	// sort indices instead of the commands, they are a lot smaller
+	static thread_local std::vector<uint32_t> order;
+	order.resize(commands.size());
+	for (uint32_t i = 0; i < (uint32_t)commands.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&commands](uint32_t a, uint32_t b) {
+		return commands[a].modelId < commands[b].modelId;
+	});
+
+	transforms.reserve(commands.size());
+	for (uint32_t index : order)
+	{
+		DrawCommand const& cmd = commands[index];
+		if (batches.empty() || batches.back().modelId != cmd.modelId)
+			batches.push_back({ cmd.modelId, (uint32_t)transforms.size(), 0 });
+		batches.back().numInstances++;
+		transforms.push_back(cmd.transform);
+	}
+}
+
+} // namespace Render
@@ -0,0 +1,36 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file instancebatch.h
+
+	Groups draw commands of the same model into instanced draws. Only does the
+	bookkeeping on the cpu, the render device uploads and draws the result.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "resourceid.h"
+#include <vector>
+
+namespace Render
+{
+
+struct DrawCommand
+{
+	ModelId modelId;
+	glm::mat4 transform;
+};
+
+/// instances [firstInstance, firstInstance + numInstances) of the transform list all use the same model
+struct InstanceBatch
+{
+	ModelId modelId;
+	uint32_t firstInstance;
+	uint32_t numInstances;
+};
+
+/// clears and fills batches and transforms, commands of the same model keep their submission order
+void BuildInstanceBatches(std::vector<DrawCommand> const& commands, std::vector<InstanceBatch>& batches, std::vector<glm::mat4>& transforms);
+
+} // namespace Render
@@ -0,0 +1,273 @@
+//------------------------------------------------------------------------------
+//  lightclusters.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "lightclusters.h"
+#include "core/jobsystem.h"
+
+namespace Render
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResizeLightClusters(LightClusters& clusters, uint width, uint height)
+{
+	clusters.resolution = glm::uvec2(width, height);
+	clusters.dimensions = glm::uvec3((width + ClusterTileSize - 1) / ClusterTileSize, (height + ClusterTileSize - 1) / ClusterTileSize, ClusterDepthSlices);
+	clusters.clusters.assign((size_t)clusters.dimensions.x * clusters.dimensions.y * clusters.dimensions.z, glm::uvec2(0));
+	clusters.sliceIndices.resize(ClusterDepthSlices);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Squared distance from v to the interval [lo, hi].
+*/
+static inline float
+IntervalDistanceSquared(float v, float lo, float hi)
+{
+	float const d = glm::max(glm::max(lo - v, v - hi), 0.0f);
+	return d * d;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Conservative cluster ranges of four lights at a time. The sphere's view space box is projected
+	with the box's near and far depth, which bounds the projection of every point in it since x / d
+	is monotonic in d.
+*/
+static void
+ComputeLightBounds(LightClusters& clusters, glm::mat4 const& view, glm::mat4 const& projection, float nearPlane, float farPlane, glm::vec4 const* positions, float const* radii, size_t begin, size_t end)
+{
+	__m128 const v0x = _mm_set1_ps(view[0][0]), v1x = _mm_set1_ps(view[1][0]), v2x = _mm_set1_ps(view[2][0]), v3x = _mm_set1_ps(view[3][0]);
+	__m128 const v0y = _mm_set1_ps(view[0][1]), v1y = _mm_set1_ps(view[1][1]), v2y = _mm_set1_ps(view[2][1]), v3y = _mm_set1_ps(view[3][1]);
+	__m128 const v0z = _mm_set1_ps(-view[0][2]), v1z = _mm_set1_ps(-view[1][2]), v2z = _mm_set1_ps(-view[2][2]), v3z = _mm_set1_ps(-view[3][2]);
+	__m128 const scaleX = _mm_set1_ps(projection[0][0]);
+	__m128 const scaleY = _mm_set1_ps(projection[1][1]);
+	__m128 const nearV = _mm_set1_ps(nearPlane);
+	__m128 const farV = _mm_set1_ps(farPlane);
+	__m128 const one = _mm_set1_ps(1.0f);
+	__m128 const minusOne = _mm_set1_ps(-1.0f);
+	// ndc to tile coordinates
+	__m128 const tilesX = _mm_set1_ps((float)clusters.resolution.x / (2.0f * ClusterTileSize));
+	__m128 const tilesY = _mm_set1_ps((float)clusters.resolution.y / (2.0f * ClusterTileSize));
+	__m128 const lastX = _mm_set1_ps((float)(clusters.dimensions.x - 1));
+	__m128 const lastY = _mm_set1_ps((float)(clusters.dimensions.y - 1));
+	float const lastSlice = (float)(clusters.dimensions.z - 1);
+
+	for (size_t i = begin; i < end; i += 4)
+	{
+		// the tail is padded with lights that have no radius, which are never visible
+		glm::vec4 tailPositions[4] = {};
+		float tailRadii[4] = {};
+		glm::vec4 const* p = positions + i;
+		float const* r = radii + i;
+		size_t const lanes = glm::min<size_t>(4, end - i);
+		if (lanes < 4)
+		{
+			for (size_t lane = 0; lane < lanes; lane++)
+			{
+				tailPositions[lane] = p[lane];
+				tailRadii[lane] = r[lane];
+			}
+			p = tailPositions;
+			r = tailRadii;
+		}
+
+		__m128 px = _mm_loadu_ps(&p[0].x);
+		__m128 py = _mm_loadu_ps(&p[1].x);
+		__m128 pz = _mm_loadu_ps(&p[2].x);
+		__m128 pw = _mm_loadu_ps(&p[3].x);
+		_MM_TRANSPOSE4_PS(px, py, pz, pw);
+		__m128 const radius = _mm_loadu_ps(r);
+
+		__m128 const x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v0x, px), _mm_mul_ps(v1x, py)), _mm_add_ps(_mm_mul_ps(v2x, pz), v3x));
+		__m128 const y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v0y, px), _mm_mul_ps(v1y, py)), _mm_add_ps(_mm_mul_ps(v2y, pz), v3y));
+		__m128 const depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v0z, px), _mm_mul_ps(v1z, py)), _mm_add_ps(_mm_mul_ps(v2z, pz), v3z));
+
+		__m128 const depthMin = _mm_max_ps(_mm_sub_ps(depth, radius), nearV);
+		__m128 const depthMax = _mm_min_ps(_mm_add_ps(depth, radius), farV);
+		__m128 const invDepthMin = _mm_div_ps(one, depthMin);
+		__m128 const invDepthMax = _mm_div_ps(one, depthMax);
+
+		__m128 const left = _mm_sub_ps(x, radius);
+		__m128 const right = _mm_add_ps(x, radius);
+		__m128 const bottom = _mm_sub_ps(y, radius);
+		__m128 const top = _mm_add_ps(y, radius);
+		__m128 const ndcLeft = _mm_mul_ps(scaleX, _mm_min_ps(_mm_mul_ps(left, invDepthMin), _mm_mul_ps(left, invDepthMax)));
+		__m128 const ndcRight = _mm_mul_ps(scaleX, _mm_max_ps(_mm_mul_ps(right, invDepthMin), _mm_mul_ps(right, invDepthMax)));
+		__m128 const ndcBottom = _mm_mul_ps(scaleY, _mm_min_ps(_mm_mul_ps(bottom, invDepthMin), _mm_mul_ps(bottom, invDepthMax)));
+		__m128 const ndcTop = _mm_mul_ps(scaleY, _mm_max_ps(_mm_mul_ps(top, invDepthMin), _mm_mul_ps(top, invDepthMax)));
+
+		__m128 visible = _mm_cmpgt_ps(radius, _mm_setzero_ps());
+		visible = _mm_and_ps(visible, _mm_cmplt_ps(depthMin, depthMax));
+		visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpge_ps(ndcRight, minusOne), _mm_cmple_ps(ndcLeft, one)));
+		visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpge_ps(ndcTop, minusOne), _mm_cmple_ps(ndcBottom, one)));
+		int const visibleMask = _mm_movemask_ps(visible);
+
+		// tiles are clamped to the grid, the lights that reach outside of it are still visible
+		__m128 const zero = _mm_setzero_ps();
+		__m128i const tileLeft = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(ndcLeft, tilesX), tilesX), zero), lastX));
+		__m128i const tileRight = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(ndcRight, tilesX), tilesX), zero), lastX));
+		__m128i const tileBottom = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(ndcBottom, tilesY), tilesY), zero), lastY));
+		__m128i const tileTop = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(ndcTop, tilesY), tilesY), zero), lastY));
+
+		alignas(16) int32_t tiles[4][4];
+		alignas(16) float lanesOut[6][4];
+		_mm_store_si128((__m128i*)tiles[0], tileLeft);
+		_mm_store_si128((__m128i*)tiles[1], tileRight);
+		_mm_store_si128((__m128i*)tiles[2], tileBottom);
+		_mm_store_si128((__m128i*)tiles[3], tileTop);
+		_mm_store_ps(lanesOut[0], x);
+		_mm_store_ps(lanesOut[1], y);
+		_mm_store_ps(lanesOut[2], depth);
+		_mm_store_ps(lanesOut[3], radius);
+		_mm_store_ps(lanesOut[4], depthMin);
+		_mm_store_ps(lanesOut[5], depthMax);
+
+		for (size_t lane = 0; lane < lanes; lane++)
+		{
+			LightClusters::LightBounds& bounds = clusters.bounds[i + lane];
+			if ((visibleMask & (1 << lane)) == 0)
+			{
+				// empty depth range, no slice picks this light up
+				bounds.min[2] = 1;
+				bounds.max[2] = 0;
+				continue;
+			}
+			float const sliceMin = glm::log(lanesOut[4][lane]) * clusters.depthSlicing.x + clusters.depthSlicing.y;
+			float const sliceMax = glm::log(lanesOut[5][lane]) * clusters.depthSlicing.x + clusters.depthSlicing.y;
+			bounds.min[0] = (uint16_t)tiles[0][lane];
+			bounds.max[0] = (uint16_t)tiles[1][lane];
+			bounds.min[1] = (uint16_t)tiles[2][lane];
+			bounds.max[1] = (uint16_t)tiles[3][lane];
+			bounds.min[2] = (uint16_t)glm::clamp(sliceMin, 0.0f, lastSlice);
+			bounds.max[2] = (uint16_t)glm::clamp(sliceMax, 0.0f, lastSlice);
+			bounds.viewSphere = glm::vec4(lanesOut[0][lane], lanesOut[1][lane], lanesOut[2][lane], lanesOut[3][lane]);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Fills the lists of one depth slice. Every light in range is tested against the view space box
+	of each cluster, the box is separable so the distance is summed per axis.
+*/
+static void
+AssignSlice(LightClusters& clusters, glm::mat4 const& projection, uint slice)
+{
+	glm::uvec3 const dims = clusters.dimensions;
+	float const sliceNear = glm::exp((float(slice) - clusters.depthSlicing.y) / clusters.depthSlicing.x);
+	float const sliceFar = glm::exp((float(slice + 1) - clusters.depthSlicing.y) / clusters.depthSlicing.x);
+
+	// view space x and y extents of every column and row over the slice's depth range
+	std::vector<glm::vec2> columns(dims.x);
+	std::vector<glm::vec2> rows(dims.y);
+	for (uint tx = 0; tx < dims.x; tx++)
+	{
+		float const ndcMin = float(tx * ClusterTileSize) / float(clusters.resolution.x) * 2.0f - 1.0f;
+		float const ndcMax = glm::min(float((tx + 1) * ClusterTileSize) / float(clusters.resolution.x) * 2.0f - 1.0f, 1.0f);
+		columns[tx] = glm::vec2(glm::min(ndcMin * sliceNear, ndcMin * sliceFar), glm::max(ndcMax * sliceNear, ndcMax * sliceFar)) / projection[0][0];
+	}
+	for (uint ty = 0; ty < dims.y; ty++)
+	{
+		float const ndcMin = float(ty * ClusterTileSize) / float(clusters.resolution.y) * 2.0f - 1.0f;
+		float const ndcMax = glm::min(float((ty + 1) * ClusterTileSize) / float(clusters.resolution.y) * 2.0f - 1.0f, 1.0f);
+		rows[ty] = glm::vec2(glm::min(ndcMin * sliceNear, ndcMin * sliceFar), glm::max(ndcMax * sliceNear, ndcMax * sliceFar)) / projection[1][1];
+	}
+
+	glm::uvec2* const sliceClusters = clusters.clusters.data() + (size_t)slice * dims.x * dims.y;
+	for (size_t c = 0; c < (size_t)dims.x * dims.y; c++)
+		sliceClusters[c] = glm::uvec2(0);
+
+	std::vector<uint32_t>& indices = clusters.sliceIndices[slice];
+	indices.clear();
+
+	// the first pass counts, the second writes, so that every cluster's list is contiguous
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (uint32_t light = 0; light < (uint32_t)clusters.bounds.size(); light++)
+		{
+			LightClusters::LightBounds const& bounds = clusters.bounds[light];
+			if (slice < bounds.min[2] || slice > bounds.max[2])
+				continue;
+
+			glm::vec4 const sphere = bounds.viewSphere;
+			float const radiusSquared = sphere.w * sphere.w;
+			float const dz = IntervalDistanceSquared(sphere.z, sliceNear, sliceFar);
+			for (uint ty = bounds.min[1]; ty <= bounds.max[1]; ty++)
+			{
+				float const dyz = dz + IntervalDistanceSquared(sphere.y, rows[ty].x, rows[ty].y);
+				if (dyz > radiusSquared)
+					continue;
+				for (uint tx = bounds.min[0]; tx <= bounds.max[0]; tx++)
+				{
+					if (dyz + IntervalDistanceSquared(sphere.x, columns[tx].x, columns[tx].y) > radiusSquared)
+						continue;
+					glm::uvec2& cluster = sliceClusters[ty * dims.x + tx];
+					if (pass == 0)
+						cluster.y++;
+					else
+						indices[cluster.x + cluster.y++] = light;
+				}
+			}
+		}
+
+		if (pass == 0)
+		{
+			uint32_t offset = 0;
+			for (size_t c = 0; c < (size_t)dims.x * dims.y; c++)
+			{
+				sliceClusters[c].x = offset;
+				offset += sliceClusters[c].y;
+				sliceClusters[c].y = 0;
+			}
+			indices.resize(offset);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Lights are bounded in chunks, then each depth slice is filled by its own job. The slices
+	write disjoint clusters, so only the final concatenation is serial.
+*/
+void
+AssignLightsToClusters(LightClusters& clusters, glm::mat4 const& view, glm::mat4 const& projection, glm::vec4 const* positions, float const* radii, size_t count)
+{
+	assert(clusters.dimensions.z == ClusterDepthSlices);
+
+	// near and far plane of a GL perspective projection
+	float const nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+	float const farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+	clusters.depthSlicing.x = float(clusters.dimensions.z) / glm::log(farPlane / nearPlane);
+	clusters.depthSlicing.y = -glm::log(nearPlane) * clusters.depthSlicing.x;
+
+	static constexpr size_t BoundsChunkSize = 256;
+	clusters.bounds.resize(count);
+	Core::ParallelFor((uint)((count + BoundsChunkSize - 1) / BoundsChunkSize), [&](uint chunk)
+	{
+		size_t const begin = chunk * BoundsChunkSize;
+		size_t const end = glm::min(count, begin + BoundsChunkSize);
+		ComputeLightBounds(clusters, view, projection, nearPlane, farPlane, positions, radii, begin, end);
+	});
+
+	Core::ParallelFor(clusters.dimensions.z, [&](uint slice)
+	{
+		AssignSlice(clusters, projection, slice);
+	});
+
+	size_t const clustersPerSlice = (size_t)clusters.dimensions.x * clusters.dimensions.y;
+	clusters.lightIndices.clear();
+	for (uint slice = 0; slice < clusters.dimensions.z; slice++)
+	{
+		uint32_t const offset = (uint32_t)clusters.lightIndices.size();
+		glm::uvec2* const sliceClusters = clusters.clusters.data() + slice * clustersPerSlice;
+		for (size_t c = 0; c < clustersPerSlice; c++)
+			sliceClusters[c].x += offset;
+		clusters.lightIndices.insert(clusters.lightIndices.end(), clusters.sliceIndices[slice].begin(), clusters.sliceIndices[slice].end());
+	}
+}
+
+} // namespace Render
@@ -0,0 +1,60 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file lightclusters.h
+
+	Clustered light assignment on the cpu. The view frustum is split into
+	screen tiles of ClusterTileSize pixels and ClusterDepthSlices exponential
+	depth slices, and every point light is added to the list of each cluster
+	its sphere touches. Nothing in here touches GL, the lists are uploaded by
+	the LightServer.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <vector>
+
+namespace Render
+{
+
+/// must be the same as CLUSTER_TILE_SIZE in lights.glsl
+constexpr uint ClusterTileSize = 64;
+constexpr uint ClusterDepthSlices = 24;
+
+struct LightClusters
+{
+	/// clusters along x, y and depth
+	glm::uvec3 dimensions = glm::uvec3(0);
+	/// framebuffer size in pixels
+	glm::uvec2 resolution = glm::uvec2(0);
+	/// slice of a view depth d is log(d) * depthSlicing.x + depthSlicing.y
+	glm::vec2 depthSlicing = glm::vec2(0.0f);
+
+	/// first index into lightIndices and number of lights, per cluster, x fastest, then y, then depth
+	std::vector<glm::uvec2> clusters;
+	/// light indices of all clusters, ascending within a cluster
+	std::vector<uint32_t> lightIndices;
+
+	/// per light range of clusters touched by its sphere, and its view space sphere
+	struct LightBounds
+	{
+		uint16_t min[3];
+		uint16_t max[3];
+		glm::vec4 viewSphere;
+	};
+	std::vector<LightBounds> bounds;
+	/// light indices of each depth slice before they are concatenated
+	std::vector<std::vector<uint32_t>> sliceIndices;
+};
+
+/// set the cluster grid for a framebuffer size, call when the resolution changes
+void ResizeLightClusters(LightClusters& clusters, uint width, uint height);
+
+/**
+	Rebuild the light lists. Projection must be a symmetric perspective projection
+	with GL clip space depth. Uses the job system, call from the main thread.
+*/
+void AssignLightsToClusters(LightClusters& clusters, glm::mat4 const& view, glm::mat4 const& projection, glm::vec4 const* positions, float const* radii, size_t count);
+
+} // namespace Render
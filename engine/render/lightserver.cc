@@ -9,6 +9,8 @@
 #include "core/cvar.h"
 #include "core/idpool.h"
 #include "debugrender.h"
+#include "streambuffer.h"
+#include "lightclusters.h"
 #include "core/random.h"
 
 namespace Render
@@ -29,12 +31,36 @@ enum LightType
 	Directional = 8
 };
 
+/// lights per dirty bit, uploads are done in whole blocks
+constexpr uint32_t dirtyBlockSize = 64;
+constexpr uint32_t initialPointLightCapacity = 1024;
+constexpr GLuint numPointLightAttributes = (GLuint)PointLightBuffer::VISIBLE_INDICES;
+
+/**
+	Light attributes are kept packed so that the gpu only ever sees live lights. Ids map to a dense
+	index through denseIndices, destroying a light moves the last light into its slot.
+*/
 struct PointLights
 {
 	std::vector<glm::vec4> positions;
 	std::vector<glm::vec4> colors;
 	std::vector<float> radii;
-	GLuint buffers[4];
+	/// id of the light in every dense slot
+	std::vector<PointLightId> ids;
+	/// dense slot of every id index
+	std::vector<uint32_t> denseIndices;
+
+	/// one buffer per attribute, in PointLightBuffer order
+	GLuint buffers[numPointLightAttributes] = {};
+	uint32_t capacity = 0;
+	/// one bit per block of dirtyBlockSize lights that changed since the last upload, per attribute
+	std::vector<uint64_t> dirtyBlocks[numPointLightAttributes];
+
+	GLuint visibleIndicesBuffer;
+	/// this frame's light lists of the main camera when clustered culling is on
+	LightClusters clusters;
+	StreamBuffer::Range clusterRange;
+	StreamBuffer::Range clusterIndicesRange;
 };
 
 glm::vec3 globalLightDirection;
@@ -50,12 +76,124 @@ constexpr GLuint maxTileProbes = 128;
 static GLuint workGroupsX = 0;
 static GLuint workGroupsY = 0;
 
-static GLuint globalShadowMap;
+static GLuint globalShadowMap = 0;
 static GLuint globalShadowFrameBuffer;
-const unsigned int shadowMapSize = 4096;
+static uint shadowMapSize = 0;
+static uint numShadowCascades = 0;
 
 static Core::CVar* r_draw_light_spheres = nullptr;
 static Core::CVar* r_draw_light_sphere_id = nullptr;
+static Core::CVar* r_light_clusters = nullptr;
+static Core::CVar* r_shadow_cascades = nullptr;
+static Core::CVar* r_shadow_map_size = nullptr;
+static Core::CVar* r_shadow_distance = nullptr;
+
+/// bindings of the cluster buffers, as declared in fs_static.glsl
+constexpr GLuint lightClustersBinding = 6;
+constexpr GLuint lightClusterIndicesBinding = 7;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+MarkDirty(PointLightBuffer attribute, uint32_t denseIndex)
+{
+	uint32_t const block = denseIndex / dirtyBlockSize;
+	pointLights.dirtyBlocks[(GLuint)attribute][block / 64] |= 1ull << (block % 64);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+MarkAllDirty(uint32_t denseIndex)
+{
+	for (GLuint i = 0; i < numPointLightAttributes; i++)
+		MarkDirty((PointLightBuffer)i, denseIndex);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Replaces the attribute buffers with larger ones. The cpu side has every light, so the new
+	buffers are filled by marking everything dirty instead of copying on the gpu.
+*/
+static void
+GrowPointLightBuffers(uint32_t minCapacity)
+{
+	uint32_t newCapacity = pointLights.capacity > 0 ? pointLights.capacity : initialPointLightCapacity;
+	while (newCapacity < minCapacity)
+		newCapacity *= 2;
+
+	GLsizeiptr const elementSizes[numPointLightAttributes] = { sizeof(glm::vec4), sizeof(glm::vec4), sizeof(float) };
+	for (GLuint i = 0; i < numPointLightAttributes; i++)
+	{
+		if (pointLights.buffers[i] != 0)
+			glDeleteBuffers(1, &pointLights.buffers[i]);
+		glCreateBuffers(1, &pointLights.buffers[i]);
+		glNamedBufferStorage(pointLights.buffers[i], newCapacity * elementSizes[i], nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+		uint32_t const numBlocks = (newCapacity + dirtyBlockSize - 1) / dirtyBlockSize;
+		pointLights.dirtyBlocks[i].assign((numBlocks + 63) / 64, ~0ull);
+	}
+	pointLights.capacity = newCapacity;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Uploads the dirty blocks of one attribute, adjacent blocks are merged into one upload.
+*/
+static void
+UploadDirtyBlocks(PointLightBuffer attribute, void const* data, size_t elementSize)
+{
+	std::vector<uint64_t>& dirty = pointLights.dirtyBlocks[(GLuint)attribute];
+	uint32_t const numLights = (uint32_t)pointLights.positions.size();
+	uint32_t const numBlocks = (numLights + dirtyBlockSize - 1) / dirtyBlockSize;
+
+	uint32_t block = 0;
+	while (block < numBlocks)
+	{
+		if ((dirty[block / 64] & (1ull << (block % 64))) == 0)
+		{
+			block++;
+			continue;
+		}
+		uint32_t const first = block;
+		while (block < numBlocks && (dirty[block / 64] & (1ull << (block % 64))) != 0)
+			block++;
+
+		uint32_t const begin = first * dirtyBlockSize;
+		uint32_t const end = glm::min(block * dirtyBlockSize, numLights);
+		glNamedBufferSubData(pointLights.buffers[(GLuint)attribute], begin * elementSize, (end - begin) * elementSize, (char const*)data + begin * elementSize);
+	}
+
+	// blocks past the last light hold no lights, new lights mark their own block
+	std::fill(dirty.begin(), dirty.end(), 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+	(Re)creates the cascade array when the shadow CVars changed.
+*/
+static void
+UpdateShadowMap()
+{
+	uint const size = (uint)glm::clamp(Core::CVarReadInt(r_shadow_map_size), 256, 8192);
+	uint const cascades = (uint)glm::clamp(Core::CVarReadInt(r_shadow_cascades), 1, (int)MaxShadowCascades);
+	if (size == shadowMapSize && cascades == numShadowCascades)
+		return;
+
+	if (globalShadowMap != 0)
+		glDeleteTextures(1, &globalShadowMap);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &globalShadowMap);
+	glTextureStorage3D(globalShadowMap, 1, GL_DEPTH_COMPONENT32F, size, size, cascades);
+	glTextureParameteri(globalShadowMap, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(globalShadowMap, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(globalShadowMap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(globalShadowMap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	shadowMapSize = size;
+	numShadowCascades = cascades;
+}
 
 //------------------------------------------------------------------------------
 /**
@@ -70,23 +208,21 @@ Initialize()
 
 	r_draw_light_spheres = Core::CVarCreate(Core::CVarType::CVar_Int, "r_draw_light_spheres", "0");
 	r_draw_light_sphere_id = Core::CVarCreate(Core::CVarType::CVar_Int, "r_draw_light_sphere_id", "-1");
+	r_light_clusters = Core::CVarCreate(Core::CVarType::CVar_Int, "r_light_clusters", "1", "Assign point lights to depth sliced clusters on the cpu instead of screen tiles on the gpu");
+	r_shadow_cascades = Core::CVarCreate(Core::CVarType::CVar_Int, "r_shadow_cascades", "3", "Number of sun shadow cascades, 1 to 4");
+	r_shadow_map_size = Core::CVarCreate(Core::CVarType::CVar_Int, "r_shadow_map_size", "2048", "Resolution of each sun shadow cascade");
+	r_shadow_distance = Core::CVarCreate(Core::CVarType::CVar_Float, "r_shadow_distance", "200", "View distance covered by the sun shadow cascades");
 
-	glGenBuffers((GLuint)PointLightBuffer::NUM_BUFFERS, pointLights.buffers);
+	glGenBuffers(1, &pointLights.visibleIndicesBuffer);
+	GrowPointLightBuffers(initialPointLightCapacity);
 	
-	// setup shadow pass
-	glGenTextures(1, &globalShadowMap);
-	glBindTexture(GL_TEXTURE_2D, globalShadowMap);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, shadowMapSize, shadowMapSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
+	// setup shadow pass, the cascades are attached one at a time when they are drawn
 	glGenFramebuffers(1, &globalShadowFrameBuffer);
 	glBindFramebuffer(GL_FRAMEBUFFER, globalShadowFrameBuffer);
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, globalShadowMap, 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	UpdateShadowMap();
 
 	// setup a shadow camera
 	Render::CameraCreateInfo shadowCameraInfo;
@@ -113,9 +249,11 @@ UpdateWorkGroups(uint resolutionWidth, uint resolutionHeight)
 	size_t numberOfTiles = workGroupsX * workGroupsY;
 
 	// Bind visible Point light indices buffer
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, pointLights.buffers[(GLuint)PointLightBuffer::VISIBLE_INDICES]);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, pointLights.visibleIndicesBuffer);
 	glBufferData(GL_SHADER_STORAGE_BUFFER, numberOfTiles * sizeof(VisibleIndex) * maxTileLights, 0, GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	ResizeLightClusters(pointLights.clusters, resolutionWidth, resolutionHeight);
 }
 
 //------------------------------------------------------------------------------
@@ -133,30 +271,50 @@ OnBeforeRender()
 	//	glm::vec3(0.0f, 1.0f, 0.0f));
 	//LightServer::globalLightDirection = shadowCamera->view[2];
 
-	static size_t prevNumPointLights = 0;
+	UpdateShadowMap();
+
 	size_t numPointLights = pointLights.positions.size();
+	if (numPointLights > pointLights.capacity)
+		GrowPointLightBuffers((uint32_t)numPointLights);
+
+	UploadDirtyBlocks(PointLightBuffer::POSITIONS, pointLights.positions.data(), sizeof(glm::vec4));
+	UploadDirtyBlocks(PointLightBuffer::COLORS, pointLights.colors.data(), sizeof(glm::vec4));
+	UploadDirtyBlocks(PointLightBuffer::RADII, pointLights.radii.data(), sizeof(float));
+
+	if (UseLightClusters())
+	{
+		Camera const* const mainCamera = CameraManager::GetCamera(CAMERA_MAIN);
+		LightClusters& clusters = pointLights.clusters;
+		AssignLightsToClusters(clusters, mainCamera->view, mainCamera->projection, pointLights.positions.data(), pointLights.radii.data(), numPointLights);
+		pointLights.clusterRange = StreamBuffer::UploadStorage(clusters.clusters.data(), clusters.clusters.size() * sizeof(glm::uvec2));
+		pointLights.clusterIndicesRange = StreamBuffer::UploadStorage(clusters.lightIndices.data(), clusters.lightIndices.size() * sizeof(uint32_t));
+	}
+}
 
-	if (prevNumPointLights != numPointLights)
+//------------------------------------------------------------------------------
+/**
+	Binds every PointLightBuffer to the binding of the same index, as declared in lights.glsl.
+*/
+void
+BindPointLightBuffers()
+{
+	for (GLuint i = 0; i < numPointLightAttributes; i++)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, pointLights.buffers[i]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, (GLuint)PointLightBuffer::VISIBLE_INDICES, pointLights.visibleIndicesBuffer);
+	if (UseLightClusters())
 	{
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, pointLights.buffers[(GLuint)PointLightBuffer::POSITIONS]);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, numPointLights * sizeof(glm::vec4), pointLights.positions.data(), GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, pointLights.buffers[(GLuint)PointLightBuffer::COLORS]);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, numPointLights * sizeof(glm::vec4), pointLights.colors.data(), GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, pointLights.buffers[(GLuint)PointLightBuffer::RADII]);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, numPointLights * sizeof(float), pointLights.radii.data(), GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-
-		prevNumPointLights = numPointLights;
+		StreamBuffer::Bind(GL_SHADER_STORAGE_BUFFER, lightClustersBinding, pointLights.clusterRange);
+		StreamBuffer::Bind(GL_SHADER_STORAGE_BUFFER, lightClusterIndicesBinding, pointLights.clusterIndicesRange);
 	}
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-GLuint GetBuffer(PointLightBuffer buf)
+bool
+UseLightClusters()
 {
-	assert((int)buf < (int)PointLightBuffer::NUM_BUFFERS);
-	return pointLights.buffers[(GLuint)buf];
+	return Core::CVarReadInt(r_light_clusters) != 0;
 }
 
 //------------------------------------------------------------------------------
@@ -181,9 +339,15 @@ GLuint GetWorkGroupsY()
 void
 Update(Render::ShaderProgramId pid)
 {
-	GLuint programHandle = ShaderResource::GetProgramHandle(pid);
-	glUniform3fv(glGetUniformLocation(programHandle, "GlobalLightDirection"), 1, &globalLightDirection[0]);
-	glUniform3fv(glGetUniformLocation(programHandle, "GlobalLightColor"), 1, &globalLightColor[0]);
+	ShaderResource::SetUniform(pid, "GlobalLightDirection", globalLightDirection);
+	ShaderResource::SetUniform(pid, "GlobalLightColor", globalLightColor);
+
+	// a cluster count of zero selects the screen tiles
+	LightClusters const& clusters = pointLights.clusters;
+	Camera const* const mainCamera = CameraManager::GetCamera(CAMERA_MAIN);
+	ShaderResource::SetUniform(pid, "LightClusterCount", UseLightClusters() ? clusters.dimensions : glm::uvec3(0));
+	// slicing in xy, and the terms that turn window depth into view depth in zw
+	ShaderResource::SetUniform(pid, "LightClusterSlicing", glm::vec4(clusters.depthSlicing, 0.5f * mainCamera->projection[3][2], 0.5f * mainCamera->projection[2][2] - 0.5f));
 }
 
 //------------------------------------------------------------------------------
@@ -196,7 +360,7 @@ DebugDrawPointLights()
 	if (Core::CVarReadInt(r_draw_light_spheres) > 0)
 	{
 		Model::Mesh::Primitive const& primitive = GetModel(icoSphereModel).meshes[0].primitives[0];
-		glBindVertexArray(primitive.vao);
+		glBindVertexArray(GeometryArena::GetVertexArray());
 
 		static Render::ShaderResourceId const vs = Render::ShaderResource::LoadShader(Render::ShaderResource::ShaderType::VERTEXSHADER, "shd/debug.vs");
 		static Render::ShaderResourceId const fs = Render::ShaderResource::LoadShader(Render::ShaderResource::ShaderType::FRAGMENTSHADER, "shd/debug.fs");
@@ -205,12 +369,11 @@ DebugDrawPointLights()
 		glUseProgram(debugProgramHandle);
 
 		glm::vec4 color(1, 0, 0, 1);
-		glUniform4fv(glGetUniformLocation(debugProgramHandle, "color"), 1, &color.x);
+		ShaderResource::SetUniform(debugProgram, "color", color);
 
-		static GLuint model = glGetUniformLocation(debugProgramHandle, "model");
-		static GLuint viewProjection = glGetUniformLocation(debugProgramHandle, "viewProjection");
+		GLint const model = ShaderResource::GetUniformLocation(debugProgram, "model");
 		Render::Camera* const mainCamera = Render::CameraManager::GetCamera(CAMERA_MAIN);
-		glUniformMatrix4fv(viewProjection, 1, GL_FALSE, &mainCamera->viewProjection[0][0]);
+		ShaderResource::SetUniform(debugProgram, "viewProjection", mainCamera->viewProjection);
 
 		glDisable(GL_CULL_FACE);
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -221,7 +384,7 @@ DebugDrawPointLights()
 			{
 				glm::mat4 transform = glm::translate(glm::vec3(pointLights.positions[i])) * glm::scale(glm::vec3(pointLights.radii[i]));
 				glUniformMatrix4fv(model, 1, GL_FALSE, &transform[0][0]);
-				glDrawElements(GL_TRIANGLES, primitive.numIndices, primitive.indexType, (void*)(intptr_t)primitive.offset);
+				glDrawElementsBaseVertex(GL_TRIANGLES, primitive.numIndices, GL_UNSIGNED_INT, (void*)(intptr_t)(primitive.firstIndex * sizeof(uint32_t)), primitive.baseVertex);
 			}
 		}
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -249,28 +412,44 @@ CreatePointLight(glm::vec3 position, glm::vec3 color, float intensity, float rad
 {
 	PointLightId id;
 	if (pointLightPool.Allocate(id))
-	{
-		pointLights.positions.push_back(glm::vec4(position, 1));
-		pointLights.colors.push_back(glm::vec4(color, 1) * intensity);
-		pointLights.radii.push_back(radius);
-	}
-	else
-	{
-		pointLights.positions[id.index] = glm::vec4(position, 1);
-		pointLights.colors[id.index] = glm::vec4(color, 1) * intensity;
-		pointLights.radii[id.index] = radius;
-	}
+		pointLights.denseIndices.push_back(0);
+
+	uint32_t const denseIndex = (uint32_t)pointLights.positions.size();
+	pointLights.denseIndices[id.index] = denseIndex;
+	pointLights.ids.push_back(id);
+	pointLights.positions.push_back(glm::vec4(position, 1));
+	pointLights.colors.push_back(glm::vec4(color, 1) * intensity);
+	pointLights.radii.push_back(radius);
+
+	if (denseIndex >= pointLights.capacity)
+		GrowPointLightBuffers(denseIndex + 1);
+	MarkAllDirty(denseIndex);
 	return id;
 }
 
 //------------------------------------------------------------------------------
 /**
+	Moves the last light into the slot of the destroyed one, so only that slot needs an upload.
 */
 void
 DestroyPointLight(PointLightId id)
 {
-	assert(false);
-	// TODO: Need to add a hashtable to be able to remove lights, and still keep them packed.
+	assert(IsValid(id));
+	uint32_t const denseIndex = pointLights.denseIndices[id.index];
+	uint32_t const last = (uint32_t)pointLights.positions.size() - 1;
+	if (denseIndex != last)
+	{
+		pointLights.positions[denseIndex] = pointLights.positions[last];
+		pointLights.colors[denseIndex] = pointLights.colors[last];
+		pointLights.radii[denseIndex] = pointLights.radii[last];
+		pointLights.ids[denseIndex] = pointLights.ids[last];
+		pointLights.denseIndices[pointLights.ids[denseIndex].index] = denseIndex;
+		MarkAllDirty(denseIndex);
+	}
+	pointLights.positions.pop_back();
+	pointLights.colors.pop_back();
+	pointLights.radii.pop_back();
+	pointLights.ids.pop_back();
 	pointLightPool.Deallocate(id);
 }
 
@@ -281,7 +460,9 @@ void
 SetPosition(PointLightId id, glm::vec3 position)
 {
 	assert(IsValid(id));
-	pointLights.positions[id.index] = glm::vec4(position, 1);
+	uint32_t const denseIndex = pointLights.denseIndices[id.index];
+	pointLights.positions[denseIndex] = glm::vec4(position, 1);
+	MarkDirty(PointLightBuffer::POSITIONS, denseIndex);
 }
 
 //------------------------------------------------------------------------------
@@ -291,7 +472,7 @@ glm::vec3
 GetPosition(PointLightId id)
 {
 	assert(IsValid(id));
-	return pointLights.positions[id.index];
+	return pointLights.positions[pointLights.denseIndices[id.index]];
 }
 
 //------------------------------------------------------------------------------
@@ -301,7 +482,9 @@ void
 SetColorAndIntensity(PointLightId id, glm::vec3 color, float intensity)
 {
 	assert(IsValid(id));
-	pointLights.colors[id.index] = glm::vec4(color, 1) * intensity;
+	uint32_t const denseIndex = pointLights.denseIndices[id.index];
+	pointLights.colors[denseIndex] = glm::vec4(color, 1) * intensity;
+	MarkDirty(PointLightBuffer::COLORS, denseIndex);
 }
 
 //------------------------------------------------------------------------------
@@ -311,7 +494,7 @@ glm::vec3
 GetColorAndIntensity(PointLightId id)
 {
 	assert(IsValid(id));
-	return pointLights.colors[id.index];
+	return pointLights.colors[pointLights.denseIndices[id.index]];
 }
 
 //------------------------------------------------------------------------------
@@ -321,7 +504,9 @@ void
 SetRadius(PointLightId id, float radius)
 {
 	assert(IsValid(id));
-	pointLights.radii[id.index] = radius;
+	uint32_t const denseIndex = pointLights.denseIndices[id.index];
+	pointLights.radii[denseIndex] = radius;
+	MarkDirty(PointLightBuffer::RADII, denseIndex);
 }
 
 //------------------------------------------------------------------------------
@@ -331,7 +516,7 @@ float
 GetRadius(PointLightId id)
 {
 	assert(IsValid(id));
-	return pointLights.radii[id.index];
+	return pointLights.radii[pointLights.denseIndices[id.index]];
 }
 
 //------------------------------------------------------------------------------
@@ -369,6 +554,24 @@ GetShadowMapSize()
 {
 	return shadowMapSize;
 }
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint
+GetNumShadowCascades()
+{
+	return numShadowCascades;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+float
+GetShadowDistance()
+{
+	return Core::CVarReadFloat(r_shadow_distance);
+}
 		
 } // namespace LightServer
 } // namespace Render
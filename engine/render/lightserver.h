@@ -10,6 +10,7 @@
 #include "renderdevice.h"
 #include "shaderresource.h"
 #include "lightsources.h"
+#include "shadowcascades.h"
 #include <vector>
 
 #define CAMERA_SHADOW uint('GSHW')
@@ -37,7 +38,10 @@ namespace LightServer
 	void OnBeforeRender();
 	void Update(Render::ShaderProgramId pid);
 
+	/// bind the light data of this frame and the visible light indices, call after OnBeforeRender
 	void BindPointLightBuffers();
+	/// point lights are assigned to clusters on the cpu, otherwise the light culling pass bins them into screen tiles
+	bool UseLightClusters();
 
     void DebugDrawPointLights();
 
@@ -52,16 +56,17 @@ namespace LightServer
     void SetRadius(PointLightId id, float radius);
     float GetRadius(PointLightId id);
 
-	GLuint GetBuffer(PointLightBuffer buf);
-	
 	GLuint GetWorkGroupsX();
 	GLuint GetWorkGroupsY();
 
 	size_t GetNumPointLights();
 
+	/// depth texture array with one layer per shadow cascade
 	GLuint GetGlobalShadowMapHandle();
 	GLuint GetGlobalShadowFramebuffer();
 	uint GetShadowMapSize();
+	uint GetNumShadowCascades();
+	float GetShadowDistance();
 
 };
 } // namespace Render
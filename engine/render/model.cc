@@ -7,70 +7,209 @@
 #include "textureresource.h"
 
 #include "lightserver.h"
+#include "core/jobsystem.h"
 
 namespace Render {
 	static uint nameCounter = 0;
 	static std::vector<Model> modelAllocator;
 	static std::unordered_map<std::string, ModelId> modelRegistry;
+	/// every distinct material of the loaded models, indexed by material id
+	static std::vector<Model::Material> materials;
 
 	//------------------------------------------------------------------------------
 	/**
+		Id of a material equal to the given one, registering it if there is none. Models
+		have few materials, so a linear search at load time is fine.
 	*/
-	int
-	SlotFromGltf(std::string const &attr) {
-		if (attr == "POSITION") return 0;
-		if (attr == "NORMAL") return 1;
-		if (attr == "TANGENT") return 2;
-		if (attr == "TEXCOORD_0") return 3;
-		if (attr == "COLOR_0") return 4;
-		if (attr == "JOINTS_0") return 5;
-		if (attr == "WEIGHTS_0") return 6;
-		if (attr == "TEXCOORD_1") return 7;
-		if (attr == "TEXCOORD_2") return 8;
-
-		n_error("Attribute location not set!\n");
-		return 0;
+	static uint32_t
+	GetMaterialId(Model::Material const &material) {
+		for (size_t i = 0; i < materials.size(); i++) {
+			if (materials[i] == material)
+				return (uint32_t) i;
+		}
+		materials.push_back(material);
+		return (uint32_t) materials.size() - 1;
 	}
 
 	//------------------------------------------------------------------------------
 	/**
+		Reads element i of an accessor as floats, converting normalized integers.
 	*/
-	void
-	InferBufferTargets(fx::gltf::Document &model) {
-		bool infer = false;
-		for (unsigned i = 0; i < model.bufferViews.size(); i++) {
-			bool br = false;
-			auto const &bufferView = model.bufferViews[i];
-			if (bufferView.target == fx::gltf::BufferView::TargetType::None) {
-				infer = true;
+	static void
+	ReadAccessor(fx::gltf::Document const &doc, fx::gltf::Accessor const &accessor, uint32_t i, float *out,
+	             int numComponents) {
+		fx::gltf::BufferView const &view = doc.bufferViews[accessor.bufferView];
+		uint8_t const *data = &doc.buffers[view.buffer].data[view.byteOffset + accessor.byteOffset];
+		int const components = (int) accessor.type;
+
+		switch (accessor.componentType) {
+			case fx::gltf::Accessor::ComponentType::Float: {
+				uint32_t const stride = view.byteStride ? view.byteStride : components * sizeof(float);
+				float const *element = (float const *) (data + i * stride);
+				for (int c = 0; c < numComponents; c++)
+					out[c] = element[c];
+				break;
+			}
+			case fx::gltf::Accessor::ComponentType::UnsignedByte: {
+				uint32_t const stride = view.byteStride ? view.byteStride : components;
+				uint8_t const *element = data + i * stride;
+				for (int c = 0; c < numComponents; c++)
+					out[c] = element[c] / 255.0f;
 				break;
 			}
+			case fx::gltf::Accessor::ComponentType::UnsignedShort: {
+				uint32_t const stride = view.byteStride ? view.byteStride : components * sizeof(uint16_t);
+				uint16_t const *element = (uint16_t const *) (data + i * stride);
+				for (int c = 0; c < numComponents; c++)
+					out[c] = element[c] / 65535.0f;
+				break;
+			}
+			default:
+				n_error("Unsupported vertex attribute component type!\n");
+				break;
 		}
+	}
+
+	//------------------------------------------------------------------------------
+	/**
+		Index i of a primitive, or just i if the primitive is not indexed.
+	*/
+	static uint32_t
+	ReadIndex(fx::gltf::Document const &doc, fx::gltf::Primitive const &primitive, uint32_t i) {
+		if (primitive.indices < 0)
+			return i;
+
+		fx::gltf::Accessor const &accessor = doc.accessors[primitive.indices];
+		fx::gltf::BufferView const &view = doc.bufferViews[accessor.bufferView];
+		uint8_t const *data = &doc.buffers[view.buffer].data[view.byteOffset + accessor.byteOffset];
+		switch (accessor.componentType) {
+			case fx::gltf::Accessor::ComponentType::UnsignedByte:
+				return data[i];
+			case fx::gltf::Accessor::ComponentType::UnsignedShort:
+				return ((uint16_t const *) data)[i];
+			case fx::gltf::Accessor::ComponentType::UnsignedInt:
+				return ((uint32_t const *) data)[i];
+			default:
+				n_error("Unsupported index type!\n");
+				return 0;
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	/**
+		Everything UploadGLTF needs from disk, read and decoded without touching GL.
+	*/
+	struct ModelSource {
+		struct Texture {
+			fx::gltf::Sampler sampler;
+			TextureCooker::Usage usage = TextureCooker::Usage::Color;
+			/// cooked if texture compression is on, decoded if it is off or cooking failed
+			TextureCooker::CookedTexture cooked;
+			DecodedImage image;
+		};
+
+		/// where the primitives are in vertices and indices, in the order of the document
+		struct PrimitiveRange {
+			uint32_t baseVertex;
+			uint32_t firstIndex;
+			uint32_t numIndices;
+		};
+
+		std::string uri;
+		fx::gltf::Document doc;
+		std::vector<Texture> textures;
+		std::vector<GeometryArena::Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<PrimitiveRange> primitives;
+		/// bounds of all positions
+		glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+		glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+		bool valid = false;
+	};
+
+	//------------------------------------------------------------------------------
+	/**
+		Converts all primitives to the shared vertex format, missing attributes get default values.
+	*/
+	static void
+	BuildGeometry(ModelSource &source) {
+		fx::gltf::Document const &doc = source.doc;
+		for (auto const &mesh: doc.meshes) {
+			for (auto const &primitive: mesh.primitives) {
+				ModelSource::PrimitiveRange range;
+				range.baseVertex = (uint32_t) source.vertices.size();
+				range.firstIndex = (uint32_t) source.indices.size();
+
+				auto const position = primitive.attributes.find("POSITION");
+				n_assert(position != primitive.attributes.end());
+				fx::gltf::Accessor const &positionAccessor = doc.accessors[position->second];
+				uint32_t const numVertices = positionAccessor.count;
+
+				GeometryArena::Vertex defaultVertex;
+				defaultVertex.position = glm::vec3(0.0f);
+				defaultVertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+				defaultVertex.tangent = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+				defaultVertex.texCoord = glm::vec2(0.0f);
+				source.vertices.resize(range.baseVertex + numVertices, defaultVertex);
+				GeometryArena::Vertex *vertices = &source.vertices[range.baseVertex];
+
+				for (auto const &attribute: primitive.attributes) {
+					fx::gltf::Accessor const &accessor = doc.accessors[attribute.second];
+					float *target;
+					int components;
+					if (attribute.first == "POSITION") {
+						target = &vertices[0].position.x;
+						components = 3;
+					} else if (attribute.first == "NORMAL") {
+						target = &vertices[0].normal.x;
+						components = 3;
+					} else if (attribute.first == "TANGENT") {
+						target = &vertices[0].tangent.x;
+						components = 4;
+					} else if (attribute.first == "TEXCOORD_0") {
+						target = &vertices[0].texCoord.x;
+						components = 2;
+					} else {
+						continue; // not used by any shader
+					}
+
+					uint32_t const count = std::min(accessor.count, numVertices);
+					for (uint32_t i = 0; i < count; i++) {
+						float *element = (float *) ((uint8_t *) target + i * sizeof(GeometryArena::Vertex));
+						ReadAccessor(doc, accessor, i, element, components);
+					}
+				}
 
-		if (infer) {
-			// TODO: could be better
-			for (auto const &mesh: model.meshes) {
-				for (auto const &primitive: mesh.primitives) {
-					for (auto const &attr: primitive.attributes) {
-						auto const &accessor = model.accessors[attr.second];
-						model.bufferViews[accessor.bufferView].target = (fx::gltf::BufferView::TargetType)
-								GL_ARRAY_BUFFER;
+				// gltf requires min and max on positions, only scan the vertices if an exporter left them out
+				if (positionAccessor.min.size() >= 3 && positionAccessor.max.size() >= 3) {
+					source.boundsMin = glm::min(source.boundsMin, glm::vec3(positionAccessor.min[0], positionAccessor.min[1], positionAccessor.min[2]));
+					source.boundsMax = glm::max(source.boundsMax, glm::vec3(positionAccessor.max[0], positionAccessor.max[1], positionAccessor.max[2]));
+				} else {
+					for (uint32_t i = 0; i < numVertices; i++) {
+						source.boundsMin = glm::min(source.boundsMin, vertices[i].position);
+						source.boundsMax = glm::max(source.boundsMax, vertices[i].position);
 					}
+				}
 
-					auto const &accessor = model.accessors[primitive.indices];
-					model.bufferViews[accessor.bufferView].target = (fx::gltf::BufferView::TargetType)
-							GL_ELEMENT_ARRAY_BUFFER;
+				range.numIndices = primitive.indices >= 0 ? doc.accessors[primitive.indices].count : numVertices;
+				source.indices.reserve(source.indices.size() + range.numIndices);
+				for (uint32_t i = 0; i < range.numIndices; i++) {
+					source.indices.push_back(ReadIndex(doc, primitive, i));
 				}
+
+				source.primitives.push_back(range);
 			}
 		}
 	}
 
 	//------------------------------------------------------------------------------
 	/**
+		Reads the gltf and decodes its images. Safe to run on worker threads.
 	*/
-	Model
-	LoadGLTF(std::string const &uri) {
-		fx::gltf::Document doc;
+	void
+	ParseGLTF(std::string const &uri, ModelSource &source) {
+		source.uri = uri;
+		fx::gltf::Document &doc = source.doc;
 
 		try {
 			if (uri.substr(uri.find_last_of(".") + 1) == "glb")
@@ -80,193 +219,146 @@ namespace Render {
 		} catch (const std::exception &err) {
 			std::cout << err.what() << '\n';
 			assert(false);
-			return Model();
+			return;
 		}
 
-		InferBufferTargets(doc); // fix up buffertargets if necessary
-
-		int numBuffers = 0;
-		//count number of buffers necessary
-		size_t const numBufferViews = doc.bufferViews.size();
-		for (unsigned i = 0; i < numBufferViews; i++) {
-			numBuffers += (doc.bufferViews[i].target != fx::gltf::BufferView::TargetType::None);
-		}
+		BuildGeometry(source);
 
-		std::vector<fx::gltf::Primitive const *> proxyPrimitives;
+		source.textures.resize(doc.textures.size());
 
-		Model model;
-		model.buffers.resize(numBuffers, -1);
-		glGenBuffers(numBuffers, &model.buffers[0]);
-
-		std::vector<int> bufferViewMap(numBufferViews);
-
-		//TODO: We should use less buffers and possibly rebind less often.
-		//		Put everything in one buffer and just use the offsets in the attribute pointers
-
-		unsigned bufferIndex = 0;
-		for (unsigned i = 0; i < numBufferViews; i++) {
-			auto const &bufferView = doc.bufferViews[i];
-			if (bufferView.target != fx::gltf::BufferView::TargetType::None) {
-				GLenum const target = (GLenum) bufferView.target;
-				glBindBuffer(target, model.buffers[bufferIndex]);
-				glBufferData(
-					target,
-					bufferView.byteLength,
-					&(doc.buffers[bufferView.buffer].data[0]) + bufferView.byteOffset,
-					GL_STATIC_DRAW
-				);
-				bufferViewMap[i] = bufferIndex;
-				bufferIndex++;
-			}
+		// Load basecolor textures as sRGB because it's required by GLTF to be in sRGB space
+		for (auto const &material: doc.materials) {
+			int textureIndex = material.pbrMetallicRoughness.baseColorTexture.index;
+			if (textureIndex != -1)
+				source.textures[textureIndex].usage = TextureCooker::Usage::ColorSRGB;
+			if (material.normalTexture.index != -1)
+				source.textures[material.normalTexture.index].usage = TextureCooker::Usage::NormalMap;
 		}
 
-		std::vector<TextureResourceId> textures;
-		textures.resize(doc.textures.size(), InvalidResourceId);
+		bool const cook = TextureResource::UseTextureCompression();
+		auto const load = [cook](ModelSource::Texture &target, void const *data, size_t bytes) {
+			if (!cook || !TextureCooker::Cook(data, bytes, target.usage, TextureCooker::DefaultCacheFolder, target.cooked))
+				target.image = TextureResource::DecodeImage(data, bytes);
+		};
 
-		auto LoadTexture = [&doc, &uri, &textures](int textureIndex, fx::gltf::Texture const &texture,
-		                                           bool sRGB = false) {
+		for (size_t i = 0; i < doc.textures.size(); i++) {
+			fx::gltf::Texture const &texture = doc.textures[i];
+			ModelSource::Texture &target = source.textures[i];
 			fx::gltf::Image const &image = doc.images[texture.source];
-			fx::gltf::Sampler sampler;
 			if (texture.sampler != -1) {
-				sampler = doc.samplers[texture.sampler];
+				target.sampler = doc.samplers[texture.sampler];
 			}
 
 			// set invalid samplers to default values for GL
-			if (sampler.magFilter == fx::gltf::Sampler::MagFilter::None)
-				sampler.magFilter = fx::gltf::Sampler::MagFilter::Linear;
-			if (sampler.minFilter == fx::gltf::Sampler::MinFilter::None)
-				sampler.minFilter = fx::gltf::Sampler::MinFilter::NearestMipMapLinear;
+			if (target.sampler.magFilter == fx::gltf::Sampler::MagFilter::None)
+				target.sampler.magFilter = fx::gltf::Sampler::MagFilter::Linear;
+			if (target.sampler.minFilter == fx::gltf::Sampler::MinFilter::None)
+				target.sampler.minFilter = fx::gltf::Sampler::MinFilter::NearestMipMapLinear;
 
-			std::string name;
-			ImageId id = InvalidResourceId;
 			if (image.IsEmbeddedResource()) {
-				// Make up some random name
-				uint uid = nameCounter++;
-				name = "embedded_image_";
-				name += std::to_string(uid);
 				std::vector<uint8_t> data;
-
 				image.MaterializeData(data);
-
-				TextureLoadInfo texInfo = {
-					.name = name,
-					.buffer = &data[0],
-					.bytes = data.size(),
-					.magFilter = (Render::MagFilter) sampler.magFilter,
-					.minFilter = (Render::MinFilter) sampler.minFilter,
-					.wrappingModeS = (Render::WrappingMode) sampler.wrapS,
-					.wrappingModeT = (Render::WrappingMode) sampler.wrapT,
-					.sRGB = sRGB,
-					.placeholder = TextureResource::GetWhiteTexture()
-				};
-
-				id = TextureResource::LoadTextureFromMemory(texInfo);
+				load(target, data.data(), data.size());
 			} else if (image.uri.empty()) {
-				// this mean the image is in a buffer view, and this needs to be handled as well
+				// this mean the image is in a buffer view
 				fx::gltf::BufferView const &bufferView = doc.bufferViews[image.bufferView];
 				fx::gltf::Buffer const &buffer = doc.buffers[bufferView.buffer];
+				load(target, &buffer.data[bufferView.byteOffset], bufferView.byteLength);
+			} else // external image
+			{
+				// get base path to file
+				std::filesystem::path p(uri);
+				std::string imagePath = p.parent_path().string() + "/" + image.uri;
+				Core::MappedFile file;
+				if (file.Open(imagePath))
+					load(target, file.GetData(), file.GetSize());
+			}
+		}
 
+		source.valid = true;
+	}
+
+	//------------------------------------------------------------------------------
+	/**
+		Creates the GL objects for a parsed gltf, must run on the thread owning the context.
+		The cooked textures are moved out of the source.
+	*/
+	Model
+	UploadGLTF(ModelSource &source) {
+		if (!source.valid)
+			return Model();
+
+		fx::gltf::Document const &doc = source.doc;
+
+		Model model;
+		model.geometry = GeometryArena::Allocate((uint32_t) source.vertices.size(), (uint32_t) source.indices.size());
+		GeometryArena::Upload(model.geometry, source.vertices.data(), source.indices.data());
+		if (!source.vertices.empty()) {
+			model.boundsCenter = (source.boundsMin + source.boundsMax) * 0.5f;
+			model.boundsRadius = glm::length(source.boundsMax - source.boundsMin) * 0.5f;
+		}
+
+		std::vector<TextureResourceId> textures;
+		textures.resize(doc.textures.size(), InvalidResourceId);
+
+		for (size_t i = 0; i < doc.textures.size(); i++) {
+			ModelSource::Texture &texture = source.textures[i];
+			fx::gltf::Image const &image = doc.images[doc.textures[i].source];
+
+			std::string name;
+			if (image.IsEmbeddedResource() || image.uri.empty()) {
 				// Make up some random name
 				uint uid = nameCounter++;
 				name = "embedded_image_";
 				name += std::to_string(uid);
-
-				TextureLoadInfo texInfo = {
-					.name = name,
-					.buffer = (void *) &buffer.data[bufferView.byteOffset],
-					.bytes = bufferView.byteLength,
-					.magFilter = (Render::MagFilter) sampler.magFilter,
-					.minFilter = (Render::MinFilter) sampler.minFilter,
-					.wrappingModeS = (Render::WrappingMode) sampler.wrapS,
-					.wrappingModeT = (Render::WrappingMode) sampler.wrapT,
-					.sRGB = sRGB,
-					.placeholder = TextureResource::GetWhiteTexture()
-				};
-
-				id = TextureResource::LoadTextureFromMemory(texInfo);
-			} else // external image
-			{
+			} else {
 				name = image.uri;
-				id = TextureResource::GetImageId(name);
-				if (id == InvalidImageId) {
-					// get base path to file
-					std::filesystem::path p(uri);
-					std::string imagePath = p.parent_path().string() + "/" + name;
-					id = TextureResource::LoadTexture(
-						imagePath.c_str(),
-						(Render::MagFilter) sampler.magFilter,
-						(Render::MinFilter) sampler.minFilter,
-						(Render::WrappingMode) sampler.wrapS,
-						(Render::WrappingMode) sampler.wrapT,
-						sRGB
-					);
+				ImageId const id = TextureResource::GetImageId(name);
+				if (id != InvalidImageId) {
+					textures[i] = id;
+					continue;
 				}
 			}
 
-			textures[textureIndex] = id;
-		};
-
-		// load all basecolor textures
-		for (auto const &material: doc.materials) {
-			int textureIndex = material.pbrMetallicRoughness.baseColorTexture.index;
-			if (textureIndex != -1) {
-				// Load basecolor texture as sRGB because it's required by GLTF to be in sRGB space
-				LoadTexture(textureIndex, doc.textures[textureIndex], true);
+			if (texture.cooked.IsValid()) {
+				textures[i] = TextureResource::CreateCompressedTexture(
+					name,
+					std::move(texture.cooked),
+					(Render::MagFilter) texture.sampler.magFilter,
+					(Render::MinFilter) texture.sampler.minFilter,
+					(Render::WrappingMode) texture.sampler.wrapS,
+					(Render::WrappingMode) texture.sampler.wrapT
+				);
+				continue;
 			}
-		}
 
-		// load the rest of the textures
-		for (int i = 0; i < doc.textures.size(); i++) {
-			if (textures[i] != InvalidResourceId)
+			if (texture.image.pixels == nullptr) {
+				n_warning("Could not decode image '%s' in '%s'!\n", name.c_str(), source.uri.c_str());
+				textures[i] = TextureResource::GetWhiteTexture();
 				continue;
+			}
 
-			auto const &texture = doc.textures[i];
-			LoadTexture(i, texture);
+			textures[i] = TextureResource::CreateTexture(
+				name,
+				texture.image,
+				(Render::MagFilter) texture.sampler.magFilter,
+				(Render::MinFilter) texture.sampler.minFilter,
+				(Render::WrappingMode) texture.sampler.wrapS,
+				(Render::WrappingMode) texture.sampler.wrapT,
+				texture.usage == TextureCooker::Usage::ColorSRGB
+			);
 		}
 
+		size_t primitiveIndex = 0;
 		for (auto const &mesh: doc.meshes) {
 			Model::Mesh m;
 			for (auto const &primitive: mesh.primitives) {
 				Model::Mesh::Primitive p;
 
-				glGenVertexArrays(1, &p.vao);
-				glBindVertexArray(p.vao);
-				for (auto const &attribute: primitive.attributes) {
-					auto const &accessor = doc.accessors[attribute.second];
-
-					Model::VertexAttribute attr;
-					attr.offset = accessor.byteOffset;
-					attr.stride = doc.bufferViews[accessor.bufferView].byteStride;
-					attr.normalized = accessor.normalized;
-
-					attr.slot = SlotFromGltf(attribute.first);
-					attr.type = (GLenum) accessor.componentType;
-
-					n_assert((int)accessor.type > 0 && (int)accessor.type <= 4);
-					attr.components = (GLint) accessor.type;
-
-					fx::gltf::BufferView const &bufferView = doc.bufferViews[accessor.bufferView];
-					fx::gltf::Buffer const &buffer = doc.buffers[bufferView.buffer];
-					glBindBuffer(
-						(GLenum) doc.bufferViews[accessor.bufferView].target,
-						model.buffers[bufferViewMap[accessor.bufferView]]
-					);
-					glEnableVertexArrayAttrib(p.vao, attr.slot);
-					glVertexAttribPointer(
-						attr.slot,
-						attr.components,
-						attr.type,
-						attr.normalized,
-						attr.stride,
-						(void *) (intptr_t) attr.offset
-					);
-				}
-
-				auto const &ibAccessor = doc.accessors[primitive.indices];
-				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model.buffers[bufferViewMap[ibAccessor.bufferView]]);
-				p.numIndices = ibAccessor.count;
-				p.offset = ibAccessor.byteOffset;
-				p.indexType = (GLenum) ibAccessor.componentType;
+				ModelSource::PrimitiveRange const &range = source.primitives[primitiveIndex++];
+				p.numIndices = range.numIndices;
+				p.firstIndex = model.geometry.firstIndex + range.firstIndex;
+				p.baseVertex = model.geometry.baseVertex + range.baseVertex;
 
 				if (primitive.material != -1) {
 					// TODO: cutout materials
@@ -303,14 +395,13 @@ namespace Render {
 					p.material.alphaMode = (Model::Material::AlphaMode) gltfMaterial.alphaMode;
 					p.material.alphaCutoff = gltfMaterial.alphaCutoff;
 					p.material.doubleSided = gltfMaterial.doubleSided;
+					p.materialId = GetMaterialId(p.material);
 					if (p.material.alphaMode == Model::Material::AlphaMode::Blend)
 						m.blendPrimitives.push_back((uint16_t) m.primitives.size());
 					else
 						m.opaquePrimitives.push_back((uint16_t) m.primitives.size());
 				}
 
-				glBindVertexArray(0);
-
 				m.primitives.push_back(std::move(p));
 			}
 			model.meshes.push_back(std::move(m));
@@ -324,24 +415,56 @@ namespace Render {
 	*/
 	ModelId
 	LoadModel(std::string name) {
-		auto iter = modelRegistry.find(name);
-		if (iter != modelRegistry.end()) {
-			ModelId const mid = (*iter).second;
-			modelAllocator[mid].refcount++; // increment refcount
-			return mid;
+		return LoadModels({ name })[0];
+	}
+
+	//------------------------------------------------------------------------------
+	/**
+		Files are read and images decoded on the job system, the GL objects are then created here in order.
+	*/
+	std::vector<ModelId>
+	LoadModels(std::vector<std::string> const &names) {
+		std::vector<ModelId> ids(names.size(), InvalidResourceId);
+		std::vector<std::string> missing;
+		std::vector<std::string> toLoad;
+		for (size_t i = 0; i < names.size(); i++) {
+			auto iter = modelRegistry.find(names[i]);
+			if (iter != modelRegistry.end()) {
+				ids[i] = (*iter).second;
+				modelAllocator[ids[i]].refcount++; // increment refcount
+			} else if (!std::filesystem::exists(names[i])) {
+				n_warning("Trying to load invalid model named '%s'!\n", names[i].c_str());
+				missing.push_back(names[i]);
+			} else if (std::find(toLoad.begin(), toLoad.end(), names[i]) == toLoad.end()) {
+				toLoad.push_back(names[i]);
+			}
 		}
 
-		if (std::filesystem::exists(name)) {
-			Model mdl = LoadGLTF(name);
-			mdl.refcount = 1;
+		std::vector<ModelSource> sources(toLoad.size());
+		Core::ParallelFor((uint) toLoad.size(), [&toLoad, &sources](uint i) {
+			ParseGLTF(toLoad[i], sources[i]);
+		});
+
+		for (ModelSource &source: sources) {
+			Model mdl = UploadGLTF(source);
+			mdl.refcount = 0;
 			ModelId const mid = (ModelId) modelAllocator.size();
-			modelAllocator.push_back(mdl);
-			modelRegistry.emplace(name, mid);
-			return mid;
+			modelAllocator.push_back(std::move(mdl));
+			modelRegistry.emplace(source.uri, mid);
 		}
 
-		n_warning("Trying to load invalid model named '%s'!\n", name.c_str());
-		return LoadModel("assets/error.glb");
+		for (size_t i = 0; i < names.size(); i++) {
+			if (ids[i] != InvalidResourceId)
+				continue;
+
+			if (std::find(missing.begin(), missing.end(), names[i]) != missing.end()) {
+				ids[i] = LoadModel("assets/error.glb");
+			} else {
+				ids[i] = modelRegistry[names[i]];
+				modelAllocator[ids[i]].refcount++;
+			}
+		}
+		return ids;
 	}
 
 	//------------------------------------------------------------------------------
@@ -12,22 +12,13 @@
 #include "renderdevice.h"
 #include "resourceid.h"
 #include "textureresource.h"
+#include "geometryarena.h"
 
 namespace Render
 {
 
 struct Model
 {
-    struct VertexAttribute
-    {
-        GLuint slot = 0;
-        GLint components = 0;
-        GLenum type = GL_NONE;
-        GLsizei stride = 0;
-        GLsizei offset = 0;
-        GLboolean normalized = GL_FALSE;
-    };
-
     struct Material
     {
         enum
@@ -62,17 +53,21 @@ struct Model
         float alphaCutoff{ 0.5f };
         AlphaMode alphaMode{ AlphaMode::Opaque };
         bool doubleSided{ false };
+
+        bool operator==(Material const&) const = default;
     };
 
     struct Mesh
     {
+        /// drawn from the geometry arena with 32 bit indices
         struct Primitive
         {
-            GLuint vao;
             GLuint numIndices;
-            GLuint offset = 0;
-            GLenum indexType;
+            GLuint firstIndex = 0;
+            GLint baseVertex = 0;
             Material material;
+            /// primitives with equal materials share the id, used to sort draws and skip state changes
+            uint32_t materialId = 0;
         };
 
         std::vector<Primitive> primitives;
@@ -82,12 +77,19 @@ struct Model
 
     std::vector<Mesh> meshes;
     //std::vector<TextureResourceId> textures;
-    std::vector<GLuint> buffers;
+    /// vertices and indices of all primitives
+    GeometryArena::Allocation geometry;
+    /// model space sphere around the bounding box of all primitives
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
     uint refcount;
 };
 
 ModelId LoadModel(std::string name);
 
+/// load several models at once, parsing them in parallel
+std::vector<ModelId> LoadModels(std::vector<std::string> const& names);
+
 void UnloadModel(ModelId);
 
 bool const IsModelValid(ModelId);
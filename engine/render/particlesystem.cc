@@ -10,7 +10,6 @@ namespace Render
         this->particleShaderId = Render::ShaderResource::CompileShaderProgram({ vs, fs });
         auto cs = Render::ShaderResource::LoadShader(Render::ShaderResource::ShaderType::COMPUTESHADER, "shd/cs_particle_sim_bufstorage.glsl");
         this->particleSimComputeShaderId = Render::ShaderResource::CompileShaderProgram({ cs });
-        glGenBuffers(1, &this->emitterBlockUBO);
 	}
     
     ParticleEmitter::ParticleEmitter(uint32_t numParticles)
@@ -68,7 +68,6 @@ private:
     GLuint writeIndex = 0;
     Render::ShaderProgramId particleShaderId;
     Render::ShaderProgramId particleSimComputeShaderId;
-    GLuint emitterBlockUBO;
 };
 
 }
\ No newline at end of file
@@ -8,32 +8,102 @@
 #include "debugrender.h"
 #include "core/random.h"
 #include "core/cvar.h"
+#include "core/mappedfile.h"
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
 
 namespace Physics {
     struct ColliderMesh {
-        struct Triangle {
-            glm::vec3 vertices[3];
-            glm::vec3 normal;
+        /// four triangles in SoA layout, with the Möller-Trumbore edges precomputed
+        struct alignas(16) TriangleBlock {
+            float v0[3][4];
+            float edge1[3][4];
+            float edge2[3][4];
         };
 
-        std::vector<Triangle> tris;
-        float bSphereRadius;
+        /// deduplicated vertex positions
+        glm::vec3 const *vertices = nullptr;
+        uint32_t const *indices = nullptr;
+        /// query data, the last block is padded with degenerate triangles
+        TriangleBlock const *blocks = nullptr;
+        uint32_t numVertices = 0;
+        uint32_t numIndices = 0;
+        uint32_t numBlocks = 0;
+        float bSphereRadius = 0;
+
+        /// the pointers above point either into these, when cooked at load time...
+        std::vector<glm::vec3> vertexStorage;
+        std::vector<uint32_t> indexStorage;
+        std::vector<TriangleBlock> blockStorage;
+        /// ...or into a mapped cook file
+        Core::MappedFile cookFile;
     };
 
-    struct Colliders {
-        std::vector<bool> active;
-        std::vector<uint16_t> masks;
-        std::vector<void *> userData;
-        std::vector<glm::vec4> positionsAndScales;
-        std::vector<glm::mat4> invTransforms;
-        std::vector<ColliderMeshId> meshes;
+    /// header of a cooked collider mesh, followed by the blocks, vertices and indices
+    struct CookedColliderHeader {
+        uint32_t magic;
+        uint32_t version;
+        /// size and modification time of the source file the mesh was cooked from
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint32_t numBlocks;
+        float bSphereRadius;
+        uint32_t pad[2];
     };
+    static_assert(sizeof(CookedColliderHeader) % alignof(ColliderMesh::TriangleBlock) == 0);
+
+    static constexpr uint32_t CookedColliderMagic = 'P' | ('C' << 8) | ('O' << 16) | ('L' << 24);
+    /// bump when the layout of the cooked data changes
+    static constexpr uint32_t CookedColliderVersion = 1;
 
-    static Colliders colliders;
     static std::vector<ColliderMesh> meshes;
     static Util::IdPool<ColliderMeshId> colliderMeshPool;
-    static Util::IdPool<ColliderId> colliderPool;
+    static std::mutex meshMutex;
+
+    struct VertexHash {
+        size_t operator()(glm::vec3 const &v) const {
+            uint32_t bits[3];
+            std::memcpy(bits, &v, sizeof(bits));
+            return std::hash<uint64_t>()(((uint64_t) bits[0] << 32) ^ ((uint64_t) bits[1] << 16) ^ bits[2]);
+        }
+    };
+
+    //------------------------------------------------------------------------------
+    /**
+        Packs the indexed triangles into blocks of four for the queries.
+    */
+    static void
+    BuildTriangleBlocks(ColliderMesh *mesh) {
+        std::vector<glm::vec3> const &vertices = mesh->vertexStorage;
+        std::vector<uint32_t> const &indices = mesh->indexStorage;
+        size_t numTris = indices.size() / 3;
+        mesh->blockStorage.clear();
+        // value initialized, unused lanes are degenerate and never hit
+        mesh->blockStorage.resize((numTris + 3) / 4, ColliderMesh::TriangleBlock());
+        for (size_t i = 0; i < numTris; i++) {
+            glm::vec3 const &A = vertices[indices[i * 3]];
+            glm::vec3 const &B = vertices[indices[i * 3 + 1]];
+            glm::vec3 const &C = vertices[indices[i * 3 + 2]];
+            glm::vec3 const edge1 = B - A;
+            glm::vec3 const edge2 = C - A;
+
+            ColliderMesh::TriangleBlock &block = mesh->blockStorage[i / 4];
+            size_t const lane = i % 4;
+            for (int axis = 0; axis < 3; axis++) {
+                block.v0[axis][lane] = A[axis];
+                block.edge1[axis][lane] = edge1[axis];
+                block.edge2[axis][lane] = edge2[axis];
+            }
+        }
+    }
 
     //------------------------------------------------------------------------------
     /**
@@ -62,32 +132,30 @@ namespace Physics {
 #endif
         size_t vSize = (vbAccessor.type == fx::gltf::Accessor::Type::Vec3) ? 3 : 4;
         // HACK: Assumes 3d or 4d vertex positions
-        for (int i = 0; i < numIndices; i += 3) {
-            ColliderMesh::Triangle tri;
-            tri.vertices[0] = glm::vec3(
-                vertexBuffer[vSize * indexBuffer[i]],
-                vertexBuffer[vSize * indexBuffer[i] + 1],
-                vertexBuffer[vSize * indexBuffer[i] + 2]
-            );
-            tri.vertices[1] = glm::vec3(
-                vertexBuffer[vSize * indexBuffer[i + 1]],
-                vertexBuffer[vSize * indexBuffer[i + 1] + 1],
-                vertexBuffer[vSize * indexBuffer[i + 1] + 2]
-            );
-            tri.vertices[2] = glm::vec3(
-                vertexBuffer[vSize * indexBuffer[i + 2]],
-                vertexBuffer[vSize * indexBuffer[i + 2] + 1],
-                vertexBuffer[vSize * indexBuffer[i + 2] + 2]
-            );
-
-            // compute plane's normal
-            glm::vec3 AB = tri.vertices[1] - tri.vertices[0];
-            glm::vec3 AC = tri.vertices[2] - tri.vertices[0];
-            tri.normal = glm::cross(AC, AB);
-
-            mesh->tris.push_back(std::move(tri));
+
+        // gltf vertices are often split on normals and uvs, merge the ones with equal positions
+        std::unordered_map<uint32_t, uint32_t> remap;
+        std::unordered_map<glm::vec3, uint32_t, VertexHash> unique;
+        mesh->indexStorage.reserve(numIndices);
+        for (size_t i = 0; i < numIndices; i++) {
+            uint32_t const index = (uint32_t) indexBuffer[i];
+            auto remapped = remap.find(index);
+            if (remapped == remap.end()) {
+                glm::vec3 const v = glm::vec3(
+                    vertexBuffer[vSize * index],
+                    vertexBuffer[vSize * index + 1],
+                    vertexBuffer[vSize * index + 2]
+                );
+                auto it = unique.emplace(v, (uint32_t) mesh->vertexStorage.size());
+                if (it.second)
+                    mesh->vertexStorage.push_back(v);
+                remapped = remap.emplace(index, it.first->second).first;
+            }
+            mesh->indexStorage.push_back(remapped->second);
         }
 
+        BuildTriangleBlocks(mesh);
+
         // bounding sphere radius is max of x, y or z from aabb
         mesh->bSphereRadius = vbAccessor.max[0];
         mesh->bSphereRadius = std::max(mesh->bSphereRadius, vbAccessor.max[1]);
@@ -100,17 +168,116 @@ namespace Physics {
 
     //------------------------------------------------------------------------------
     /**
+        Points the mesh at the data built during loading.
     */
-    ColliderMeshId
-    LoadColliderMesh(std::string path) {
-        ColliderMeshId id;
-        ColliderMesh *mesh;
-        if (colliderMeshPool.Allocate(id)) {
-            ColliderMesh newMesh;
-            meshes.push_back(std::move(newMesh));
+    static void
+    UseStorage(ColliderMesh *mesh) {
+        mesh->vertices = mesh->vertexStorage.data();
+        mesh->indices = mesh->indexStorage.data();
+        mesh->blocks = mesh->blockStorage.data();
+        mesh->numVertices = (uint32_t) mesh->vertexStorage.size();
+        mesh->numIndices = (uint32_t) mesh->indexStorage.size();
+        mesh->numBlocks = (uint32_t) mesh->blockStorage.size();
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Size and modification time, used to tell whether a cooked mesh is older than its source.
+    */
+    static bool
+    GetSourceStamp(std::string const &path, uint64_t &size, int64_t &time) {
+        std::error_code error;
+        size = std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+        time = (int64_t) std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        return !error;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Maps a cooked mesh and points the mesh straight into it, nothing is copied.
+        A cooked mesh without a source next to it is always used, so the sources don't have to be shipped.
+    */
+    static bool
+    LoadCookedColliderMesh(std::string const &cookPath, std::string const &sourcePath, ColliderMesh *mesh) {
+        Core::MappedFile file;
+        if (!file.Open(cookPath) || file.GetSize() < sizeof(CookedColliderHeader))
+            return false;
+
+        char const *data = (char const *) file.GetData();
+        CookedColliderHeader const *header = (CookedColliderHeader const *) data;
+        if (header->magic != CookedColliderMagic || header->version != CookedColliderVersion)
+            return false;
+
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if (GetSourceStamp(sourcePath, sourceSize, sourceTime)
+            && (sourceSize != header->sourceSize || sourceTime != header->sourceTime))
+            return false;
+
+        size_t const blocksOffset = sizeof(CookedColliderHeader);
+        size_t const verticesOffset = blocksOffset + header->numBlocks * sizeof(ColliderMesh::TriangleBlock);
+        size_t const indicesOffset = verticesOffset + header->numVertices * sizeof(glm::vec3);
+        if (file.GetSize() != indicesOffset + header->numIndices * sizeof(uint32_t))
+            return false;
+
+        mesh->blocks = (ColliderMesh::TriangleBlock const *) (data + blocksOffset);
+        mesh->vertices = (glm::vec3 const *) (data + verticesOffset);
+        mesh->indices = (uint32_t const *) (data + indicesOffset);
+        mesh->numBlocks = header->numBlocks;
+        mesh->numVertices = header->numVertices;
+        mesh->numIndices = header->numIndices;
+        mesh->bSphereRadius = header->bSphereRadius;
+        mesh->cookFile = std::move(file);
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Writes the mesh to a temporary file which is then renamed, so that other processes never map a
+        half written file. Failing to write is not an error, the mesh is just cooked again next time.
+    */
+    static void
+    WriteCookedColliderMesh(std::string const &cookPath, std::string const &sourcePath, ColliderMesh const &mesh) {
+        CookedColliderHeader header = {};
+        header.magic = CookedColliderMagic;
+        header.version = CookedColliderVersion;
+        if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+            return;
+        header.numVertices = mesh.numVertices;
+        header.numIndices = mesh.numIndices;
+        header.numBlocks = mesh.numBlocks;
+        header.bSphereRadius = mesh.bSphereRadius;
+
+        std::string const tempPath = cookPath + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+            if (!stream)
+                return;
+            stream.write((char const *) &header, sizeof(header));
+            stream.write((char const *) mesh.blocks, mesh.numBlocks * sizeof(ColliderMesh::TriangleBlock));
+            stream.write((char const *) mesh.vertices, mesh.numVertices * sizeof(glm::vec3));
+            stream.write((char const *) mesh.indices, mesh.numIndices * sizeof(uint32_t));
+            if (!stream) {
+                stream.close();
+                std::filesystem::remove(tempPath);
+                return;
+            }
         }
-        mesh = &meshes[id.index];
 
+        std::error_code error;
+        std::filesystem::rename(tempPath, cookPath, error);
+        if (error)
+            std::filesystem::remove(tempPath, error);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Reads the first primitive of a gltf into the mesh.
+    */
+    static bool
+    LoadGltfColliderMesh(std::string const &path, ColliderMesh *mesh) {
         // Load mesh from file
         fx::gltf::Document doc;
         try {
@@ -121,8 +288,7 @@ namespace Physics {
         } catch (const std::exception &err) {
             std::cout << err.what() << '\n';
             assert(false);
-            colliderMeshPool.Deallocate(id);
-            return ColliderMeshId();
+            return false;
         }
 
         // HACK: currently only supports one primtive per collider mesh. Needs to be the only one in the GLTF as well...
@@ -151,6 +317,33 @@ namespace Physics {
                 break;
         }
 
+        UseStorage(mesh);
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Uses the cooked mesh next to the source file when it is up to date, otherwise loads the gltf and
+        cooks it for the next run. Several meshes may be loaded from different threads at once, the mesh
+        is built on the calling thread and only added to the mesh list under the lock.
+    */
+    ColliderMeshId
+    LoadColliderMesh(std::string path) {
+        ColliderMesh loaded;
+        std::string const cookPath = path + ".collider";
+        if (!LoadCookedColliderMesh(cookPath, path, &loaded)) {
+            if (!LoadGltfColliderMesh(path, &loaded))
+                return ColliderMeshId();
+            WriteCookedColliderMesh(cookPath, path, loaded);
+        }
+
+        std::lock_guard<std::mutex> lock(meshMutex);
+        ColliderMeshId id;
+        if (colliderMeshPool.Allocate(id)) {
+            meshes.push_back(std::move(loaded));
+        } else {
+            meshes[id.index] = std::move(loaded);
+        }
         return id;
     }
 
@@ -158,7 +351,7 @@ namespace Physics {
     /**
     */
     ColliderId
-    CreateCollider(ColliderMeshId meshId, glm::mat4 const &transform, uint16_t mask, void *userData) {
+    World::CreateCollider(ColliderMeshId meshId, glm::mat4 const &transform, uint16_t mask, void *userData) {
 #if _DEBUG
     {
         // Only allows uniform scaling along all axes
@@ -179,6 +372,7 @@ namespace Physics {
             colliders.active.push_back(true);
             colliders.userData.push_back(userData);
             colliders.masks.push_back(mask);
+            colliders.denseIndices.push_back(0);
         } else {
             colliders.positionsAndScales[id.index] = PS;
             colliders.invTransforms[id.index] = glm::inverse(transform);
@@ -187,14 +381,34 @@ namespace Physics {
             colliders.userData[id.index] = userData;
             colliders.masks[id.index] = mask;
         }
+        colliders.denseIndices[id.index] = (uint32_t) colliders.dense.size();
+        colliders.dense.push_back(id.index);
         return id;
     }
 
     //------------------------------------------------------------------------------
     /**
+        Swaps the last active collider into the removed one's place, so the active set stays compact.
     */
     void
-    SetTransform(ColliderId collider, glm::mat4 const &transform) {
+    World::DestroyCollider(ColliderId collider) {
+        assert(colliderPool.IsValid(collider));
+        uint32_t const denseIndex = colliders.denseIndices[collider.index];
+        uint32_t const last = colliders.dense.back();
+        colliders.dense[denseIndex] = last;
+        colliders.denseIndices[last] = denseIndex;
+        colliders.dense.pop_back();
+
+        colliders.active[collider.index] = false;
+        colliders.userData[collider.index] = nullptr;
+        colliderPool.Deallocate(collider);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void
+    World::SetTransform(ColliderId collider, glm::mat4 const &transform) {
         assert(colliderPool.IsValid(collider));
 #if _DEBUG
     {
@@ -211,18 +425,28 @@ namespace Physics {
         colliders.invTransforms[collider.index] = glm::inverse(transform);
     }
 
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void *
+    World::GetUserData(ColliderId collider) const {
+        assert(colliderPool.IsValid(collider));
+        return colliders.userData[collider.index];
+    }
+
     //------------------------------------------------------------------------------
     /**
         Cast ray from start point in direction. Make sure the direction is a unit vector.
     */
     RaycastPayload
-    Raycast(glm::vec3 start, glm::vec3 dir, float maxDistance, uint16_t mask) {
+    World::Raycast(glm::vec3 start, glm::vec3 dir, float maxDistance, uint16_t mask) const {
         RaycastPayload ret;
         ret.hitDistance = maxDistance;
         // TODO: spatial acceleration instead of just checking everything...
-        int numColliders = (int) colliders.active.size();
-        for (int colliderIndex = 0; colliderIndex < numColliders; colliderIndex++) {
-            if (colliders.active[colliderIndex] && (mask == 0 || (colliders.masks[colliderIndex] & mask) != 0)) {
+        int numColliders = (int) colliders.dense.size();
+        for (int i = 0; i < numColliders; i++) {
+            uint32_t const colliderIndex = colliders.dense[i];
+            if (mask == 0 || (colliders.masks[colliderIndex] & mask) != 0) {
                 ColliderMesh const *const mesh = &meshes[colliders.meshes[colliderIndex].index];
                 glm::vec3 bSphereCenter = colliders.positionsAndScales[colliderIndex];
                 float radius = mesh->bSphereRadius * colliders.positionsAndScales[colliderIndex][3];
@@ -258,49 +482,312 @@ namespace Physics {
                 glm::vec3 invRayStart = invT * glm::vec4(start, 1.0f);
                 glm::vec3 invRayDir = invT * glm::vec4(dir, 0);
 
-                // fine check against mesh
-                int numTris = (int) mesh->tris.size();
-                for (int i = 0; i < numTris; ++i) {
-                    glm::vec3 const &N = mesh->tris[i].normal;
+                // fine check against mesh, four triangles at a time
+                __m128 const ox = _mm_set1_ps(invRayStart.x);
+                __m128 const oy = _mm_set1_ps(invRayStart.y);
+                __m128 const oz = _mm_set1_ps(invRayStart.z);
+                __m128 const dx = _mm_set1_ps(invRayDir.x);
+                __m128 const dy = _mm_set1_ps(invRayDir.y);
+                __m128 const dz = _mm_set1_ps(invRayDir.z);
+                __m128 const zero = _mm_setzero_ps();
 
-                    float NdotRayDirection = glm::dot(N, invRayDir);
-                    if (NdotRayDirection < 0)
-                        continue; // backfacing surface
+                int numBlocks = (int) mesh->numBlocks;
+                for (int i = 0; i < numBlocks; ++i) {
+                    ColliderMesh::TriangleBlock const &block = mesh->blocks[i];
+                    __m128 const e1x = _mm_load_ps(block.edge1[0]);
+                    __m128 const e1y = _mm_load_ps(block.edge1[1]);
+                    __m128 const e1z = _mm_load_ps(block.edge1[2]);
+                    __m128 const e2x = _mm_load_ps(block.edge2[0]);
+                    __m128 const e2y = _mm_load_ps(block.edge2[1]);
+                    __m128 const e2z = _mm_load_ps(block.edge2[2]);
 
-                    glm::vec3 const &A = mesh->tris[i].vertices[0];
-                    glm::vec3 const &B = mesh->tris[i].vertices[1];
-                    glm::vec3 const &C = mesh->tris[i].vertices[2];
+                    // P = dir x edge2, det = edge1 . P
+                    __m128 const px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+                    __m128 const py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+                    __m128 const pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+                    __m128 const det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
 
-                    float d = -glm::dot(N, A);
-                    float t = -(glm::dot(N, invRayStart) + d) / NdotRayDirection;
+                    // det <= 0 is a backfacing or degenerate triangle
+                    __m128 mask = _mm_cmpgt_ps(det, zero);
+                    if (_mm_movemask_ps(mask) == 0)
+                        continue;
 
-                    if (t < 0)
-                        continue; //the triangle is behind the ray
+                    __m128 const tx = _mm_sub_ps(ox, _mm_load_ps(block.v0[0]));
+                    __m128 const ty = _mm_sub_ps(oy, _mm_load_ps(block.v0[1]));
+                    __m128 const tz = _mm_sub_ps(oz, _mm_load_ps(block.v0[2]));
 
-                    glm::vec3 P = invRayStart + invRayDir * t;
+                    // barycentrics scaled by det, compared without dividing
+                    __m128 const u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz));
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+                    mask = _mm_and_ps(mask, _mm_cmple_ps(u, det));
 
-                    // check triangle bounds
-                    glm::vec3 K; //vector perpendicular to one of three subdivided triangles's plane
-                    glm::vec3 edge0 = B - A;
-                    glm::vec3 vp0 = P - A;
-                    K = glm::cross(vp0, edge0);
-                    if (glm::dot(N, K) < 0)
+                    // Q = T x edge1
+                    __m128 const qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+                    __m128 const qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+                    __m128 const qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+
+                    __m128 const v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz));
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+                    mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), det));
+                    if (_mm_movemask_ps(mask) == 0)
                         continue;
 
-                    glm::vec3 edge1 = C - B;
-                    glm::vec3 vp1 = P - B;
-                    K = glm::cross(vp1, edge1);
-                    if (glm::dot(N, K) < 0)
+                    __m128 const tScaled = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz));
+                    __m128 const t = _mm_div_ps(tScaled, det);
+                    // the triangle is behind the ray or further away than the closest hit
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+                    mask = _mm_and_ps(mask, _mm_cmple_ps(t, _mm_set1_ps(ret.hitDistance)));
+
+                    int hits = _mm_movemask_ps(mask);
+                    if (hits == 0)
                         continue;
 
-                    glm::vec3 edge2 = A - C;
-                    glm::vec3 vp2 = P - C;
-                    K = glm::cross(vp2, edge2);
-                    if (glm::dot(N, K) < 0)
+                    alignas(16) float distances[4];
+                    _mm_store_ps(distances, t);
+                    for (int lane = 0; lane < 4; lane++) {
+                        // intersection with at least one triangle
+                        if ((hits & (1 << lane)) && ret.hitDistance >= distances[lane]) {
+                            ret.hit = true;
+                            ret.hitDistance = distances[lane];
+                            ret.collider = ColliderId::Create(colliderIndex, colliderPool.generations[colliderIndex]);
+                        }
+                    }
+                }
+            }
+        }
+
+        if (ret.hit) {
+            //calculate hitpoint
+            ret.hitPoint = start + dir * ret.hitDistance;
+        }
+
+        return ret;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Closest point on triangle ABC to P, from Real-Time Collision Detection 5.1.5.
+    */
+    static glm::vec3
+    ClosestPointOnTriangle(glm::vec3 const &P, glm::vec3 const &A, glm::vec3 const &B, glm::vec3 const &C) {
+        glm::vec3 const AB = B - A;
+        glm::vec3 const AC = C - A;
+        glm::vec3 const AP = P - A;
+        float d1 = glm::dot(AB, AP);
+        float d2 = glm::dot(AC, AP);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+            return A;
+
+        glm::vec3 const BP = P - B;
+        float d3 = glm::dot(AB, BP);
+        float d4 = glm::dot(AC, BP);
+        if (d3 >= 0.0f && d4 <= d3)
+            return B;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            return A + AB * (d1 / (d1 - d3));
+
+        glm::vec3 const CP = P - C;
+        float d5 = glm::dot(AB, CP);
+        float d6 = glm::dot(AC, CP);
+        if (d6 >= 0.0f && d5 <= d6)
+            return C;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            return A + AC * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return B + (C - B) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denom = 1.0f / (va + vb + vc);
+        return A + AB * (vb * denom) + AC * (vc * denom);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Bitmask of the triangles in a block whose bounding boxes overlap the box, for the first numLanes lanes.
+        The padding lanes are degenerate triangles at the origin, so they are masked out rather than tested.
+    */
+    static inline int
+    OverlappingLanes(ColliderMesh::TriangleBlock const &block, glm::vec3 const &boxMin, glm::vec3 const &boxMax, int numLanes) {
+        __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int axis = 0; axis < 3; axis++) {
+            __m128 const a = _mm_load_ps(block.v0[axis]);
+            __m128 const b = _mm_add_ps(a, _mm_load_ps(block.edge1[axis]));
+            __m128 const c = _mm_add_ps(a, _mm_load_ps(block.edge2[axis]));
+            __m128 const lo = _mm_min_ps(a, _mm_min_ps(b, c));
+            __m128 const hi = _mm_max_ps(a, _mm_max_ps(b, c));
+            mask = _mm_and_ps(mask, _mm_cmple_ps(lo, _mm_set1_ps(boxMax[axis])));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(hi, _mm_set1_ps(boxMin[axis])));
+        }
+        return _mm_movemask_ps(mask) & ((1 << numLanes) - 1);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Corners of one triangle of a block.
+    */
+    static inline void
+    BlockTriangle(ColliderMesh::TriangleBlock const &block, int lane, glm::vec3 &A, glm::vec3 &B, glm::vec3 &C) {
+        A = glm::vec3(block.v0[0][lane], block.v0[1][lane], block.v0[2][lane]);
+        B = A + glm::vec3(block.edge1[0][lane], block.edge1[1][lane], block.edge1[2][lane]);
+        C = A + glm::vec3(block.edge2[0][lane], block.edge2[1][lane], block.edge2[2][lane]);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Earliest t in [0, maxT] where a sphere moving along O + D * t touches triangle ABC.
+        D does not have to be normalized. A sphere already touching the triangle hits at t = 0.
+    */
+    static bool
+    SweepSphereTriangle(glm::vec3 const &O, glm::vec3 const &D, float radius,
+                        glm::vec3 const &A, glm::vec3 const &B, glm::vec3 const &C, float maxT, float &t) {
+        float const r2 = radius * radius;
+        glm::vec3 const closest = ClosestPointOnTriangle(O, A, B, C);
+        glm::vec3 const toClosest = closest - O;
+        if (glm::dot(toClosest, toClosest) <= r2) {
+            t = 0.0f;
+            return true;
+        }
+
+        glm::vec3 N = glm::cross(B - A, C - A);
+        float const nLen = glm::length(N);
+        if (nLen < 1e-12f)
+            return false; // degenerate
+        N /= nLen;
+
+        bool hit = false;
+        float best = maxT;
+
+        // face, against the plane pushed out by the radius towards the sphere
+        float const dist = glm::dot(O - A, N);
+        float const dn = glm::dot(D, N);
+        if (dist * dn < 0.0f) {
+            float const side = dist > 0.0f ? 1.0f : -1.0f;
+            float const tPlane = (side * radius - dist) / dn;
+            if (tPlane >= 0.0f && tPlane <= best) {
+                glm::vec3 const P = O + D * tPlane - N * (side * radius);
+                float const u = glm::dot(glm::cross(B - A, P - A), N);
+                float const v = glm::dot(glm::cross(C - B, P - B), N);
+                float const w = glm::dot(glm::cross(A - C, P - C), N);
+                if (u >= 0.0f && v >= 0.0f && w >= 0.0f) {
+                    // the face contact is always the first one
+                    t = tPlane;
+                    return true;
+                }
+            }
+        }
+
+        float const dd = glm::dot(D, D);
+
+        // edges, as infinite cylinders clipped to the segment
+        glm::vec3 const edgeStarts[3] = { A, B, C };
+        glm::vec3 const edgeEnds[3] = { B, C, A };
+        for (int i = 0; i < 3; i++) {
+            glm::vec3 const E = edgeEnds[i] - edgeStarts[i];
+            glm::vec3 const M = O - edgeStarts[i];
+            float const ee = glm::dot(E, E);
+            float const de = glm::dot(D, E);
+            float const me = glm::dot(M, E);
+            float const a = ee * dd - de * de;
+            if (a < 1e-12f)
+                continue; // moving parallel to the edge, the vertices catch it
+            float const b = ee * glm::dot(M, D) - me * de;
+            float const c = ee * (glm::dot(M, M) - r2) - me * me;
+            float const discr = b * b - a * c;
+            if (discr < 0.0f)
+                continue;
+            float const tEdge = (-b - sqrtf(discr)) / a;
+            if (tEdge < 0.0f || tEdge > best)
+                continue;
+            float const s = (me + tEdge * de) / ee;
+            if (s >= 0.0f && s <= 1.0f) {
+                best = tEdge;
+                hit = true;
+            }
+        }
+
+        // vertices
+        for (glm::vec3 const &V : edgeStarts) {
+            glm::vec3 const M = O - V;
+            float const b = glm::dot(M, D);
+            float const c = glm::dot(M, M) - r2;
+            float const discr = b * b - dd * c;
+            if (discr < 0.0f)
+                continue;
+            float const tVertex = (-b - sqrtf(discr)) / dd;
+            if (tVertex >= 0.0f && tVertex <= best) {
+                best = tVertex;
+                hit = true;
+            }
+        }
+
+        if (hit)
+            t = best;
+        return hit;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Like Raycast but with a sphere of the given radius, against both sides of every triangle.
+        A sphere overlapping a collider at the start hits at distance 0.
+    */
+    RaycastPayload
+    World::SphereCast(glm::vec3 start, glm::vec3 dir, float radius, float maxDistance, uint16_t mask) const {
+        RaycastPayload ret;
+        ret.hitDistance = maxDistance;
+        int numColliders = (int) colliders.dense.size();
+        for (int i = 0; i < numColliders; i++) {
+            uint32_t const colliderIndex = colliders.dense[i];
+            if (mask != 0 && (colliders.masks[colliderIndex] & mask) == 0)
+                continue;
+
+            ColliderMesh const *const mesh = &meshes[colliders.meshes[colliderIndex].index];
+            glm::vec4 const &PS = colliders.positionsAndScales[colliderIndex];
+
+            // coarse check, the swept sphere against the bounding sphere grown by the radius
+            {
+                float const r = mesh->bSphereRadius * PS.w + radius;
+                glm::vec3 const m = start - glm::vec3(PS);
+                float const c = glm::dot(m, m) - r * r;
+                if (c > 0.0f) {
+                    float const b = glm::dot(m, dir);
+                    if (b > 0.0f)
+                        continue; // starts outside and moves away
+                    float const discr = b * b - c;
+                    if (discr < 0.0f)
                         continue;
+                    if (-b - sqrtf(discr) > ret.hitDistance)
+                        continue; // too short to reach it
+                }
+            }
 
-                    // intersection with at least one triangle
-                    if (ret.hitDistance >= t) {
+            // scale is uniform, so the sphere stays a sphere in model space and distances along the ray are kept
+            glm::mat4 const &invT = colliders.invTransforms[colliderIndex];
+            glm::vec3 const localStart = invT * glm::vec4(start, 1.0f);
+            glm::vec3 const localDir = invT * glm::vec4(dir, 0.0f);
+            float const localRadius = radius / PS.w;
+
+            // four triangles at a time against the box around the sweep up to the closest hit so far,
+            // the exact sweep only runs for the ones that pass
+            int const numTris = (int) (mesh->numIndices / 3);
+            int const numBlocks = (int) mesh->numBlocks;
+            for (int j = 0; j < numBlocks; j++) {
+                glm::vec3 const end = localStart + localDir * ret.hitDistance;
+                glm::vec3 const sweepMin = glm::min(localStart, end) - localRadius;
+                glm::vec3 const sweepMax = glm::max(localStart, end) + localRadius;
+                ColliderMesh::TriangleBlock const &block = mesh->blocks[j];
+                int lanes = OverlappingLanes(block, sweepMin, sweepMax, glm::min(numTris - j * 4, 4));
+                for (int lane = 0; lanes != 0; lane++, lanes >>= 1) {
+                    if ((lanes & 1) == 0)
+                        continue;
+                    glm::vec3 A, B, C;
+                    BlockTriangle(block, lane, A, B, C);
+                    float t;
+                    if (SweepSphereTriangle(localStart, localDir, localRadius, A, B, C, ret.hitDistance, t)) {
                         ret.hit = true;
                         ret.hitDistance = t;
                         ret.collider = ColliderId::Create(colliderIndex, colliderPool.generations[colliderIndex]);
@@ -310,10 +797,233 @@ namespace Physics {
         }
 
         if (ret.hit) {
-            //calculate hitpoint
+            // center of the sphere at the time of contact
             ret.hitPoint = start + dir * ret.hitDistance;
         }
 
         return ret;
     }
+
+    //------------------------------------------------------------------------------
+    /**
+        Appends every collider whose mesh touches the sphere, returns the number of colliders found.
+    */
+    size_t
+    World::OverlapSphere(glm::vec3 center, float radius, std::vector<ColliderId> &results, uint16_t mask) const {
+        size_t const numResults = results.size();
+        int numColliders = (int) colliders.dense.size();
+        for (int i = 0; i < numColliders; i++) {
+            uint32_t const colliderIndex = colliders.dense[i];
+            if (mask != 0 && (colliders.masks[colliderIndex] & mask) == 0)
+                continue;
+
+            ColliderMesh const *const mesh = &meshes[colliders.meshes[colliderIndex].index];
+            glm::vec4 const &PS = colliders.positionsAndScales[colliderIndex];
+
+            // coarse check against bounding sphere
+            glm::vec3 const d = center - glm::vec3(PS);
+            float const r = mesh->bSphereRadius * PS.w + radius;
+            if (glm::dot(d, d) > r * r)
+                continue;
+
+            glm::vec3 const localCenter = colliders.invTransforms[colliderIndex] * glm::vec4(center, 1.0f);
+            float const localRadius = radius / PS.w;
+            float const r2 = localRadius * localRadius;
+
+            // four triangles at a time against the box around the sphere, exact test for the ones that pass
+            glm::vec3 const boxMin = localCenter - localRadius;
+            glm::vec3 const boxMax = localCenter + localRadius;
+            int const numTris = (int) (mesh->numIndices / 3);
+            int const numBlocks = (int) mesh->numBlocks;
+            bool overlaps = false;
+            for (int j = 0; j < numBlocks && !overlaps; j++) {
+                ColliderMesh::TriangleBlock const &block = mesh->blocks[j];
+                int lanes = OverlappingLanes(block, boxMin, boxMax, glm::min(numTris - j * 4, 4));
+                for (int lane = 0; lanes != 0 && !overlaps; lane++, lanes >>= 1) {
+                    if ((lanes & 1) == 0)
+                        continue;
+                    glm::vec3 A, B, C;
+                    BlockTriangle(block, lane, A, B, C);
+                    glm::vec3 const toClosest = ClosestPointOnTriangle(localCenter, A, B, C) - localCenter;
+                    overlaps = glm::dot(toClosest, toClosest) <= r2;
+                }
+            }
+            if (overlaps)
+                results.push_back(ColliderId::Create(colliderIndex, colliderPool.generations[colliderIndex]));
+        }
+        return results.size() - numResults;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Appends every collider whose bounding sphere touches the box, returns the number of colliders found.
+        Only the bounding spheres are tested, follow up with OverlapSphere or SphereCast for exact results.
+    */
+    size_t
+    World::OverlapAABB(glm::vec3 min, glm::vec3 max, std::vector<ColliderId> &results, uint16_t mask) const {
+        size_t const numResults = results.size();
+        int numColliders = (int) colliders.dense.size();
+        for (int i = 0; i < numColliders; i++) {
+            uint32_t const colliderIndex = colliders.dense[i];
+            if (mask != 0 && (colliders.masks[colliderIndex] & mask) == 0)
+                continue;
+
+            glm::vec4 const &PS = colliders.positionsAndScales[colliderIndex];
+            float const r = meshes[colliders.meshes[colliderIndex].index].bSphereRadius * PS.w;
+            glm::vec3 const d = glm::vec3(PS) - glm::clamp(glm::vec3(PS), min, max);
+            if (glm::dot(d, d) <= r * r)
+                results.push_back(ColliderId::Create(colliderIndex, colliderPool.generations[colliderIndex]));
+        }
+        return results.size() - numResults;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        Bounding spheres are projected onto the axis where the collider centers are most spread out and
+        sorted by their lower end, then each interval is only compared against the ones starting before it ends.
+        Only colliders matching the mask are considered, pairs are appended to the output.
+    */
+    void
+    World::FindOverlappingPairs(std::vector<ColliderPair> &pairs, uint16_t mask) {
+        int numColliders = (int) colliders.dense.size();
+
+        glm::vec3 sum = glm::vec3(0);
+        glm::vec3 sumSq = glm::vec3(0);
+        int numEntries = 0;
+        for (int i = 0; i < numColliders; i++) {
+            uint32_t const colliderIndex = colliders.dense[i];
+            if (mask == 0 || (colliders.masks[colliderIndex] & mask) != 0) {
+                glm::vec3 center = colliders.positionsAndScales[colliderIndex];
+                sum += center;
+                sumSq += center * center;
+                numEntries++;
+            }
+        }
+        if (numEntries < 2)
+            return;
+
+        glm::vec3 variance = sumSq - sum * sum / (float) numEntries;
+        int axis = 0;
+        if (variance.y > variance[axis]) axis = 1;
+        if (variance.z > variance[axis]) axis = 2;
+
+        sweepEntries.clear();
+        for (int i = 0; i < numColliders; i++) {
+            uint32_t const colliderIndex = colliders.dense[i];
+            if (mask == 0 || (colliders.masks[colliderIndex] & mask) != 0) {
+                glm::vec4 const &PS = colliders.positionsAndScales[colliderIndex];
+                float radius = meshes[colliders.meshes[colliderIndex].index].bSphereRadius * PS.w;
+                sweepEntries.push_back({ PS[axis] - radius, PS[axis] + radius, colliderIndex });
+            }
+        }
+
+        // ties are broken by index so the pair order does not depend on the sort implementation
+        std::sort(sweepEntries.begin(), sweepEntries.end(), [](SweepEntry const &a, SweepEntry const &b) {
+            return a.min < b.min || (a.min == b.min && a.index < b.index);
+        });
+
+        for (size_t i = 0; i < sweepEntries.size(); i++) {
+            SweepEntry const &a = sweepEntries[i];
+            glm::vec4 const &PSa = colliders.positionsAndScales[a.index];
+            float radiusA = (a.max - a.min) * 0.5f;
+
+            for (size_t j = i + 1; j < sweepEntries.size() && sweepEntries[j].min <= a.max; j++) {
+                SweepEntry const &b = sweepEntries[j];
+                glm::vec4 const &PSb = colliders.positionsAndScales[b.index];
+                float radiusB = (b.max - b.min) * 0.5f;
+
+                // narrow down to the bounding spheres
+                glm::vec3 d = glm::vec3(PSb) - glm::vec3(PSa);
+                float r = radiusA + radiusB;
+                if (glm::dot(d, d) > r * r)
+                    continue;
+
+                pairs.push_back({
+                    ColliderId::Create(a.index, colliderPool.generations[a.index]),
+                    ColliderId::Create(b.index, colliderPool.generations[b.index])
+                });
+            }
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    World *
+    DefaultWorld() {
+        static World world;
+        return &world;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    RaycastPayload
+    Raycast(glm::vec3 start, glm::vec3 dir, float maxDistance, uint16_t mask) {
+        return DefaultWorld()->Raycast(start, dir, maxDistance, mask);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    RaycastPayload
+    SphereCast(glm::vec3 start, glm::vec3 dir, float radius, float maxDistance, uint16_t mask) {
+        return DefaultWorld()->SphereCast(start, dir, radius, maxDistance, mask);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    size_t
+    OverlapSphere(glm::vec3 center, float radius, std::vector<ColliderId> &results, uint16_t mask) {
+        return DefaultWorld()->OverlapSphere(center, radius, results, mask);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    size_t
+    OverlapAABB(glm::vec3 min, glm::vec3 max, std::vector<ColliderId> &results, uint16_t mask) {
+        return DefaultWorld()->OverlapAABB(min, max, results, mask);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void
+    FindOverlappingPairs(std::vector<ColliderPair> &pairs, uint16_t mask) {
+        DefaultWorld()->FindOverlappingPairs(pairs, mask);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    ColliderId
+    CreateCollider(ColliderMeshId meshId, glm::mat4 const &transform, uint16_t mask, void *userData) {
+        return DefaultWorld()->CreateCollider(meshId, transform, mask, userData);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void
+    DestroyCollider(ColliderId collider) {
+        DefaultWorld()->DestroyCollider(collider);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void
+    SetTransform(ColliderId collider, glm::mat4 const &transform) {
+        DefaultWorld()->SetTransform(collider, transform);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    void *
+    GetUserData(ColliderId collider) {
+        return DefaultWorld()->GetUserData(collider);
+    }
 } // namespace Physics
@@ -8,6 +8,8 @@
 */
 //------------------------------------------------------------------------------
 #include <string>
+#include <vector>
+#include "core/idpool.h"
 
 namespace Physics
 {
@@ -87,12 +89,103 @@ struct RaycastPayload
     ColliderId collider;
 };
 
+struct ColliderPair
+{
+    ColliderId first;
+    ColliderId second;
+};
+
+//------------------------------------------------------------------------------
+/**
+    A set of colliders that can be queried independently of all other worlds.
+    Collider meshes are shared between worlds, load them before simulating worlds on separate threads.
+    A single world must not be used from several threads at once.
+*/
+class World
+{
+public:
+    World() = default;
+    World(const World&) = delete;
+    void operator=(const World&) = delete;
+
+    RaycastPayload Raycast(glm::vec3 start, glm::vec3 dir, float maxDistance, uint16_t mask = 0) const;
+
+    /// sweep a sphere along a ray, hitPoint is the sphere center at first contact
+    RaycastPayload SphereCast(glm::vec3 start, glm::vec3 dir, float radius, float maxDistance, uint16_t mask = 0) const;
+
+    /// append all colliders whose mesh touches the sphere, returns the number appended
+    size_t OverlapSphere(glm::vec3 center, float radius, std::vector<ColliderId>& results, uint16_t mask = 0) const;
+
+    /// append all colliders whose bounding sphere touches the box, returns the number appended
+    size_t OverlapAABB(glm::vec3 min, glm::vec3 max, std::vector<ColliderId>& results, uint16_t mask = 0) const;
+
+    /// find all pairs of colliders with overlapping bounding spheres, using sweep and prune along the axis of most spread
+    void FindOverlappingPairs(std::vector<ColliderPair>& pairs, uint16_t mask = 0);
+
+    ColliderId CreateCollider(ColliderMeshId meshId, glm::mat4 const& transform, uint16_t mask = 0, void* userData = nullptr);
+
+    /// remove a collider from the world, the id becomes invalid and its slot is recycled
+    void DestroyCollider(ColliderId collider);
+
+    void SetTransform(ColliderId collider, glm::mat4 const& transform);
+
+    void* GetUserData(ColliderId collider) const;
+
+private:
+    struct Colliders
+    {
+        std::vector<bool> active;
+        std::vector<uint16_t> masks;
+        std::vector<void*> userData;
+        std::vector<glm::vec4> positionsAndScales;
+        std::vector<glm::mat4> invTransforms;
+        std::vector<ColliderMeshId> meshes;
+        /// position of every active collider in the dense list
+        std::vector<uint32_t> denseIndices;
+
+        /// indices of all active colliders, queries only iterate these
+        std::vector<uint32_t> dense;
+    };
+
+    struct SweepEntry
+    {
+        float min;
+        float max;
+        uint32_t index;
+    };
+
+    Colliders colliders;
+    Util::IdPool<ColliderId> colliderPool;
+    /// kept around to avoid reallocating every query
+    std::vector<SweepEntry> sweepEntries;
+};
+
+/// the world used by the free functions below
+World* DefaultWorld();
+
 RaycastPayload Raycast(glm::vec3 start, glm::vec3 dir, float maxDistance, uint16_t mask = 0);
 
+/// sweep a sphere along a ray, hitPoint is the sphere center at first contact
+RaycastPayload SphereCast(glm::vec3 start, glm::vec3 dir, float radius, float maxDistance, uint16_t mask = 0);
+
+/// append all colliders whose mesh touches the sphere, returns the number appended
+size_t OverlapSphere(glm::vec3 center, float radius, std::vector<ColliderId>& results, uint16_t mask = 0);
+
+/// append all colliders whose bounding sphere touches the box, returns the number appended
+size_t OverlapAABB(glm::vec3 min, glm::vec3 max, std::vector<ColliderId>& results, uint16_t mask = 0);
+
+/// find all pairs of colliders with overlapping bounding spheres, using sweep and prune along the axis of most spread
+void FindOverlappingPairs(std::vector<ColliderPair>& pairs, uint16_t mask = 0);
+
 ColliderId CreateCollider(ColliderMeshId meshId, glm::mat4 const& transform, uint16_t mask = 0, void* userData = nullptr);
 
+/// remove a collider from the world, the id becomes invalid and its slot is recycled
+void DestroyCollider(ColliderId collider);
+
 ColliderMeshId LoadColliderMesh(std::string path);
 
 void SetTransform(ColliderId collider, glm::mat4 const& transform);
 
+void* GetUserData(ColliderId collider);
+
 } // namespace Physics
@@ -4,6 +4,8 @@
 //------------------------------------------------------------------------------
 #include "renderdevice.h"
 #include "model.h"
+#include "geometryarena.h"
+#include "streambuffer.h"
 #include "textureresource.h"
 #include "shaderresource.h"
 #include "lightserver.h"
@@ -12,6 +14,7 @@
 #include "grid.h"
 #include "core/random.h"
 #include "core/cvar.h"
+#include "core/jobsystem.h"
 #include "core/random.h"
 #include "particlesystem.h"
 
@@ -28,6 +31,9 @@ Render::ShaderProgramId lightCullingProgram;
 GLuint fullscreenQuadVB;
 GLuint fullscreenQuadVAO;
 
+static Core::CVar* r_frustum_cull = nullptr;
+static Core::CVar* r_multi_draw_indirect = nullptr;
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -63,6 +69,8 @@ void RenderDevice::Init()
 {
     RenderDevice::Instance();
     CameraManager::Create();
+    GeometryArena::Create();
+    StreamBuffer::Create();
     LightServer::Initialize();
     TextureResource::Create();
     
@@ -145,6 +153,9 @@ void RenderDevice::Init()
     ParticleSystem::Instance()->Initialize();
 
     Debug::InitDebugRendering();
+
+    r_frustum_cull = Core::CVarCreate(Core::CVar_Int, "r_frustum_cull", "1", "Skip draw commands outside the camera and shadow volumes");
+    r_multi_draw_indirect = Core::CVarCreate(Core::CVar_Int, "r_multi_draw_indirect", "1", "Draw static geometry with one indirect multi draw per material instead of one draw per primitive");
 }
 
 void RenderDevice::Draw(ModelId model, glm::mat4 localToWorld)
@@ -155,64 +166,311 @@ void RenderDevice::Draw(ModelId model, glm::mat4 localToWorld)
 //------------------------------------------------------------------------------
 /**
 */
-void
-RenderDevice::StaticShadowPass()
+void RenderDevice::Draw(std::vector<DrawCommand> const& commands)
 {
-    uint shadowMapSize = LightServer::GetShadowMapSize();
-    glViewport(0, 0, shadowMapSize, shadowMapSize);
-    glBindFramebuffer(GL_FRAMEBUFFER, LightServer::GetGlobalShadowFramebuffer());
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    std::vector<DrawCommand>& drawCommands = Instance()->drawCommands;
+    drawCommands.insert(drawCommands.end(), commands.begin(), commands.end());
+}
 
+//------------------------------------------------------------------------------
+/**
+    Culls this frame's draw commands for the main and shadow camera, groups them by model and
+    sorts their draws. Runs on the job system and makes no GL calls, UploadInstances does those.
+*/
+void
+RenderDevice::PrepareInstances()
+{
     Camera const* const mainCamera = CameraManager::GetCamera(CAMERA_MAIN);
-    Camera* const shadowCamera = CameraManager::GetCamera(CAMERA_SHADOW);
 
-    glm::vec3 shadowCamOffset = glm::normalize(LightServer::globalLightDirection) * 250.0f;
-    glm::vec3 shadowCamTarget = glm::vec3(mainCamera->invView[3]);
-    shadowCamTarget.y = 0.0f;
-    shadowCamera->view = glm::lookAt(shadowCamTarget + shadowCamOffset,
-        shadowCamTarget,
-        glm::vec3(0.0f, 1.0f, 0.0f));
+    // world space bounds of every command, the radius grows with the largest axis scale
+    static constexpr uint BoundsChunkSize = 1024;
+    uint const numCommands = (uint)this->drawCommands.size();
+    this->commandBounds.Resize(numCommands);
+    Core::ParallelFor((numCommands + BoundsChunkSize - 1) / BoundsChunkSize, [this, numCommands](uint chunk)
+    {
+        uint const end = glm::min(numCommands, (chunk + 1) * BoundsChunkSize);
+        for (uint i = chunk * BoundsChunkSize; i < end; i++)
+        {
+            DrawCommand const& cmd = this->drawCommands[i];
+            Model const& model = GetModel(cmd.modelId);
+            glm::vec3 const center = glm::vec3(cmd.transform * glm::vec4(model.boundsCenter, 1.0f));
+            float const scale = glm::sqrt(glm::max(glm::max(glm::dot(cmd.transform[0], cmd.transform[0]), glm::dot(cmd.transform[1], cmd.transform[1])), glm::dot(cmd.transform[2], cmd.transform[2])));
+            this->commandBounds.Set(i, center, model.boundsRadius * scale);
+        }
+    });
 
-    CameraManager::UpdateCamera(shadowCamera);
+    this->mainView.frustum = ExtractFrustum(mainCamera->viewProjection);
+    this->mainView.position = glm::vec3(mainCamera->invView[3]);
+    // every cascade culls its own casters, sorted from the near plane of its volume, which faces the light
+    for (uint i = 0; i < this->shadowCascades.count; i++)
+    {
+        View& shadowView = this->shadowViews[i];
+        glm::vec4 const nearCenter = glm::inverse(this->shadowCascades.viewProjections[i]) * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+        shadowView.frustum = ExtractFrustum(this->shadowCascades.viewProjections[i]);
+        shadowView.position = glm::vec3(nearCenter) / nearCenter.w;
+    }
 
-    auto programHandle = Render::ShaderResource::GetProgramHandle(staticShadowProgram);
-    glUseProgram(programHandle);
-    glUniformMatrix4fv(glGetUniformLocation(programHandle, "ViewProjection"), 1, false, &shadowCamera->viewProjection[0][0]);
+    // the views only share read only data
+    Core::JobCounter shadowViewsDone;
+    for (uint i = 0; i < this->shadowCascades.count; i++)
+        Core::ScheduleJob([this, i] { this->PrepareView(this->shadowViews[i]); }, &shadowViewsDone);
+    this->PrepareView(this->mainView);
+    Core::WaitForJobs(shadowViewsDone);
+
+    // draw items index batches, not instances, so only the batches need the offset
+    this->instanceTransforms.assign(this->mainView.transforms.begin(), this->mainView.transforms.end());
+    this->BuildIndirect(this->mainView);
+    for (uint i = 0; i < this->shadowCascades.count; i++)
+    {
+        View& shadowView = this->shadowViews[i];
+        uint32_t const shadowInstanceOffset = (uint32_t)this->instanceTransforms.size();
+        for (InstanceBatch& batch : shadowView.batches)
+            batch.firstInstance += shadowInstanceOffset;
+        this->instanceTransforms.insert(this->instanceTransforms.end(), shadowView.transforms.begin(), shadowView.transforms.end());
+        this->BuildIndirect(shadowView);
+    }
+}
 
-    GLuint baseColorFactorLocation = glGetUniformLocation(programHandle, "BaseColorFactor");
-    GLuint modelLocation = glGetUniformLocation(programHandle, "Model");
-    GLuint alphaCutoffLocation = glGetUniformLocation(programHandle, "AlphaCutoff");
+//------------------------------------------------------------------------------
+/**
+    Splits the sorted items into runs of the same material and writes an indirect command for
+    every item. The instance index attribute starts at the base instance, so the commands find
+    their transforms without a separate table.
+*/
+void
+RenderDevice::BuildIndirect(View& view)
+{
+    view.runs.clear();
+    view.indirect.resize(view.items.size());
+    uint32_t runMaterial = UINT32_MAX;
+    for (uint32_t i = 0; i < (uint32_t)view.items.size(); i++)
+    {
+        DrawItem const& item = view.items[i];
+        InstanceBatch const& batch = view.batches[item.batch];
+        Model::Mesh::Primitive const& primitive = GetModel(batch.modelId).meshes[item.mesh].primitives[item.primitive];
 
-    // Draw opaque first
-    for (auto const& cmd : this->drawCommands)
+        if (primitive.materialId != runMaterial)
+        {
+            runMaterial = primitive.materialId;
+            view.runs.push_back({ i, 0 });
+        }
+        view.runs.back().numItems++;
+
+        DrawIndirectCommand& cmd = view.indirect[i];
+        cmd.count = primitive.numIndices;
+        cmd.instanceCount = batch.numInstances;
+        cmd.firstIndex = primitive.firstIndex;
+        cmd.baseVertex = primitive.baseVertex;
+        cmd.baseInstance = batch.firstInstance;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Culls the draw commands against the view, batches the visible ones and builds one draw item per
+    opaque primitive of every batch. Items are sorted by state and then by the nearest instance of
+    each batch, relative to the farthest batch since cameras don't store a far plane.
+*/
+void
+RenderDevice::PrepareView(View& view)
+{
+    view.commands.clear();
+    if (Core::CVarReadInt(r_frustum_cull) == 0)
+    {
+        view.commands = this->drawCommands;
+    }
+    else
     {
-        Model const& model = GetModel(cmd.modelId);
-        glUniformMatrix4fv(modelLocation, 1, false, &cmd.transform[0][0]);
+        CullSpheres(view.frustum, this->commandBounds, view.visible);
+        for (uint32_t index : view.visible)
+            view.commands.push_back(this->drawCommands[index]);
+    }
+    BuildInstanceBatches(view.commands, view.batches, view.transforms);
 
-        for (auto const& mesh : model.meshes)
+    float maxDepth = 0.0f;
+    view.batchDepths.resize(view.batches.size());
+    for (size_t i = 0; i < view.batches.size(); i++)
+    {
+        InstanceBatch const& batch = view.batches[i];
+        float nearest = FLT_MAX;
+        for (uint32_t instance = batch.firstInstance; instance < batch.firstInstance + batch.numInstances; instance++)
+            nearest = glm::min(nearest, glm::distance(view.position, glm::vec3(view.transforms[instance][3])));
+        view.batchDepths[i] = nearest;
+        maxDepth = glm::max(maxDepth, nearest);
+    }
+    float const depthScale = maxDepth > 0.0f ? 1.0f / maxDepth : 0.0f;
+
+    view.items.clear();
+    for (uint32_t i = 0; i < (uint32_t)view.batches.size(); i++)
+    {
+        Model const& model = GetModel(view.batches[i].modelId);
+        for (uint16_t meshIndex = 0; meshIndex < (uint16_t)model.meshes.size(); meshIndex++)
         {
-            for (auto& primitiveId : mesh.opaquePrimitives)
+            Model::Mesh const& mesh = model.meshes[meshIndex];
+            for (uint16_t primitiveId : mesh.opaquePrimitives)
             {
-                auto& primitive = mesh.primitives[primitiveId];
+                Model::Mesh::Primitive const& primitive = mesh.primitives[primitiveId];
+                DrawQueue const queue = primitive.material.alphaMode == Model::Material::AlphaMode::Mask ? DrawQueue::Mask : DrawQueue::Opaque;
+                // all static geometry is drawn with the same programs
+                uint64_t const key = MakeDrawKey(queue, 0, primitive.materialId, view.batchDepths[i] * depthScale);
+                view.items.push_back({ key, i, meshIndex, primitiveId });
+            }
+        }
+    }
+    SortDrawItems(view.items, view.sortScratch);
+}
 
-                glActiveTexture(GL_TEXTURE0 + Model::Material::TEXTURE_BASECOLOR);
-                glBindTexture(GL_TEXTURE_2D, Render::TextureResource::GetTextureHandle(primitive.material.textures[Model::Material::TEXTURE_BASECOLOR]));
-                glUniform1i(Model::Material::TEXTURE_BASECOLOR, Model::Material::TEXTURE_BASECOLOR);
+//------------------------------------------------------------------------------
+/**
+    Asks the texture streaming for the mips the main view needs, from how large the nearest
+    instance of each batch is on screen.
+*/
+void
+RenderDevice::RequestTextureMips(int viewportHeight)
+{
+    Camera const* const mainCamera = CameraManager::GetCamera(CAMERA_MAIN);
+    // pixels covered by one unit at a distance of one
+    float const pixelsPerUnit = mainCamera->projection[1][1] * 0.5f * (float)viewportHeight;
+    View const& view = this->mainView;
+    for (InstanceBatch const& batch : view.batches)
+    {
+        Model const& model = GetModel(batch.modelId);
+        float screenSize = 0.0f;
+        for (uint32_t instance = batch.firstInstance; instance < batch.firstInstance + batch.numInstances; instance++)
+        {
+            glm::mat4 const& transform = view.transforms[instance];
+            float const scale = glm::sqrt(glm::max(glm::max(glm::dot(transform[0], transform[0]), glm::dot(transform[1], transform[1])), glm::dot(transform[2], transform[2])));
+            float const radius = model.boundsRadius * scale;
+            glm::vec3 const center = glm::vec3(transform * glm::vec4(model.boundsCenter, 1.0f));
+            // the camera may be inside the bounds
+            float const distance = glm::max(glm::distance(view.position, center) - radius, 0.1f);
+            screenSize = glm::max(screenSize, 2.0f * radius * pixelsPerUnit / distance);
+        }
 
-                glUniform4fv(baseColorFactorLocation, 1, &primitive.material.baseColorFactor[0]);
+        for (Model::Mesh const& mesh : model.meshes)
+        {
+            for (Model::Mesh::Primitive const& primitive : mesh.primitives)
+            {
+                for (TextureResourceId texture : primitive.material.textures)
+                {
+                    if (texture != InvalidResourceId)
+                        TextureResource::RequestTextureSize(texture, screenSize);
+                }
+            }
+        }
+    }
+}
 
-                if (primitive.material.alphaMode == Model::Material::AlphaMode::Mask)
-                    glUniform1f(alphaCutoffLocation, primitive.material.alphaCutoff);
-                else
-                    glUniform1f(alphaCutoffLocation, 0);
+//------------------------------------------------------------------------------
+/**
+*/
+void
+RenderDevice::UploadInstances()
+{
+    this->instanceRange = StreamBuffer::UploadStorage(this->instanceTransforms.data(), this->instanceTransforms.size() * sizeof(glm::mat4));
+    this->mainView.indirectRange = StreamBuffer::UploadStorage(this->mainView.indirect.data(), this->mainView.indirect.size() * sizeof(DrawIndirectCommand));
+    for (uint i = 0; i < this->shadowCascades.count; i++)
+        this->shadowViews[i].indirectRange = StreamBuffer::UploadStorage(this->shadowViews[i].indirect.data(), this->shadowViews[i].indirect.size() * sizeof(DrawIndirectCommand));
+    GeometryArena::ReserveInstances((uint32_t)this->instanceTransforms.size());
+}
 
-                glBindVertexArray(primitive.vao);
-                glDrawElements(GL_TRIANGLES, primitive.numIndices, primitive.indexType, (void*)(intptr_t)primitive.offset);
-            }
+//------------------------------------------------------------------------------
+/**
+    Draws a run of items with the material state already set, with one indirect multi draw
+    or with one draw per item when r_multi_draw_indirect is off.
+*/
+void
+RenderDevice::DrawMaterialRun(View const& view, View::MaterialRun const& run)
+{
+    if (Core::CVarReadInt(r_multi_draw_indirect) > 0)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, view.indirectRange.buffer);
+        GLintptr const offset = view.indirectRange.offset + run.firstItem * sizeof(DrawIndirectCommand);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)offset, run.numItems, 0);
+        return;
+    }
+
+    for (uint32_t i = run.firstItem; i < run.firstItem + run.numItems; i++)
+    {
+        DrawIndirectCommand const& cmd = view.indirect[i];
+        glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT, (void*)(intptr_t)(cmd.firstIndex * sizeof(uint32_t)), cmd.instanceCount, cmd.baseVertex, cmd.baseInstance);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Draws the sorted items with only the state alpha testing needs, for the shadow and depth prepass.
+*/
+void
+RenderDevice::DrawDepthOnly(View const& view, GLuint baseColorFactorLocation, GLuint alphaCutoffLocation)
+{
+    glUniform1i(Model::Material::TEXTURE_BASECOLOR, Model::Material::TEXTURE_BASECOLOR);
+    glActiveTexture(GL_TEXTURE0 + Model::Material::TEXTURE_BASECOLOR);
+
+    GLuint boundTexture = 0;
+    for (View::MaterialRun const& run : view.runs)
+    {
+        DrawItem const& item = view.items[run.firstItem];
+        Model::Material const& material = GetModel(view.batches[item.batch].modelId).meshes[item.mesh].primitives[item.primitive].material;
+
+        GLuint const texture = Render::TextureResource::GetTextureHandle(material.textures[Model::Material::TEXTURE_BASECOLOR]);
+        if (texture != boundTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            boundTexture = texture;
         }
+
+        glUniform4fv(baseColorFactorLocation, 1, &material.baseColorFactor[0]);
+        glUniform1f(alphaCutoffLocation, material.alphaMode == Model::Material::AlphaMode::Mask ? material.alphaCutoff : 0.0f);
+
+        this->DrawMaterialRun(view, run);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Fits the cascades to the main camera, done before preparing instances so that shadow casters can be culled.
+*/
+void
+RenderDevice::UpdateShadowCascades()
+{
+    // casters up to this far outside of a cascade, towards the sun, still cast into it
+    static constexpr float ShadowCasterDistance = 250.0f;
+
+    Camera const* const mainCamera = CameraManager::GetCamera(CAMERA_MAIN);
+    ComputeShadowCascades(this->shadowCascades, mainCamera->invView, mainCamera->projection, LightServer::globalLightDirection,
+        LightServer::GetNumShadowCascades(), LightServer::GetShadowMapSize(), LightServer::GetShadowDistance(), ShadowCasterDistance);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+RenderDevice::StaticShadowPass()
+{
+    uint shadowMapSize = LightServer::GetShadowMapSize();
+    glViewport(0, 0, shadowMapSize, shadowMapSize);
+    glBindFramebuffer(GL_FRAMEBUFFER, LightServer::GetGlobalShadowFramebuffer());
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    auto programHandle = Render::ShaderResource::GetProgramHandle(staticShadowProgram);
+    glUseProgram(programHandle);
+
+    GLuint baseColorFactorLocation = ShaderResource::GetUniformLocation(staticShadowProgram, "BaseColorFactor");
+    GLuint alphaCutoffLocation = ShaderResource::GetUniformLocation(staticShadowProgram, "AlphaCutoff");
+
+    // all models share the same vertex array, transforms are looked up per instance
+    glBindVertexArray(GeometryArena::GetVertexArray());
+    StreamBuffer::Bind(GL_SHADER_STORAGE_BUFFER, 5, this->instanceRange);
+
+    for (uint i = 0; i < this->shadowCascades.count; i++)
+    {
+        glNamedFramebufferTextureLayer(LightServer::GetGlobalShadowFramebuffer(), GL_DEPTH_ATTACHMENT, LightServer::GetGlobalShadowMapHandle(), 0, i);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        ShaderResource::SetUniform(staticShadowProgram, "ViewProjection", this->shadowCascades.viewProjections[i]);
+        this->DrawDepthOnly(this->shadowViews[i], baseColorFactorLocation, alphaCutoffLocation);
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -237,39 +495,16 @@ RenderDevice::StaticGeometryPrepass()
     // Models
     auto staticOpaquePrepassProgramHandle = Render::ShaderResource::GetProgramHandle(staticShadowProgram);
     glUseProgram(staticOpaquePrepassProgramHandle);
-    glUniformMatrix4fv(glGetUniformLocation(staticOpaquePrepassProgramHandle, "ViewProjection"), 1, false, &mainCamera->viewProjection[0][0]);
+    ShaderResource::SetUniform(staticShadowProgram, "ViewProjection", mainCamera->viewProjection);
     
-    GLuint baseColorFactorLocation = glGetUniformLocation(staticOpaquePrepassProgramHandle, "BaseColorFactor");
-    GLuint modelLocation = glGetUniformLocation(staticOpaquePrepassProgramHandle, "Model");
-    GLuint alphaCutoffLocation = glGetUniformLocation(staticOpaquePrepassProgramHandle, "AlphaCutoff");
-
-    // Opaque
-    for (auto const& cmd : this->drawCommands)
-    {
-        Model const& model = GetModel(cmd.modelId);
-        glUniformMatrix4fv(modelLocation, 1, false, &cmd.transform[0][0]);
-
-        for (auto const& mesh : model.meshes)
-        {
-            for (auto& primitiveId : mesh.opaquePrimitives)
-            {
-                auto& primitive = mesh.primitives[primitiveId];
-
-                glActiveTexture(GL_TEXTURE0 + Model::Material::TEXTURE_BASECOLOR);
-                glBindTexture(GL_TEXTURE_2D, Render::TextureResource::GetTextureHandle(primitive.material.textures[Model::Material::TEXTURE_BASECOLOR]));
-                glUniform1i(Model::Material::TEXTURE_BASECOLOR, Model::Material::TEXTURE_BASECOLOR);
-                glUniform4fv(baseColorFactorLocation, 1, &primitive.material.baseColorFactor[0]);
+    GLuint baseColorFactorLocation = ShaderResource::GetUniformLocation(staticShadowProgram, "BaseColorFactor");
+    GLuint alphaCutoffLocation = ShaderResource::GetUniformLocation(staticShadowProgram, "AlphaCutoff");
 
-                if (primitive.material.alphaMode == Model::Material::AlphaMode::Mask)
-                    glUniform1f(alphaCutoffLocation, primitive.material.alphaCutoff);
-                else
-                    glUniform1f(alphaCutoffLocation, 0);
+    // all models share the same vertex array, transforms are looked up per instance
+    glBindVertexArray(GeometryArena::GetVertexArray());
+    StreamBuffer::Bind(GL_SHADER_STORAGE_BUFFER, 5, this->instanceRange);
 
-                glBindVertexArray(primitive.vao);
-                glDrawElements(GL_TRIANGLES, primitive.numIndices, primitive.indexType, (void*)(intptr_t)primitive.offset);
-            }
-        }
-    }
+    this->DrawDepthOnly(this->mainView, baseColorFactorLocation, alphaCutoffLocation);
 
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 }
@@ -280,27 +515,29 @@ RenderDevice::StaticGeometryPrepass()
 void
 RenderDevice::LightCullingPass()
 {
+    // the lights are already in clusters, built on the cpu in LightServer::OnBeforeRender
+    if (LightServer::UseLightClusters())
+        return;
+
     GLuint lightCullingProgramHandle = ShaderResource::GetProgramHandle(lightCullingProgram);
     glUseProgram(lightCullingProgramHandle);
 
     Camera* const mainCamera = CameraManager::GetCamera(CAMERA_MAIN);
-    glUniformMatrix4fv(glGetUniformLocation(lightCullingProgramHandle, "View"), 1, false, &mainCamera->view[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(lightCullingProgramHandle, "Projection"), 1, false, &mainCamera->projection[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(lightCullingProgramHandle, "ViewProjection"), 1, false, &mainCamera->viewProjection[0][0]);
+    ShaderResource::SetUniform(lightCullingProgram, "View", mainCamera->view);
+    ShaderResource::SetUniform(lightCullingProgram, "Projection", mainCamera->projection);
+    ShaderResource::SetUniform(lightCullingProgram, "ViewProjection", mainCamera->viewProjection);
 
     // Bind depth map texture to texture location 20 (which will not be used by any model texture)
     glActiveTexture(GL_TEXTURE30);
-    glUniform1i(glGetUniformLocation(lightCullingProgramHandle, "DepthMap"), 30);
+    ShaderResource::SetUniform(lightCullingProgram, "DepthMap", 30);
     glBindTexture(GL_TEXTURE_2D, depthStencilBuffer);
 
-    glUniform1i(glGetUniformLocation(lightCullingProgramHandle, "NumPointLights"), LightServer::GetNumPointLights());
+    ShaderResource::SetUniform(lightCullingProgram, "NumPointLights", (GLint)LightServer::GetNumPointLights());
     
     // Bind shader storage buffer objects for the light and index buffers
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, LightServer::GetBuffer(LightServer::PointLightBuffer::POSITIONS));
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, LightServer::GetBuffer(LightServer::PointLightBuffer::RADII));
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, LightServer::GetBuffer(LightServer::PointLightBuffer::VISIBLE_INDICES));
+    LightServer::BindPointLightBuffers();
     
-    glUniform2ui(glGetUniformLocation(lightCullingProgramHandle, "NumTiles"), LightServer::GetWorkGroupsX(), LightServer::GetWorkGroupsY());
+    ShaderResource::SetUniform(lightCullingProgram, "NumTiles", glm::uvec2(LightServer::GetWorkGroupsX(), LightServer::GetWorkGroupsY()));
 
     glDispatchCompute(LightServer::GetWorkGroupsX(), LightServer::GetWorkGroupsY(), 1);
 
@@ -327,67 +564,63 @@ RenderDevice::StaticForwardPass()
     auto programHandle = Render::ShaderResource::GetProgramHandle(staticGeometryProgram);
     glUseProgram(programHandle);
 
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, LightServer::GetBuffer(LightServer::PointLightBuffer::POSITIONS));
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, LightServer::GetBuffer(LightServer::PointLightBuffer::COLORS));
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, LightServer::GetBuffer(LightServer::PointLightBuffer::RADII));
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, LightServer::GetBuffer(LightServer::PointLightBuffer::VISIBLE_INDICES));
+    LightServer::BindPointLightBuffers();
 
-    glUniform2ui(glGetUniformLocation(programHandle, "NumTiles"), LightServer::GetWorkGroupsX(), LightServer::GetWorkGroupsY());
-    glUniformMatrix4fv(glGetUniformLocation(programHandle, "ViewProjection"), 1, false, &mainCamera->viewProjection[0][0]);
+    ShaderResource::SetUniform(staticGeometryProgram, "NumTiles", glm::uvec2(LightServer::GetWorkGroupsX(), LightServer::GetWorkGroupsY()));
+    ShaderResource::SetUniform(staticGeometryProgram, "ViewProjection", mainCamera->viewProjection);
     
-    glUniform4fv(glGetUniformLocation(programHandle, "CameraPosition"), 1, &mainCamera->view[3][0]);
+    ShaderResource::SetUniform(staticGeometryProgram, "CameraPosition", mainCamera->view[3]);
 
     LightServer::Update(staticGeometryProgram);
 
     glActiveTexture(GL_TEXTURE16);
-    glBindTexture(GL_TEXTURE_2D, LightServer::GetGlobalShadowMapHandle());
-    glUniform1i(glGetUniformLocation(programHandle, "GlobalShadowMap"), 16);
-    Camera* globalShadowCamera = CameraManager::GetCamera(CAMERA_SHADOW);
-    glUniformMatrix4fv(glGetUniformLocation(programHandle, "GlobalShadowMatrix"), 1, false, &globalShadowCamera->viewProjection[0][0]);
-
-    GLuint baseColorFactorLocation = glGetUniformLocation(programHandle, "BaseColorFactor");
-    GLuint emissiveFactorLocation = glGetUniformLocation(programHandle, "EmissiveFactor");
-    GLuint metallicFactorLocation = glGetUniformLocation(programHandle, "MetallicFactor");
-    GLuint roughnessFactorLocation = glGetUniformLocation(programHandle, "RoughnessFactor");
-    GLuint modelLocation = glGetUniformLocation(programHandle, "Model");
-    GLuint alphaCutoffLocation = glGetUniformLocation(programHandle, "AlphaCutoff");
-
-    // Draw opaque first
-    for (auto const& cmd : this->drawCommands)
+    glBindTexture(GL_TEXTURE_2D_ARRAY, LightServer::GetGlobalShadowMapHandle());
+    ShaderResource::SetUniform(staticGeometryProgram, "GlobalShadowMap", 16);
+    ShaderResource::SetUniform(staticGeometryProgram, "GlobalShadowMatrices", this->shadowCascades.viewProjections, (GLsizei)this->shadowCascades.count);
+    ShaderResource::SetUniform(staticGeometryProgram, "NumShadowCascades", (GLint)this->shadowCascades.count);
+
+    GLuint baseColorFactorLocation = ShaderResource::GetUniformLocation(staticGeometryProgram, "BaseColorFactor");
+    GLuint emissiveFactorLocation = ShaderResource::GetUniformLocation(staticGeometryProgram, "EmissiveFactor");
+    GLuint metallicFactorLocation = ShaderResource::GetUniformLocation(staticGeometryProgram, "MetallicFactor");
+    GLuint roughnessFactorLocation = ShaderResource::GetUniformLocation(staticGeometryProgram, "RoughnessFactor");
+    GLuint alphaCutoffLocation = ShaderResource::GetUniformLocation(staticGeometryProgram, "AlphaCutoff");
+
+    // all models share the same vertex array, transforms are looked up per instance
+    glBindVertexArray(GeometryArena::GetVertexArray());
+    StreamBuffer::Bind(GL_SHADER_STORAGE_BUFFER, 5, this->instanceRange);
+
+    // the sampler uniforms never change, only the textures bound to their units
+    for (int i = 0; i < Model::Material::NUM_TEXTURES; i++)
+        glUniform1i(i, i);
+
+    // draw items are sorted by material, so state only changes between runs
+    GLuint boundTextures[Model::Material::NUM_TEXTURES] = {};
+    for (View::MaterialRun const& run : this->mainView.runs)
     {
-        Model const& model = GetModel(cmd.modelId);
-        glUniformMatrix4fv(modelLocation, 1, false, &cmd.transform[0][0]);
+        DrawItem const& item = this->mainView.items[run.firstItem];
+        Model::Material const& material = GetModel(this->mainView.batches[item.batch].modelId).meshes[item.mesh].primitives[item.primitive].material;
 
-        for (auto const& mesh : model.meshes)
+        for (int i = 0; i < Model::Material::NUM_TEXTURES; i++)
         {
-            for (auto& primitiveId : mesh.opaquePrimitives)
-            {
-                auto& primitive = mesh.primitives[primitiveId];
-
-                for (int i = 0; i < Model::Material::NUM_TEXTURES; i++)
-                {
-                    if (primitive.material.textures[i] != InvalidResourceId)
-                    {
-                        glActiveTexture(GL_TEXTURE0 + i);
-                        glBindTexture(GL_TEXTURE_2D, Render::TextureResource::GetTextureHandle(primitive.material.textures[i]));
-                        glUniform1i(i, i);
-                    }
-                }
+            if (material.textures[i] == InvalidResourceId)
+                continue;
 
-                glUniform4fv(baseColorFactorLocation, 1, &primitive.material.baseColorFactor[0]);
-                glUniform4fv(emissiveFactorLocation, 1, &primitive.material.emissiveFactor[0]);
-                glUniform1f(metallicFactorLocation, primitive.material.metallicFactor);
-                glUniform1f(roughnessFactorLocation, primitive.material.roughnessFactor);
-
-                if (primitive.material.alphaMode == Model::Material::AlphaMode::Mask)
-                    glUniform1f(alphaCutoffLocation, primitive.material.alphaCutoff);
-                else
-                    glUniform1f(alphaCutoffLocation, 0);
-
-                glBindVertexArray(primitive.vao);
-                glDrawElements(GL_TRIANGLES, primitive.numIndices, primitive.indexType, (void*)(intptr_t)primitive.offset);
+            GLuint const texture = Render::TextureResource::GetTextureHandle(material.textures[i]);
+            if (texture != boundTextures[i])
+            {
+                glActiveTexture(GL_TEXTURE0 + i);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                boundTextures[i] = texture;
             }
         }
+
+        glUniform4fv(baseColorFactorLocation, 1, &material.baseColorFactor[0]);
+        glUniform4fv(emissiveFactorLocation, 1, &material.emissiveFactor[0]);
+        glUniform1f(metallicFactorLocation, material.metallicFactor);
+        glUniform1f(roughnessFactorLocation, material.roughnessFactor);
+        glUniform1f(alphaCutoffLocation, material.alphaMode == Model::Material::AlphaMode::Mask ? material.alphaCutoff : 0.0f);
+
+        this->DrawMaterialRun(this->mainView, run);
     }
 }
 
@@ -421,7 +654,9 @@ RenderDevice::ParticlePass(float dt)
     ParticleSystem* particles = ParticleSystem::Instance();
     GLuint simProgramHandle = ShaderResource::GetProgramHandle(particles->particleSimComputeShaderId);
     glUseProgram(simProgramHandle);
-    glUniform1f(glGetUniformLocation(simProgramHandle, "TimeStep"), dt);
+    ShaderResource::SetUniform(particles->particleSimComputeShaderId, "TimeStep", dt);
+    GLint const emitterBlockBinding = ShaderResource::GetUniformBlockBinding(particles->particleSimComputeShaderId, "EmitterBlock");
+    GLint const randomLocation = ShaderResource::GetUniformLocation(particles->particleSimComputeShaderId, "Random");
     
     uint32_t readIndex = (particles->writeIndex + 1) % 2;
 
@@ -436,11 +671,9 @@ RenderDevice::ParticlePass(float dt)
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, emitter->bufColors[particles->writeIndex]);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, emitter->bufVelocities[particles->writeIndex]);
 
-        glBindBuffer(GL_UNIFORM_BUFFER, particles->emitterBlockUBO);
-        glBindBufferBase(GL_UNIFORM_BUFFER, 10, particles->emitterBlockUBO);
-        glBufferData(GL_UNIFORM_BUFFER, sizeof(ParticleEmitter::EmitterBlock), &emitter->data, GL_STATIC_DRAW);
+        StreamBuffer::Bind(GL_UNIFORM_BUFFER, emitterBlockBinding, StreamBuffer::UploadUniforms(&emitter->data, sizeof(ParticleEmitter::EmitterBlock)));
 
-        glUniform3ui(glGetUniformLocation(simProgramHandle, "Random"), Core::FastRandom(), Core::FastRandom(), Core::FastRandom());
+        glUniform3ui(randomLocation, Core::FastRandom(), Core::FastRandom(), Core::FastRandom());
 
         const int numWorkGroups[3] = {
             emitter->data.numParticles / 1024,
@@ -465,9 +698,9 @@ RenderDevice::ParticlePass(float dt)
     );
     glm::mat4 billboardViewProjection = mainCamera->projection * billboardView;
 
-    glUniformMatrix4fv(glGetUniformLocation(programHandle, "ViewProjection"), 1, false, &mainCamera->viewProjection[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(programHandle, "BillBoardViewProjection"), 1, false, &billboardViewProjection[0][0]);
-    GLuint particleOffsetLoc = glGetUniformLocation(programHandle, "ParticleOffset");
+    ShaderResource::SetUniform(particles->particleShaderId, "ViewProjection", mainCamera->viewProjection);
+    ShaderResource::SetUniform(particles->particleShaderId, "BillBoardViewProjection", billboardViewProjection);
+    GLuint particleOffsetLoc = ShaderResource::GetUniformLocation(particles->particleShaderId, "ParticleOffset");
 
     for (auto emitter : particles->emitters)
     { // DRAW
@@ -516,12 +749,19 @@ RenderDevice::Render(Display::Window* wnd, float dt)
 
     wnd->MakeCurrent();
 
+    StreamBuffer::BeginFrame();
     CameraManager::OnBeforeRender();
     LightServer::OnBeforeRender();
+    Instance()->UpdateShadowCascades();
+    Instance()->PrepareInstances();
+    Instance()->UploadInstances();
 
-    // Begin depth prepass renderpass
     int w, h;
     wnd->GetSize(w, h);
+    Instance()->RequestTextureMips(h);
+    TextureResource::UpdateTextureStreaming();
+
+    // Begin depth prepass renderpass
     glViewport(0, 0, w, h);
 
     Instance()->StaticGeometryPrepass();
@@ -558,6 +798,8 @@ RenderDevice::Render(Display::Window* wnd, float dt)
     Instance()->FinalizePass(wnd);
     // end finalization pass and present
 
+    StreamBuffer::EndFrame();
+
     Instance()->drawCommands.clear();
 }
 
@@ -11,6 +11,11 @@
 #include <vector>
 #include "render/window.h"
 #include "resourceid.h"
+#include "instancebatch.h"
+#include "drawqueue.h"
+#include "frustumcull.h"
+#include "streambuffer.h"
+#include "shadowcascades.h"
 
 namespace Render
 {
@@ -42,6 +47,8 @@ public:
 
     static void Init();
     static void Draw(ModelId model, glm::mat4 localToWorld);
+    /// append a command list recorded elsewhere, for example on a worker thread
+    static void Draw(std::vector<DrawCommand> const& commands);
     static void Render(Display::Window* wnd, float dt);
     static void SetSkybox(TextureResourceId tex);
 
@@ -58,14 +65,53 @@ private:
     } renderTargets;
     GLuint depthStencilBuffer; // GL_DEPTH24_STENCIL8
 
-    struct DrawCommand
-    {
-        ModelId modelId;
-        glm::mat4 transform;
-    };
-
     std::vector<DrawCommand> drawCommands;
+    /// world space bounds of drawCommands
+    BoundingSpheres commandBounds;
 
+    /// what one camera draws this frame, prepared off the GL thread and read by the passes
+    struct View
+    {
+        Frustum frustum;
+        glm::vec3 position;
+        std::vector<uint32_t> visible;
+        std::vector<DrawCommand> commands;
+        /// visible commands grouped by model
+        std::vector<InstanceBatch> batches;
+        std::vector<glm::mat4> transforms;
+        std::vector<float> batchDepths;
+        /// one item per primitive of every batch, sorted by state
+        std::vector<DrawItem> items;
+        DrawSortScratch sortScratch;
+        /// items [firstItem, firstItem + numItems) share a material
+        struct MaterialRun
+        {
+            uint32_t firstItem;
+            uint32_t numItems;
+        };
+        std::vector<MaterialRun> runs;
+        /// one indirect command per item, and their copy in the stream buffer
+        std::vector<DrawIndirectCommand> indirect;
+        StreamBuffer::Range indirectRange;
+    };
+    /// the main camera for the prepass and forward pass, one view per shadow cascade for the shadow pass
+    View mainView;
+    View shadowViews[MaxShadowCascades];
+    ShadowCascades shadowCascades;
+
+    /// transforms of all views, the shadow instances follow the main ones, cascade by cascade
+    std::vector<glm::mat4> instanceTransforms;
+    /// this frame's copy of instanceTransforms in the stream buffer
+    StreamBuffer::Range instanceRange;
+
+    void UpdateShadowCascades();
+    void PrepareInstances();
+    void PrepareView(View& view);
+    void UploadInstances();
+    void BuildIndirect(View& view);
+    void RequestTextureMips(int viewportHeight);
+    void DrawMaterialRun(View const& view, View::MaterialRun const& run);
+    void DrawDepthOnly(View const& view, GLuint baseColorFactorLocation, GLuint alphaCutoffLocation);
     void LightCullingPass();
     void StaticShadowPass();
     void StaticGeometryPrepass();
@@ -124,10 +124,56 @@ ShaderResource::CompileShaderProgram(std::vector<ShaderResourceId> const& shader
 
     Instance()->programs.push_back(program);
     Instance()->programShaders.push_back(shaders);
+    Instance()->programUniforms.emplace_back();
+    Instance()->programUniformBlocks.emplace_back();
+    ReflectProgram(program, Instance()->programUniforms.back(), Instance()->programUniformBlocks.back());
     printf("OK\n");
     return ShaderProgramId(Instance()->programs.size() - 1);
 }
 
+//------------------------------------------------------------------------------
+/**
+    Arrays are reported as "name[0]", they are added under their plain name as well.
+    Members of uniform blocks have no location and are left out.
+*/
+void
+ShaderResource::ReflectProgram(GLuint program, UniformTable& uniforms, UniformTable& blocks)
+{
+    GLint numUniforms = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::vector<GLchar> buffer(glm::max(maxNameLength, 1));
+    for (GLint i = 0; i < numUniforms; i++)
+    {
+        GLsizei length = 0;
+        glGetActiveUniformName(program, i, (GLsizei)buffer.size(), &length, buffer.data());
+        GLint const location = glGetUniformLocation(program, buffer.data());
+        if (location < 0)
+            continue;
+
+        std::string_view name(buffer.data(), length);
+        if (!uniforms.Insert(name, location))
+            printf("[SHADER WARNING]: uniform %s has the same name hash as another uniform\n", buffer.data());
+        if (name.size() > 3 && name.substr(name.size() - 3) == "[0]")
+            uniforms.Insert(name.substr(0, name.size() - 3), location);
+    }
+
+    GLint numBlocks = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength);
+    buffer.resize(glm::max(maxNameLength, 1));
+    for (GLint i = 0; i < numBlocks; i++)
+    {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program, i, (GLsizei)buffer.size(), &length, buffer.data());
+        GLint binding = 0;
+        glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+        if (!blocks.Insert(std::string_view(buffer.data(), length), binding))
+            printf("[SHADER WARNING]: uniform block %s has the same name hash as another block\n", buffer.data());
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -137,6 +183,123 @@ ShaderResource::GetProgramHandle(ShaderProgramId programId)
     return Instance()->programs[programId];
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+GLint
+ShaderResource::GetUniformLocation(ShaderProgramId programId, UniformName name)
+{
+    return Instance()->programUniforms[programId].Find(name);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+GLint
+ShaderResource::GetUniformBlockBinding(ShaderProgramId programId, UniformName name)
+{
+    return Instance()->programUniformBlocks[programId].Find(name);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, GLint value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniform1i(Instance()->programs[programId], location, value);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, GLuint value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniform1ui(Instance()->programs[programId], location, value);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, GLfloat value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniform1f(Instance()->programs[programId], location, value);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, glm::uvec2 const& value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniform2ui(Instance()->programs[programId], location, value.x, value.y);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, glm::uvec3 const& value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniform3ui(Instance()->programs[programId], location, value.x, value.y, value.z);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, glm::vec3 const& value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniform3fv(Instance()->programs[programId], location, 1, &value[0]);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, glm::vec4 const& value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniform4fv(Instance()->programs[programId], location, 1, &value[0]);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, glm::mat4 const& value)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniformMatrix4fv(Instance()->programs[programId], location, 1, GL_FALSE, &value[0][0]);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ShaderResource::SetUniform(ShaderProgramId programId, UniformName name, glm::mat4 const* values, GLsizei count)
+{
+    GLint const location = GetUniformLocation(programId, name);
+    if (location >= 0)
+        glProgramUniformMatrix4fv(Instance()->programs[programId], location, count, GL_FALSE, &values[0][0][0]);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -171,6 +334,8 @@ ShaderResource::ReloadShaders()
 
     Instance()->programs.clear();
     Instance()->programShaders.clear();
+    Instance()->programUniforms.clear();
+    Instance()->programUniformBlocks.clear();
 
     for (size_t i = 0; i < progs.size(); i++)
     {
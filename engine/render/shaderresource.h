@@ -10,6 +10,7 @@
 #include <vector>
 #include <string>
 #include "GL/glew.h"
+#include "uniformtable.h"
 
 namespace Render
 {
@@ -40,6 +41,24 @@ public:
 
     static GLuint GetProgramHandle(ShaderProgramId);
 
+    /// location of a uniform, -1 if the program has no such active uniform. Looked up in a table made at link time.
+    static GLint GetUniformLocation(ShaderProgramId, UniformName);
+    /// binding point of a uniform block, -1 if the program has no such block
+    static GLint GetUniformBlockBinding(ShaderProgramId, UniformName);
+
+    /// set a uniform by name, the program does not need to be in use. Does nothing if the uniform is not active.
+    static void SetUniform(ShaderProgramId, UniformName, GLint value);
+    static void SetUniform(ShaderProgramId, UniformName, GLuint value);
+    static void SetUniform(ShaderProgramId, UniformName, GLfloat value);
+    static void SetUniform(ShaderProgramId, UniformName, glm::uvec2 const& value);
+    static void SetUniform(ShaderProgramId, UniformName, glm::uvec3 const& value);
+    static void SetUniform(ShaderProgramId, UniformName, glm::vec3 const& value);
+    static void SetUniform(ShaderProgramId, UniformName, glm::vec4 const& value);
+    static void SetUniform(ShaderProgramId, UniformName, glm::mat4 const& value);
+    /// set the first count elements of a uniform array
+    static void SetUniform(ShaderProgramId, UniformName, glm::mat4 const* values, GLsizei count);
+
+    /// recompile all shaders and programs, program ids stay the same and their uniform tables are rebuilt
     static void ReloadShaders();
 
 private:
@@ -52,6 +71,10 @@ private:
     // ShaderProgramId
     std::vector<std::vector<ShaderResourceId>> programShaders;
     std::vector<GLuint> programs;
+    std::vector<UniformTable> programUniforms;
+    std::vector<UniformTable> programUniformBlocks;
+
+    static void ReflectProgram(GLuint program, UniformTable& uniforms, UniformTable& blocks);
 };
 
 
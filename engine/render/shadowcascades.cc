@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------------
+//  shadowcascades.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "shadowcascades.h"
+
+namespace Render
+{
+
+//------------------------------------------------------------------------------
+/**
+	The practical split scheme, see GPU Gems 3 chapter 10.
+*/
+void
+ComputeCascadeSplits(float nearPlane, float farPlane, uint count, float lambda, float* splits)
+{
+	for (uint i = 0; i < count; i++)
+	{
+		float const t = float(i + 1) / float(count);
+		float const logarithmic = nearPlane * glm::pow(farPlane / nearPlane, t);
+		float const uniform = nearPlane + (farPlane - nearPlane) * t;
+		splits[i] = glm::mix(uniform, logarithmic, lambda);
+	}
+	// no rounding gaps at the end
+	splits[count - 1] = farPlane;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+glm::mat4
+ComputeCascadeViewProjection(glm::mat4 const& invView, glm::mat4 const& projection, float sliceNear, float sliceFar, glm::vec3 const& lightDirection, uint resolution, float casterDistance)
+{
+	// The slice corners are at (±d / P00, ±d / P11, -d). The smallest enclosing sphere is centered on the
+	// view axis where the near and far corners are equally far away, or at the far plane if that is behind it.
+	float const k2 = 1.0f / (projection[0][0] * projection[0][0]) + 1.0f / (projection[1][1] * projection[1][1]);
+	float const centerDepth = glm::min(0.5f * (sliceNear + sliceFar) * (1.0f + k2), sliceFar);
+	float radius = glm::sqrt((sliceFar - centerDepth) * (sliceFar - centerDepth) + sliceFar * sliceFar * k2);
+	// rounded up so that float noise in the radius does not change the texel size
+	radius = glm::ceil(radius * 16.0f) / 16.0f;
+	glm::vec3 const center = glm::vec3(invView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+
+	// a fixed rotation, only the translation follows the camera
+	glm::vec3 const up = glm::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 const lightView = glm::lookAt(glm::vec3(0.0f), -lightDirection, up);
+
+	glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+	float const texelSize = 2.0f * radius / float(resolution);
+	lightCenter.x = glm::floor(lightCenter.x / texelSize) * texelSize;
+	lightCenter.y = glm::floor(lightCenter.y / texelSize) * texelSize;
+
+	// light space looks down -z, the light is towards +z
+	glm::mat4 const lightProjection = glm::ortho(
+		lightCenter.x - radius, lightCenter.x + radius,
+		lightCenter.y - radius, lightCenter.y + radius,
+		-lightCenter.z - radius - casterDistance, -lightCenter.z + radius);
+	return lightProjection * lightView;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ComputeShadowCascades(ShadowCascades& cascades, glm::mat4 const& invView, glm::mat4 const& projection, glm::vec3 const& lightDirection, uint count, uint resolution, float shadowDistance, float casterDistance)
+{
+	// near plane of a GL perspective projection
+	float const nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+	float const farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+
+	cascades.count = glm::clamp(count, 1u, MaxShadowCascades);
+	ComputeCascadeSplits(nearPlane, glm::min(shadowDistance, farPlane), cascades.count, 0.75f, cascades.splits);
+
+	glm::vec3 const direction = glm::normalize(lightDirection);
+	float sliceNear = nearPlane;
+	for (uint i = 0; i < cascades.count; i++)
+	{
+		cascades.viewProjections[i] = ComputeCascadeViewProjection(invView, projection, sliceNear, cascades.splits[i], direction, resolution, casterDistance);
+		sliceNear = cascades.splits[i];
+	}
+}
+
+} // namespace Render
@@ -0,0 +1,48 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file shadowcascades.h
+
+	Cascaded shadow maps for the directional light. The view depth range is split
+	into slices and each slice gets its own orthographic shadow projection.
+	Only math lives here, the shadow maps are owned by the LightServer.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+
+namespace Render
+{
+
+/// must be the same as MAX_SHADOW_CASCADES in lights.glsl
+constexpr uint MaxShadowCascades = 4;
+
+struct ShadowCascades
+{
+	uint count = 0;
+	/// view depth at which each cascade ends
+	float splits[MaxShadowCascades] = {};
+	/// world to shadow clip space, per cascade
+	glm::mat4 viewProjections[MaxShadowCascades];
+};
+
+/**
+	Far view depth of each of count slices between nearPlane and farPlane. Lambda blends from
+	uniform splits at 0 to logarithmic splits at 1.
+*/
+void ComputeCascadeSplits(float nearPlane, float farPlane, uint count, float lambda, float* splits);
+
+/**
+	Orthographic shadow projection covering the part of a symmetric perspective camera between two
+	view depths. The projection is sized to a bounding sphere of that slice, so it does not change
+	when the camera turns, and it moves in whole shadow map texels, so edges do not shimmer when the
+	camera moves. The volume reaches casterDistance further towards the light than the sphere.
+	lightDirection points towards the light.
+*/
+glm::mat4 ComputeCascadeViewProjection(glm::mat4 const& invView, glm::mat4 const& projection, float sliceNear, float sliceFar, glm::vec3 const& lightDirection, uint resolution, float casterDistance);
+
+/// splits and projections of count cascades covering the camera up to shadowDistance
+void ComputeShadowCascades(ShadowCascades& cascades, glm::mat4 const& invView, glm::mat4 const& projection, glm::vec3 const& lightDirection, uint count, uint resolution, float shadowDistance, float casterDistance);
+
+} // namespace Render
@@ -0,0 +1,215 @@
+//------------------------------------------------------------------------------
+//  streambuffer.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "streambuffer.h"
+#include <vector>
+
+namespace Render
+{
+
+namespace StreamBuffer
+{
+
+static constexpr GLsizeiptr InitialSectionSize = 8 << 20;
+/// ranges are never empty, binding a zero sized range is an error
+static constexpr GLsizeiptr MinRangeSize = 16;
+
+static GLuint buffer = 0;
+static uint8_t* mapped = nullptr;
+static GLsizeiptr sectionSize = 0;
+static GLsync fences[NumFrames] = {};
+static uint32_t frame = 0;
+static GLsizeiptr head = 0;
+static GLint uniformAlignment = 256;
+static GLint storageAlignment = 256;
+
+/// buffers replaced by a larger one, kept mapped until the gpu is done with them
+struct RetiredBuffer
+{
+	GLuint buffer;
+	/// issued at the end of the frame the buffer was replaced in
+	GLsync fence;
+};
+static std::vector<RetiredBuffer> retired;
+
+//------------------------------------------------------------------------------
+/**
+	The previous buffer is retired rather than deleted, ranges allocated from it earlier in the
+	frame are still written and bound after this.
+*/
+static void
+CreateBuffer(GLsizeiptr newSectionSize)
+{
+	if (buffer != 0)
+		retired.push_back({ buffer, nullptr });
+
+	sectionSize = newSectionSize;
+	GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, sectionSize * NumFrames, nullptr, flags);
+	mapped = (uint8_t*)glMapNamedBufferRange(buffer, 0, sectionSize * NumFrames, flags);
+	n_assert(mapped != nullptr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Create()
+{
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+	CreateBuffer(InitialSectionSize);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Destroy()
+{
+	for (GLsync& fence : fences)
+	{
+		if (fence != nullptr)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+	for (RetiredBuffer& old : retired)
+	{
+		if (old.fence != nullptr)
+			glDeleteSync(old.fence);
+		glDeleteBuffers(1, &old.buffer);
+	}
+	retired.clear();
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	mapped = nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BeginFrame()
+{
+	frame = (frame + 1) % NumFrames;
+	head = 0;
+
+	// retired buffers go as soon as the last frame using them is done, without waiting
+	for (size_t i = 0; i < retired.size(); i++)
+	{
+		RetiredBuffer& old = retired[i];
+		if (old.fence == nullptr)
+			continue;
+		GLenum const status = glClientWaitSync(old.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue;
+		glDeleteSync(old.fence);
+		glDeleteBuffers(1, &old.buffer);
+		retired[i--] = retired.back();
+		retired.pop_back();
+	}
+
+	GLsync& fence = fences[frame];
+	if (fence == nullptr)
+		return;
+
+	// only flush on the first try, the fence was issued frames ago and usually has signaled
+	GLbitfield waitFlags = 0;
+	while (glClientWaitSync(fence, waitFlags, 1000000) == GL_TIMEOUT_EXPIRED)
+		waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+EndFrame()
+{
+	n_assert(fences[frame] == nullptr);
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	for (RetiredBuffer& old : retired)
+	{
+		if (old.fence == nullptr)
+			old.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	A full section is replaced by a buffer with twice the section size. Ranges handed out
+	earlier in the frame stay valid until the frame is over, the old buffer is retired and
+	only deleted once the gpu is done with it.
+*/
+Range
+Allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+	size = glm::max(size, MinRangeSize);
+	GLsizeiptr offset = (head + alignment - 1) / alignment * alignment;
+	if (offset + size > sectionSize)
+	{
+		GLsizeiptr newSectionSize = sectionSize * 2;
+		while (newSectionSize < size)
+			newSectionSize *= 2;
+		n_warning("StreamBuffer: frame section full, growing to %lld bytes\n", (long long)newSectionSize);
+
+		// the new buffer is not used by the gpu yet, none of the old fences apply
+		for (GLsync& fence : fences)
+		{
+			if (fence != nullptr)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+		CreateBuffer(newSectionSize);
+		offset = 0;
+	}
+
+	head = offset + size;
+
+	Range range;
+	range.buffer = buffer;
+	range.offset = sectionSize * frame + offset;
+	range.size = size;
+	range.data = mapped + range.offset;
+	return range;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Range
+UploadStorage(void const* data, GLsizeiptr size)
+{
+	Range range = Allocate(size, storageAlignment);
+	if (size > 0)
+		memcpy(range.data, data, size);
+	return range;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Range
+UploadUniforms(void const* data, GLsizeiptr size)
+{
+	Range range = Allocate(size, uniformAlignment);
+	if (size > 0)
+		memcpy(range.data, data, size);
+	return range;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Bind(GLenum target, GLuint binding, Range const& range)
+{
+	glBindBufferRange(target, binding, range.buffer, range.offset, range.size);
+}
+
+} // namespace StreamBuffer
+} // namespace Render
@@ -0,0 +1,56 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file streambuffer.h
+
+	Ring buffer for data that is written by the cpu every frame and read by the gpu in
+	the same frame, such as instance transforms and light data.
+
+	One buffer is persistently and coherently mapped and split into a section per frame in
+	flight. Each frame allocates linearly from its own section. A fence at the end of the
+	frame guards the section, and it is only waited on when the section comes around again,
+	so writing never stalls on the driver and nothing is reallocated.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "GL/glew.h"
+
+namespace Render
+{
+
+namespace StreamBuffer
+{
+	/// frames the cpu may be ahead of the gpu
+	static constexpr uint32_t NumFrames = 3;
+
+	/// part of the stream buffer, valid for the frame it was allocated in
+	struct Range
+	{
+		GLuint buffer = 0;
+		GLintptr offset = 0;
+		GLsizeiptr size = 0;
+		void* data = nullptr;
+	};
+
+	void Create();
+	void Destroy();
+
+	/// wait until the gpu is done with the section of this frame and start allocating from it
+	void BeginFrame();
+	/// fence the section after the last command reading it
+	void EndFrame();
+
+	/// allocate with an offset that is a multiple of the alignment, grows the buffer if the section is full
+	Range Allocate(GLsizeiptr size, GLsizeiptr alignment);
+	/// allocate and copy size bytes, aligned for binding as a shader storage buffer
+	Range UploadStorage(void const* data, GLsizeiptr size);
+	/// allocate and copy size bytes, aligned for binding as a uniform buffer
+	Range UploadUniforms(void const* data, GLsizeiptr size);
+
+	/// bind a range to an indexed target such as GL_SHADER_STORAGE_BUFFER or GL_UNIFORM_BUFFER
+	void Bind(GLenum target, GLuint binding, Range const& range);
+
+} // namespace StreamBuffer
+} // namespace Render
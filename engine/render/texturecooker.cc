@@ -0,0 +1,499 @@
+//------------------------------------------------------------------------------
+//  texturecooker.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "texturecooker.h"
+#include "stb_image.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace Render
+{
+namespace TextureCooker
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint32_t
+BlockSize(Format format)
+{
+	return format == Format::BC1 ? 8 : 16;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+size_t
+MipSize(Format format, uint32_t width, uint32_t height)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockSize(format);
+}
+
+//------------------------------------------------------------------------------
+/**
+	FNV-1a over the source, started from the version and usage.
+*/
+uint64_t
+HashSource(void const* data, size_t bytes, Usage usage)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto const mix = [&hash](uint8_t byte)
+	{
+		hash ^= byte;
+		hash *= 1099511628211ull;
+	};
+	for (uint32_t value : { Version, (uint32_t)usage })
+	{
+		for (int i = 0; i < 4; i++)
+			mix((uint8_t)(value >> (i * 8)));
+	}
+	uint8_t const* bytesIn = (uint8_t const*)data;
+	for (size_t i = 0; i < bytes; i++)
+		mix(bytesIn[i]);
+	return hash;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+std::string
+CachePath(std::string const& cacheFolder, uint64_t hash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.ctex", (unsigned long long)hash);
+	return cacheFolder + "/" + name;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline uint16_t
+PackRGB565(glm::vec3 const& color)
+{
+	glm::vec3 const c = glm::clamp(color, 0.0f, 255.0f);
+	uint32_t const r = (uint32_t)(c.r * (31.0f / 255.0f) + 0.5f);
+	uint32_t const g = (uint32_t)(c.g * (63.0f / 255.0f) + 0.5f);
+	uint32_t const b = (uint32_t)(c.b * (31.0f / 255.0f) + 0.5f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline glm::vec3
+UnpackRGB565(uint16_t color)
+{
+	uint32_t const r = (color >> 11) & 31;
+	uint32_t const g = (color >> 5) & 63;
+	uint32_t const b = color & 31;
+	return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+//------------------------------------------------------------------------------
+/**
+	Endpoints are the extremes of the colors along their principal axis, pulled in a little
+	since the extremes are rarely hit exactly. Always uses the four color mode, which BC3
+	requires and which is the better choice for opaque BC1 anyway.
+*/
+void
+EncodeBC1Block(uint8_t const rgba[64], uint8_t out[8])
+{
+	glm::vec3 colors[16];
+	glm::vec3 mean(0.0f);
+	for (int i = 0; i < 16; i++)
+	{
+		colors[i] = glm::vec3(rgba[i * 4 + 0], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+		mean += colors[i];
+	}
+	mean /= 16.0f;
+
+	float cov[6] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		glm::vec3 const d = colors[i] - mean;
+		cov[0] += d.r * d.r; cov[1] += d.r * d.g; cov[2] += d.r * d.b;
+		cov[3] += d.g * d.g; cov[4] += d.g * d.b; cov[5] += d.b * d.b;
+	}
+
+	// a few power iterations are enough to find the dominant axis
+	glm::vec3 axis(1.0f, 1.0f, 1.0f);
+	for (int iteration = 0; iteration < 4; iteration++)
+	{
+		axis = glm::vec3(
+			cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+			cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+			cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b);
+		float const length = glm::length(axis);
+		if (length < 1e-6f)
+		{
+			axis = glm::vec3(0.0f);
+			break;
+		}
+		axis /= length;
+	}
+
+	float minT = 0.0f, maxT = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float const t = glm::dot(colors[i] - mean, axis);
+		minT = glm::min(minT, t);
+		maxT = glm::max(maxT, t);
+	}
+	float const inset = (maxT - minT) / 16.0f;
+	uint16_t c0 = PackRGB565(mean + axis * (maxT - inset));
+	uint16_t c1 = PackRGB565(mean + axis * (minT + inset));
+	if (c0 < c1)
+		std::swap(c0, c1);
+
+	uint32_t indices = 0;
+	if (c0 != c1)
+	{
+		glm::vec3 const e0 = UnpackRGB565(c0);
+		glm::vec3 const e1 = UnpackRGB565(c1);
+		glm::vec3 const palette[4] = { e0, e1, (2.0f * e0 + e1) / 3.0f, (e0 + 2.0f * e1) / 3.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t best = 0;
+			float bestDistance = FLT_MAX;
+			for (uint32_t p = 0; p < 4; p++)
+			{
+				glm::vec3 const d = colors[i] - palette[p];
+				float const distance = glm::dot(d, d);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= best << (i * 2);
+		}
+	}
+
+	out[0] = (uint8_t)(c0 & 0xFF);
+	out[1] = (uint8_t)(c0 >> 8);
+	out[2] = (uint8_t)(c1 & 0xFF);
+	out[3] = (uint8_t)(c1 >> 8);
+	for (int i = 0; i < 4; i++)
+		out[4 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+//------------------------------------------------------------------------------
+/**
+	Uses the eight value mode between the block's minimum and maximum.
+*/
+void
+EncodeBC4Block(uint8_t const* values, uint32_t stride, uint8_t out[8])
+{
+	uint8_t minValue = 255, maxValue = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		minValue = glm::min(minValue, values[i * stride]);
+		maxValue = glm::max(maxValue, values[i * stride]);
+	}
+
+	out[0] = maxValue;
+	out[1] = minValue;
+	uint64_t indices = 0;
+	if (maxValue != minValue)
+	{
+		float const scale = 7.0f / float(maxValue - minValue);
+		for (int i = 0; i < 16; i++)
+		{
+			// step 0 is the maximum and step 7 the minimum, the steps between are indices 2 to 7
+			uint32_t const step = (uint32_t)(float(maxValue - values[i * stride]) * scale + 0.5f);
+			uint64_t const index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+			indices |= index << (i * 3);
+		}
+	}
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static float
+SRGBToLinear(uint8_t value)
+{
+	float const c = value / 255.0f;
+	return c <= 0.04045f ? c / 12.92f : glm::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static uint8_t
+LinearToSRGB(float value)
+{
+	float const c = value <= 0.0031308f ? value * 12.92f : 1.055f * glm::pow(value, 1.0f / 2.4f) - 0.055f;
+	return (uint8_t)glm::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f);
+}
+
+//------------------------------------------------------------------------------
+/**
+	Halves an image with a box filter. Color is averaged in linear space for sRGB textures,
+	and normals are renormalized so that they don't shorten towards the small mips.
+*/
+static void
+Downsample(std::vector<uint8_t> const& src, uint32_t width, uint32_t height, Usage usage, std::vector<uint8_t>& dst)
+{
+	static float const* const toLinear = []
+	{
+		static float table[256];
+		for (int i = 0; i < 256; i++)
+			table[i] = SRGBToLinear((uint8_t)i);
+		return table;
+	}();
+
+	uint32_t const dstWidth = glm::max(width / 2, 1u);
+	uint32_t const dstHeight = glm::max(height / 2, 1u);
+	dst.resize((size_t)dstWidth * dstHeight * 4);
+	for (uint32_t y = 0; y < dstHeight; y++)
+	{
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			glm::vec4 sum(0.0f);
+			for (uint32_t sy = 0; sy < 2; sy++)
+			{
+				for (uint32_t sx = 0; sx < 2; sx++)
+				{
+					uint32_t const px = glm::min(x * 2 + sx, width - 1);
+					uint32_t const py = glm::min(y * 2 + sy, height - 1);
+					uint8_t const* p = &src[((size_t)py * width + px) * 4];
+					if (usage == Usage::ColorSRGB)
+						sum += glm::vec4(toLinear[p[0]], toLinear[p[1]], toLinear[p[2]], p[3] / 255.0f);
+					else
+						sum += glm::vec4(p[0], p[1], p[2], p[3]) / 255.0f;
+				}
+			}
+			sum *= 0.25f;
+
+			uint8_t* d = &dst[((size_t)y * dstWidth + x) * 4];
+			if (usage == Usage::ColorSRGB)
+			{
+				d[0] = LinearToSRGB(sum.r);
+				d[1] = LinearToSRGB(sum.g);
+				d[2] = LinearToSRGB(sum.b);
+			}
+			else
+			{
+				glm::vec3 color = glm::vec3(sum);
+				if (usage == Usage::NormalMap)
+				{
+					glm::vec3 const n = color * 2.0f - 1.0f;
+					float const length = glm::length(n);
+					color = length > 1e-6f ? n / length * 0.5f + 0.5f : glm::vec3(0.5f, 0.5f, 1.0f);
+				}
+				d[0] = (uint8_t)(color.r * 255.0f + 0.5f);
+				d[1] = (uint8_t)(color.g * 255.0f + 0.5f);
+				d[2] = (uint8_t)(color.b * 255.0f + 0.5f);
+			}
+			d[3] = (uint8_t)(sum.a * 255.0f + 0.5f);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+	Blocks reaching over the edge of the image repeat the last row and column.
+*/
+static void
+EncodeMip(uint8_t const* rgba, uint32_t width, uint32_t height, Format format, uint8_t* out)
+{
+	for (uint32_t by = 0; by < (height + 3) / 4; by++)
+	{
+		for (uint32_t bx = 0; bx < (width + 3) / 4; bx++)
+		{
+			uint8_t block[64];
+			for (uint32_t y = 0; y < 4; y++)
+			{
+				for (uint32_t x = 0; x < 4; x++)
+				{
+					uint32_t const px = glm::min(bx * 4 + x, width - 1);
+					uint32_t const py = glm::min(by * 4 + y, height - 1);
+					memcpy(&block[(y * 4 + x) * 4], &rgba[((size_t)py * width + px) * 4], 4);
+				}
+			}
+
+			switch (format)
+			{
+			case Format::BC1:
+				EncodeBC1Block(block, out);
+				break;
+			case Format::BC3:
+				EncodeBC4Block(block + 3, 4, out);
+				EncodeBC1Block(block, out + 8);
+				break;
+			case Format::BC5:
+				EncodeBC4Block(block + 0, 4, out);
+				EncodeBC4Block(block + 1, 4, out + 8);
+				break;
+			}
+			out += BlockSize(format);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Encode(uint8_t const* rgba, uint32_t width, uint32_t height, Usage usage, CookedTexture& out)
+{
+	Format format = Format::BC1;
+	if (usage == Usage::NormalMap)
+	{
+		format = Format::BC5;
+	}
+	else
+	{
+		for (size_t i = 0; i < (size_t)width * height; i++)
+		{
+			if (rgba[i * 4 + 3] != 255)
+			{
+				format = Format::BC3;
+				break;
+			}
+		}
+	}
+
+	uint32_t numMips = 1;
+	size_t size = MipSize(format, width, height);
+	for (uint32_t w = width, h = height; w > 1 || h > 1; numMips++)
+	{
+		w = glm::max(w / 2, 1u);
+		h = glm::max(h / 2, 1u);
+		size += MipSize(format, w, h);
+	}
+
+	out.header = Header();
+	out.header.format = format;
+	out.header.usage = usage;
+	out.header.width = width;
+	out.header.height = height;
+	out.header.numMips = numMips;
+	out.file.Close();
+	out.storage.resize(size);
+
+	std::vector<uint8_t> level(rgba, rgba + (size_t)width * height * 4);
+	std::vector<uint8_t> next;
+	uint8_t* dst = out.storage.data();
+	for (uint32_t mip = 0, w = width, h = height; mip < numMips; mip++)
+	{
+		EncodeMip(level.data(), w, h, format, dst);
+		dst += MipSize(format, w, h);
+		if (mip + 1 < numMips)
+		{
+			Downsample(level, w, h, usage, next);
+			level.swap(next);
+			w = glm::max(w / 2, 1u);
+			h = glm::max(h / 2, 1u);
+		}
+	}
+	out.data = out.storage.data();
+	out.size = out.storage.size();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ReadCache(std::string const& path, CookedTexture& out)
+{
+	Core::MappedFile file;
+	if (!file.Open(path) || file.GetSize() < sizeof(Header))
+		return false;
+
+	Header header;
+	memcpy(&header, file.GetData(), sizeof(Header));
+	if (header.magic != Magic || header.version != Version || header.numMips == 0)
+		return false;
+
+	size_t expected = 0;
+	for (uint32_t mip = 0, w = header.width, h = header.height; mip < header.numMips; mip++)
+	{
+		expected += MipSize(header.format, w, h);
+		w = glm::max(w / 2, 1u);
+		h = glm::max(h / 2, 1u);
+	}
+	if (file.GetSize() != sizeof(Header) + expected)
+		return false;
+
+	out.header = header;
+	out.storage.clear();
+	out.file = std::move(file);
+	out.data = (uint8_t const*)out.file.GetData() + sizeof(Header);
+	out.size = expected;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+WriteCache(std::string const& path, CookedTexture const& texture)
+{
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+	// unique per thread, two loaders may cook the same image at the same time
+	std::string const temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		if (!stream)
+			return false;
+		stream.write((char const*)&texture.header, sizeof(Header));
+		stream.write((char const*)texture.data, (std::streamsize)texture.size);
+		if (!stream)
+			return false;
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+Cook(void const* source, size_t bytes, Usage usage, std::string const& cacheFolder, CookedTexture& out)
+{
+	uint64_t const hash = HashSource(source, bytes, usage);
+	std::string const path = CachePath(cacheFolder, hash);
+	if (ReadCache(path, out) && out.header.sourceHash == hash)
+		return true;
+
+	int width, height, channels;
+	unsigned char* pixels = stbi_load_from_memory((stbi_uc const*)source, (int)bytes, &width, &height, &channels, 4);
+	if (pixels == nullptr)
+		return false;
+	Encode(pixels, (uint32_t)width, (uint32_t)height, usage, out);
+	stbi_image_free(pixels);
+	out.header.sourceHash = hash;
+
+	// a read only folder only costs the next run the encoding again
+	if (!WriteCache(path, out))
+		n_warning("Could not write texture cache file '%s'\n", path.c_str());
+	return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+CookFile(std::string const& path, Usage usage, std::string const& cacheFolder, CookedTexture& out)
+{
+	Core::MappedFile file;
+	if (!file.Open(path))
+		return false;
+	return Cook(file.GetData(), file.GetSize(), usage, cacheFolder, out);
+}
+
+} // namespace TextureCooker
+} // namespace Render
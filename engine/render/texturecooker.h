@@ -0,0 +1,103 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file texturecooker.h
+
+	Turns PNG and JPG images into block compressed textures with a full mip chain,
+	and keeps the results in an on-disk cache keyed by a hash of the source bytes,
+	so an image is only ever encoded once. Nothing in here touches GL, the
+	TextureResource uploads the mips as they are.
+
+	Cache files are a Header followed by the mips from largest to smallest, back to
+	back, each in the layout glCompressedTexImage2D takes.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/mappedfile.h"
+#include <string>
+#include <vector>
+
+namespace Render
+{
+
+namespace TextureCooker
+{
+	/// block compressed formats the cooker emits, all use 4x4 pixel blocks
+	enum class Format : uint32_t
+	{
+		BC1, // rgb, 8 bytes per block
+		BC3, // rgba, 16 bytes per block
+		BC5, // two channels for normal maps, 16 bytes per block
+	};
+
+	/// how the texture is sampled, decides the format and how mips are filtered
+	enum class Usage : uint32_t
+	{
+		Color,
+		ColorSRGB,
+		NormalMap,
+	};
+
+	/// bump when the encoder or the file layout changes, older cache files are then cooked again
+	constexpr uint32_t Version = 1;
+	constexpr uint32_t Magic = 'XTCB';
+	/// where the engine keeps cooked textures between runs, relative to the working directory
+	constexpr char const* DefaultCacheFolder = "cache/textures";
+
+	struct Header
+	{
+		uint32_t magic = Magic;
+		uint32_t version = Version;
+		Format format = Format::BC1;
+		Usage usage = Usage::Color;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t numMips = 0;
+		uint32_t pad = 0;
+		uint64_t sourceHash = 0;
+	};
+
+	struct CookedTexture
+	{
+		Header header;
+		/// all mips, either in the mapped cache file or in storage
+		uint8_t const* data = nullptr;
+		size_t size = 0;
+
+		Core::MappedFile file;
+		std::vector<uint8_t> storage;
+
+		bool IsValid() const { return this->data != nullptr; }
+	};
+
+	/// bytes of one block
+	uint32_t BlockSize(Format format);
+	/// bytes of a mip of the given size
+	size_t MipSize(Format format, uint32_t width, uint32_t height);
+
+	/// key of a source image in the cache, includes the usage since it changes the result
+	uint64_t HashSource(void const* data, size_t bytes, Usage usage);
+	/// file of a key in the cache folder
+	std::string CachePath(std::string const& cacheFolder, uint64_t hash);
+
+	/// encode width * height rgba8 pixels with a full mip chain into out
+	void Encode(uint8_t const* rgba, uint32_t width, uint32_t height, Usage usage, CookedTexture& out);
+
+	/// encode one 4x4 block of rgba8 pixels, the alpha of BC1 is ignored
+	void EncodeBC1Block(uint8_t const rgba[64], uint8_t out[8]);
+	/// encode one 4x4 block of single channel values, read with the given stride in bytes
+	void EncodeBC4Block(uint8_t const* values, uint32_t stride, uint8_t out[8]);
+
+	/// map a cooked file, fails if it is missing, truncated or from another version
+	bool ReadCache(std::string const& path, CookedTexture& out);
+	/// write a cooked texture, through a temporary file so that readers never see half a file
+	bool WriteCache(std::string const& path, CookedTexture const& texture);
+
+	/// cook an encoded PNG or JPG, reading the cache if it was cooked before and filling it if not
+	bool Cook(void const* source, size_t bytes, Usage usage, std::string const& cacheFolder, CookedTexture& out);
+	bool CookFile(std::string const& path, Usage usage, std::string const& cacheFolder, CookedTexture& out);
+
+} // namespace TextureCooker
+} // namespace Render
@@ -3,10 +3,10 @@
 //  (C) 2019 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 #include "textureresource.h"
+#include "core/cvar.h"
 #include <cstring>
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
-#define STBI_NO_SIMD
 #include "stb_image.h"
 #include "stb_image_write.h"
 
@@ -36,6 +36,13 @@ struct ImageLoadResult
 
 static std::vector<LoadTask> loadingTasks;
 
+static Core::CVar* r_texture_compression = nullptr;
+static Core::CVar* r_texture_streaming = nullptr;
+static Core::CVar* r_texture_budget = nullptr;
+
+/// at most this much is uploaded by the texture streaming per frame, unless a single mip is larger
+static constexpr size_t StreamingUploadBytes = 16 << 20;
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -88,6 +95,10 @@ TextureResource::Create()
 {
     assert(TextureResource::instance == nullptr);
     TextureResource::instance = new TextureResource();
+
+    r_texture_compression = Core::CVarCreate(Core::CVar_Int, "r_texture_compression", "1", "Cook loaded images into block compressed textures, cached in cache/textures");
+    r_texture_streaming = Core::CVarCreate(Core::CVar_Int, "r_texture_streaming", "1", "Stream the mips of compressed textures loaded from now on by their size on screen");
+    r_texture_budget = Core::CVarCreate(Core::CVar_Int, "r_texture_budget", "512", "Megabytes of streamed texture mips that may be resident, not counting the always resident small mips");
     
     // setup default textures
     ImageCreateInfo info;
@@ -243,33 +254,71 @@ TextureResourceId
 TextureResource::LoadTexture(const char * path, MagFilter mag, MinFilter min, WrappingMode wrapModeS, WrappingMode wrapModeT, bool sRGB = false)
 {
     ImageId iid = GetImageId(path);
-    if (iid == InvalidImageId) {
-        ImageCreateInfo info{};
-        info.type = ImageType::TEXTURE_2D;
-        iid = AllocateImage(info);
-        Instance()->imageRegistry.emplace(path, iid);
-    }
-    else
-    {
+    if (iid != InvalidImageId)
         return iid;
+
+    if (UseTextureCompression())
+    {
+        TextureCooker::CookedTexture cooked;
+        TextureCooker::Usage const usage = sRGB ? TextureCooker::Usage::ColorSRGB : TextureCooker::Usage::Color;
+        if (TextureCooker::CookFile(path, usage, TextureCooker::DefaultCacheFolder, cooked))
+            return CreateCompressedTexture(path, std::move(cooked), mag, min, wrapModeS, wrapModeT);
     }
 
-    int w, h, n; //Width, Height, components per pixel (ex. RGB = 3, RGBA = 4)
     auto start = std::chrono::high_resolution_clock::now();
-    unsigned char *image = stbi_load(path, &w, &h, &n, STBI_default);
+    DecodedImage image = DecodeImageFile(path);
     auto stop = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> duration = stop - start;
-    std::cout << "Loaded " << w << "x" << h << " " << n << "BPP texture from file in : " << duration.count() << " (ms)" << std::endl;
+    std::cout << "Loaded " << image.w << "x" << image.h << " " << image.channels << "BPP texture from file in : " << duration.count() << " (ms)" << std::endl;
 
-    if (image == nullptr)
+    if (image.pixels == nullptr)
     {
         printf("Could not find texture file!\n");
         assert(false);
     }
 
-    GLuint handle;
-    glGenTextures(1, &handle);
-    glBindTexture(GL_TEXTURE_2D, handle);
+    return CreateTexture(path, image, mag, min, wrapModeS, wrapModeT, sRGB);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+DecodedImage
+TextureResource::DecodeImage(void const* buffer, uint64_t bytes)
+{
+    DecodedImage image;
+    unsigned char* pixels = stbi_load_from_memory((uchar const*)buffer, (int)bytes, &image.w, &image.h, &image.channels, STBI_default);
+    if (pixels != nullptr)
+        image.pixels = { pixels, stbi_image_free };
+    return image;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+DecodedImage
+TextureResource::DecodeImageFile(const char* path)
+{
+    DecodedImage image;
+    unsigned char* pixels = stbi_load(path, &image.w, &image.h, &image.channels, STBI_default);
+    if (pixels != nullptr)
+        image.pixels = { pixels, stbi_image_free };
+    return image;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+TextureResourceId
+TextureResource::CreateTexture(std::string const& name, DecodedImage const& image, MagFilter mag, MinFilter min, WrappingMode wrapModeS, WrappingMode wrapModeT, bool sRGB)
+{
+    ImageCreateInfo info{};
+    info.type = ImageType::TEXTURE_2D;
+    info.extents = { (unsigned)image.w, (unsigned)image.h };
+    ImageId iid = AllocateImage(info);
+    Instance()->imageRegistry.emplace(name, iid);
+
+    glBindTexture(GL_TEXTURE_2D, GetImageHandle(iid));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (GLenum)min);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLenum)mag);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLenum)wrapModeS);
@@ -278,25 +327,151 @@ TextureResource::LoadTexture(const char * path, MagFilter mag, MinFilter min, Wr
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
     // If there's no alpha channel, use RGB colors. else: use RGBA.
-    if (n == 3)
+    if (image.channels == 3)
     {
-        glTexImage2D(GL_TEXTURE_2D, 0, sRGB ? GL_SRGB : GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+        glTexImage2D(GL_TEXTURE_2D, 0, sRGB ? GL_SRGB : GL_RGB, image.w, image.h, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels.get());
     }
-    else if (n == 4)
+    else if (image.channels == 4)
     {
-        glTexImage2D(GL_TEXTURE_2D, 0, sRGB ? GL_SRGB_ALPHA : GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+        glTexImage2D(GL_TEXTURE_2D, 0, sRGB ? GL_SRGB_ALPHA : GL_RGBA, image.w, image.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.get());
     }
 
     glGenerateMipmap(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(image);
+    return iid;
+}
 
-    Instance()->imageHandles[iid] = handle;
-    Instance()->imageExtents[iid] = { (unsigned)w, (unsigned)h };
-    Instance()->imageTypes[iid] = ImageType::TEXTURE_2D;
+//------------------------------------------------------------------------------
+/**
+*/
+static GLenum
+CompressedFormat(TextureCooker::Header const& header)
+{
+    bool const sRGB = header.usage == TextureCooker::Usage::ColorSRGB;
+    if (header.format == TextureCooker::Format::BC1)
+        return sRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (header.format == TextureCooker::Format::BC3)
+        return sRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    return GL_COMPRESSED_RG_RGTC2;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Creates a texture holding mips [firstMip, numMips) of a cooked texture. Mips the previous
+    texture holds are copied on the gpu, the others are uploaded from the cooked data.
+    Pass 0 as previous for a new texture.
+*/
+static GLuint
+CreateResidentMips(TextureCooker::CookedTexture const& texture, uint32_t firstMip, GLuint previous, uint32_t previousFirstMip, MagFilter mag, MinFilter min, WrappingMode wrapModeS, WrappingMode wrapModeT)
+{
+    TextureCooker::Header const& header = texture.header;
+    GLenum const format = CompressedFormat(header);
+
+    GLuint handle;
+    glCreateTextures(GL_TEXTURE_2D, 1, &handle);
+    glTextureStorage2D(handle, header.numMips - firstMip, format, std::max(header.width >> firstMip, 1u), std::max(header.height >> firstMip, 1u));
+    glTextureParameteri(handle, GL_TEXTURE_MIN_FILTER, (GLenum)min);
+    glTextureParameteri(handle, GL_TEXTURE_MAG_FILTER, (GLenum)mag);
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_S, (GLenum)wrapModeS);
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_T, (GLenum)wrapModeT);
+
+    uint8_t const* data = texture.data;
+    uint32_t w = header.width;
+    uint32_t h = header.height;
+    for (uint32_t mip = 0; mip < header.numMips; mip++)
+    {
+        size_t const size = TextureCooker::MipSize(header.format, w, h);
+        if (mip >= firstMip)
+        {
+            if (previous != 0 && mip >= previousFirstMip)
+                glCopyImageSubData(previous, GL_TEXTURE_2D, mip - previousFirstMip, 0, 0, 0, handle, GL_TEXTURE_2D, mip - firstMip, 0, 0, 0, w, h, 1);
+            else
+                glCompressedTextureSubImage2D(handle, mip - firstMip, 0, 0, w, h, format, (GLsizei)size, data);
+        }
+        data += size;
+        w = std::max(w / 2, 1u);
+        h = std::max(h / 2, 1u);
+    }
+    return handle;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+TextureResourceId
+TextureResource::CreateCompressedTexture(std::string const& name, TextureCooker::CookedTexture&& texture, MagFilter mag, MinFilter min, WrappingMode wrapModeS, WrappingMode wrapModeT)
+{
+    TextureCooker::Header const& header = texture.header;
+    ImageCreateInfo info{};
+    info.type = ImageType::TEXTURE_2D;
+    info.extents = { header.width, header.height };
+    ImageId iid = AllocateImage(info);
+    Instance()->imageRegistry.emplace(name, iid);
+    glDeleteTextures(1, &Instance()->imageHandles[iid]);
+
+    bool const stream = r_texture_streaming != nullptr && Core::CVarReadInt(r_texture_streaming) != 0
+        && std::max(header.width, header.height) > StreamingTailSize && header.numMips <= MaxStreamedMips;
+    if (!stream)
+    {
+        Instance()->imageHandles[iid] = CreateResidentMips(texture, 0, 0, header.numMips, mag, min, wrapModeS, wrapModeT);
+        return iid;
+    }
+
+    size_t mipBytes[MaxStreamedMips];
+    for (uint32_t mip = 0; mip < header.numMips; mip++)
+        mipBytes[mip] = TextureCooker::MipSize(header.format, std::max(header.width >> mip, 1u), std::max(header.height >> mip, 1u));
+    uint32_t const index = AddStreamedTexture(Instance()->streamer, header.width, header.height, header.numMips, mipBytes);
+    uint32_t const tailMip = Instance()->streamer.textures[index].tailMip;
+    Instance()->imageHandles[iid] = CreateResidentMips(texture, tailMip, 0, header.numMips, mag, min, wrapModeS, wrapModeT);
+
+    Instance()->imageStreamIndices[iid] = index;
+    Instance()->streamedImages.push_back({ iid, std::move(texture), mag, min, wrapModeS, wrapModeT });
     return iid;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+TextureResource::RequestTextureSize(TextureResourceId tid, float screenSize)
+{
+    uint32_t const index = Instance()->imageStreamIndices[tid];
+    if (index == UINT32_MAX)
+        return;
+    TextureStreamer::Texture const& texture = Instance()->streamer.textures[index];
+    RequestStreamedMip(Instance()->streamer, index, RequiredMip(texture.width, texture.height, texture.numMips, screenSize));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every change replaces the texture object, the passes look handles up when they bind them.
+*/
+void
+TextureResource::UpdateTextureStreaming()
+{
+    TextureResource* const self = Instance();
+    size_t const budget = (size_t)std::max(Core::CVarReadInt(r_texture_budget), 0) << 20;
+    Render::UpdateTextureStreaming(self->streamer, budget, StreamingUploadBytes, self->streamingChanges);
+
+    for (StreamingChange const& change : self->streamingChanges)
+    {
+        StreamedImage const& image = self->streamedImages[change.texture];
+        GLuint& handle = self->imageHandles[image.image];
+        GLuint const previous = handle;
+        handle = CreateResidentMips(image.cooked, change.residentMip, previous, change.previousMip, image.magFilter, image.minFilter, image.wrappingModeS, image.wrappingModeT);
+        glDeleteTextures(1, &previous);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+TextureResource::UseTextureCompression()
+{
+    return r_texture_compression != nullptr && Core::CVarReadInt(r_texture_compression) != 0;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -386,6 +561,7 @@ TextureResource::AllocateImage(ImageCreateInfo info)
     Instance()->imageHandles.push_back(handle);
     Instance()->imageExtents.push_back(info.extents);
     Instance()->imageTypes.push_back(info.type);
+    Instance()->imageStreamIndices.push_back(UINT32_MAX);
     return iid;
 }
 
@@ -9,6 +9,9 @@
 #include "GL/glew.h"
 #include "renderdevice.h"
 #include "resourceid.h"
+#include "texturecooker.h"
+#include "texturestreaming.h"
+#include <memory>
 
 namespace Render
 {
@@ -88,6 +91,15 @@ struct TextureLoadInfo
     TextureResourceId placeholder = InvalidResourceId; // placeholder texture while the texture is being loaded
 };
 
+/// Pixels decoded on the cpu, ready to be uploaded
+struct DecodedImage
+{
+    int w = 0;
+    int h = 0;
+    int channels = 0;
+    std::shared_ptr<unsigned char[]> pixels;
+};
+
 class TextureResource
 {
 private:
@@ -115,6 +127,17 @@ public:
     static TextureResourceId LoadTexture(const char* path, MagFilter mag, MinFilter min, WrappingMode wrapModeS, WrappingMode wrapModeT, bool sRGB);
     static TextureResourceId LoadTextureFromMemory(std::string name, void* buffer, uint64_t bytes, ImageId imageId, MagFilter, MinFilter, WrappingMode, WrappingMode, bool sRGB);
     
+    // decode a PNG or JPG, doesn't touch GL and may be called from any thread
+    static DecodedImage DecodeImage(void const* buffer, uint64_t bytes);
+    static DecodedImage DecodeImageFile(const char* path);
+    // upload decoded pixels to a new texture registered under name
+    static TextureResourceId CreateTexture(std::string const& name, DecodedImage const& image, MagFilter, MinFilter, WrappingMode, WrappingMode, bool sRGB);
+    // upload the mips of a cooked texture as they are, nothing is decoded or generated. Large textures
+    // are streamed when r_texture_streaming is set, they keep the cooked mips and only start with the small ones.
+    static TextureResourceId CreateCompressedTexture(std::string const& name, TextureCooker::CookedTexture&& texture, MagFilter, MinFilter, WrappingMode, WrappingMode);
+    // should loaders cook images into block compressed textures, see TextureCooker
+    static bool UseTextureCompression();
+
     static TextureResourceId LoadCubemap(std::string const& name, std::vector<const char*> const& paths, bool sRGB);
 
     static ImageId AllocateImage(ImageCreateInfo info);
@@ -133,12 +156,35 @@ public:
 
     static void LoadTextureLibrary(std::string folder);
 
+    // a draw covering screenSize pixels samples the texture this frame, ignored for textures that aren't streamed
+    static void RequestTextureSize(TextureResourceId tid, float screenSize);
+    // upload and evict mips of streamed textures for this frame's requests, within r_texture_budget
+    static void UpdateTextureStreaming();
+
 private:
     std::vector<GLuint> imageHandles;
     std::vector<ImageExtents> imageExtents;
     std::vector<ImageType> imageTypes;
     std::unordered_map<std::string, ImageId> imageRegistry;
 
+    /// a compressed texture whose mips are made resident by the streamer
+    struct StreamedImage
+    {
+        ImageId image;
+        /// all mips, uploaded from here whenever they become resident again
+        TextureCooker::CookedTexture cooked;
+        MagFilter magFilter;
+        MinFilter minFilter;
+        WrappingMode wrappingModeS;
+        WrappingMode wrappingModeT;
+    };
+    TextureStreamer streamer;
+    /// indexed like the textures of the streamer
+    std::vector<StreamedImage> streamedImages;
+    /// index into streamedImages per image, UINT32_MAX for images that are always resident
+    std::vector<uint32_t> imageStreamIndices;
+    std::vector<StreamingChange> streamingChanges;
+
     TextureResourceId whiteTexture = InvalidResourceId;
     TextureResourceId blackTexture = InvalidResourceId;
     TextureResourceId defaultMetallicRoughnessTexture = InvalidResourceId;
@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+//  texturestreaming.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "texturestreaming.h"
+
+namespace Render
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint32_t
+AddStreamedTexture(TextureStreamer& streamer, uint32_t width, uint32_t height, uint32_t numMips, size_t const* mipBytes)
+{
+	assert(numMips > 0 && numMips <= MaxStreamedMips);
+	TextureStreamer::Texture texture = {};
+	texture.width = width;
+	texture.height = height;
+	texture.numMips = numMips;
+	memcpy(texture.mipBytes, mipBytes, numMips * sizeof(size_t));
+
+	texture.tailMip = numMips - 1;
+	while (texture.tailMip > 0 && glm::max(width >> (texture.tailMip - 1), height >> (texture.tailMip - 1)) <= StreamingTailSize)
+		texture.tailMip--;
+	texture.residentMip = texture.tailMip;
+	texture.wantedMip = texture.tailMip;
+	texture.lastNeeded = 0;
+
+	streamer.textures.push_back(texture);
+	return (uint32_t)streamer.textures.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+/**
+	Assumes the texture is mapped once across the draw, which holds for most models.
+*/
+uint32_t
+RequiredMip(uint32_t width, uint32_t height, uint32_t numMips, float screenSize)
+{
+	float const texels = (float)glm::max(width, height);
+	if (screenSize >= texels)
+		return 0;
+	if (screenSize < 1.0f)
+		return numMips - 1;
+	return glm::min((uint32_t)glm::log2(texels / screenSize), numMips - 1);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+RequestStreamedMip(TextureStreamer& streamer, uint32_t texture, uint32_t mip)
+{
+	TextureStreamer::Texture& t = streamer.textures[texture];
+	if (mip < t.wantedMip)
+	{
+		t.wantedMip = mip;
+		t.lastNeeded = streamer.frame;
+	}
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+UpdateTextureStreaming(TextureStreamer& streamer, size_t budget, size_t uploadBytes, std::vector<StreamingChange>& changes)
+{
+	std::vector<TextureStreamer::Texture>& textures = streamer.textures;
+	changes.clear();
+
+	// eviction candidates, least recently needed first, then the ones holding the most memory
+	std::vector<uint32_t>& evictable = streamer.evictable;
+	// textures missing detail, the ones missing the most levels first
+	std::vector<uint32_t>& missing = streamer.missing;
+	evictable.clear();
+	missing.clear();
+	for (uint32_t i = 0; i < (uint32_t)textures.size(); i++)
+	{
+		TextureStreamer::Texture const& t = textures[i];
+		if (t.residentMip < t.wantedMip)
+			evictable.push_back(i);
+		else if (t.wantedMip < t.residentMip)
+			missing.push_back(i);
+	}
+	std::sort(evictable.begin(), evictable.end(), [&textures](uint32_t a, uint32_t b)
+	{
+		TextureStreamer::Texture const& ta = textures[a];
+		TextureStreamer::Texture const& tb = textures[b];
+		if (ta.lastNeeded != tb.lastNeeded)
+			return ta.lastNeeded < tb.lastNeeded;
+		if (ta.mipBytes[ta.residentMip] != tb.mipBytes[tb.residentMip])
+			return ta.mipBytes[ta.residentMip] > tb.mipBytes[tb.residentMip];
+		return a < b;
+	});
+	std::sort(missing.begin(), missing.end(), [&textures](uint32_t a, uint32_t b)
+	{
+		uint32_t const levelsA = textures[a].residentMip - textures[a].wantedMip;
+		uint32_t const levelsB = textures[b].residentMip - textures[b].wantedMip;
+		if (levelsA != levelsB)
+			return levelsA > levelsB;
+		return a < b;
+	});
+
+	std::vector<uint32_t>& previous = streamer.previous;
+	previous.resize(textures.size());
+	for (uint32_t i = 0; i < (uint32_t)textures.size(); i++)
+		previous[i] = textures[i].residentMip;
+
+	// drops the finest resident mip of the next candidate, false if nothing is left to drop
+	size_t nextEvictable = 0;
+	auto const evict = [&]() -> bool
+	{
+		while (nextEvictable < evictable.size())
+		{
+			TextureStreamer::Texture& t = textures[evictable[nextEvictable]];
+			if (t.residentMip < t.wantedMip)
+			{
+				streamer.residentBytes -= t.mipBytes[t.residentMip];
+				t.residentMip++;
+				return true;
+			}
+			nextEvictable++;
+		}
+		return false;
+	};
+
+	// the budget may have shrunk since the last frame
+	while (streamer.residentBytes > budget && evict())
+		;
+
+	size_t uploaded = 0;
+	for (uint32_t index : missing)
+	{
+		TextureStreamer::Texture& t = textures[index];
+		size_t const bytes = t.mipBytes[t.residentMip - 1];
+		if (uploaded > 0 && uploaded + bytes > uploadBytes)
+			break;
+
+		bool fits = true;
+		while (fits && streamer.residentBytes + bytes > budget)
+			fits = evict();
+		if (!fits)
+			break;
+
+		t.residentMip--;
+		streamer.residentBytes += bytes;
+		uploaded += bytes;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)textures.size(); i++)
+	{
+		if (textures[i].residentMip != previous[i])
+			changes.push_back({ i, previous[i], textures[i].residentMip });
+		textures[i].wantedMip = textures[i].tailMip;
+	}
+	streamer.frame++;
+}
+
+} // namespace Render
@@ -0,0 +1,82 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+	@file texturestreaming.h
+
+	Mip residency of streamed textures under a memory budget. Every frame the draws
+	request the mip they need for their size on screen. The finest missing mips are
+	then made resident one level per texture, smallest first, and when that would go
+	over the budget the mips needed least recently are evicted to make room.
+
+	Only bookkeeping lives here, TextureResource creates the GL textures for the
+	residency changes it returns.
+
+	@copyright
+	(C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <vector>
+
+namespace Render
+{
+
+/// enough for 32k textures
+constexpr uint32_t MaxStreamedMips = 16;
+/// mips this size and smaller are resident from the start and never evicted
+constexpr uint32_t StreamingTailSize = 64;
+
+struct TextureStreamer
+{
+	struct Texture
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t numMips;
+		size_t mipBytes[MaxStreamedMips];
+		/// largest mip that is never evicted
+		uint32_t tailMip;
+		/// mips [residentMip, numMips) are resident
+		uint32_t residentMip;
+		/// finest mip requested this frame, tailMip if none was
+		uint32_t wantedMip;
+		/// frame of the last request finer than the tail
+		uint64_t lastNeeded;
+	};
+
+	std::vector<Texture> textures;
+	/// bytes of the resident mips finer than the tails
+	size_t residentBytes = 0;
+	uint64_t frame = 0;
+
+	/// scratch memory for UpdateTextureStreaming, kept between frames so that it does not allocate
+	std::vector<uint32_t> evictable;
+	std::vector<uint32_t> missing;
+	std::vector<uint32_t> previous;
+};
+
+/// a texture's resident mips changed from [previousMip, numMips) to [residentMip, numMips)
+struct StreamingChange
+{
+	uint32_t texture;
+	uint32_t previousMip;
+	uint32_t residentMip;
+};
+
+/// add a texture with its tail resident, returns its index
+uint32_t AddStreamedTexture(TextureStreamer& streamer, uint32_t width, uint32_t height, uint32_t numMips, size_t const* mipBytes);
+
+/// mip with about one texel per pixel for a texture covering screenSize pixels
+uint32_t RequiredMip(uint32_t width, uint32_t height, uint32_t numMips, float screenSize);
+
+/// ask for a mip this frame, the finest request of the frame wins
+void RequestStreamedMip(TextureStreamer& streamer, uint32_t texture, uint32_t mip);
+
+/**
+	Plans this frame's residency changes from the requests and starts the next frame. Uploads go
+	to the textures missing the most levels first, and stop after uploadBytes unless nothing was
+	uploaded yet. Only mips finer than a texture's request are evicted, so a frame never evicts
+	what it needs itself. The tails don't count against the budget.
+*/
+void UpdateTextureStreaming(TextureStreamer& streamer, size_t budget, size_t uploadBytes, std::vector<StreamingChange>& changes);
+
+} // namespace Render
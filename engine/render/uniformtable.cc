@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------------
+//  uniformtable.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "uniformtable.h"
+
+namespace Render
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+UniformTable::Clear()
+{
+    this->slots.clear();
+    this->names.clear();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+UniformTable::Insert(std::string_view name, int32_t value)
+{
+    if ((this->names.size() + 1) * 2 > this->slots.size())
+        this->Grow();
+
+    uint32_t const hash = HashUniformName(name);
+    size_t const mask = this->slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        Slot& slot = this->slots[i];
+        if (slot.hash == 0)
+        {
+            slot.hash = hash;
+            slot.value = value;
+            slot.name = (uint32_t)this->names.size();
+            this->names.emplace_back(name);
+            return true;
+        }
+        if (slot.hash == hash)
+        {
+            if (this->names[slot.name] != name)
+                return false;
+            slot.value = value;
+            return true;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+UniformTable::Grow()
+{
+    std::vector<Slot> old;
+    old.swap(this->slots);
+    this->slots.resize(old.empty() ? 16 : old.size() * 2);
+
+    size_t const mask = this->slots.size() - 1;
+    for (Slot const& slot : old)
+    {
+        if (slot.hash == 0)
+            continue;
+        size_t i = slot.hash & mask;
+        while (this->slots[i].hash != 0)
+            i = (i + 1) & mask;
+        this->slots[i] = slot;
+    }
+}
+
+} // namespace Render
@@ -0,0 +1,100 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    UniformTable
+
+    Maps hashed uniform names to locations for one shader program. Filled by reflecting
+    the program after linking, so looking up a uniform never goes to the driver.
+
+    (C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Render
+{
+
+//------------------------------------------------------------------------------
+/**
+    FNV-1a of the name. Zero marks empty slots in UniformTable, so it is never returned.
+*/
+constexpr uint32_t
+HashUniformName(std::string_view name)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : name)
+    {
+        hash ^= (uint8_t)c;
+        hash *= 16777619u;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+/// a uniform name hashed at compile time
+struct UniformName
+{
+    consteval UniformName(char const* name) : hash(HashUniformName(name)) {}
+
+    /// for names that are only known at runtime
+    static UniformName FromString(std::string_view name) { return UniformName(HashUniformName(name), 0); }
+
+    uint32_t hash;
+
+private:
+    constexpr UniformName(uint32_t h, int) : hash(h) {}
+};
+
+class UniformTable
+{
+public:
+    /// location or binding returned for names that are not in the table
+    static constexpr int32_t NotFound = -1;
+
+    /// remove all names
+    void Clear();
+    /// add a name, returns false if a different name with the same hash is already in the table
+    bool Insert(std::string_view name, int32_t value);
+    /// value of the name, or NotFound
+    int32_t Find(UniformName name) const;
+    /// number of names in the table
+    size_t Size() const { return this->names.size(); }
+
+private:
+    struct Slot
+    {
+        uint32_t hash = 0;
+        int32_t value = NotFound;
+        /// index into names, only used to detect collisions while inserting
+        uint32_t name = 0;
+    };
+
+    void Grow();
+
+    /// open addressing with linear probing, size is a power of two and at most half full
+    std::vector<Slot> slots;
+    std::vector<std::string> names;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline int32_t
+UniformTable::Find(UniformName name) const
+{
+    if (this->slots.empty())
+        return NotFound;
+
+    size_t const mask = this->slots.size() - 1;
+    for (size_t i = name.hash & mask;; i = (i + 1) & mask)
+    {
+        Slot const& slot = this->slots[i];
+        if (slot.hash == name.hash)
+            return slot.value;
+        if (slot.hash == 0)
+            return NotFound;
+    }
+}
+
+} // namespace Render
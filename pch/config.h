@@ -92,5 +92,13 @@ struct Time {
                 .count();
     }
 
+    // Same clock as Now() with sub-millisecond precision.
+    static double NowPrecise() {
+        const auto now = std::chrono::system_clock::now();
+        const auto duration = now.time_since_epoch();
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(start + duration).count())
+               / 1000.0;
+    }
+
     static std::chrono::milliseconds start;
 };
@@ -0,0 +1,62 @@
+#include "asteroidfield.h"
+
+#include "core/random.h"
+#include "deterministic.h"
+
+namespace Game {
+    const char *AsteroidModelPaths[NumAsteroidTypes] = {
+        "assets/space/Asteroid_1.glb",
+        "assets/space/Asteroid_2.glb",
+        "assets/space/Asteroid_3.glb",
+        "assets/space/Asteroid_4.glb",
+        "assets/space/Asteroid_5.glb",
+        "assets/space/Asteroid_6.glb"
+    };
+
+    const char *AsteroidColliderPaths[NumAsteroidTypes] = {
+        "assets/space/Asteroid_1_physics.glb",
+        "assets/space/Asteroid_2_physics.glb",
+        "assets/space/Asteroid_3_physics.glb",
+        "assets/space/Asteroid_4_physics.glb",
+        "assets/space/Asteroid_5_physics.glb",
+        "assets/space/Asteroid_6_physics.glb"
+    };
+
+    void
+    GenerateAsteroidField(const uint32 seed, const std::function<void(uint32 type, const mat4 &transform)> &spawn) {
+        Core::RandomState random = Core::SeedRandom(seed);
+
+        constexpr int numNear = 100;
+        constexpr int numFar = 50;
+
+        // Setup asteroids near
+        for (int i = 0; i < numNear; i++) {
+            const uint32 type = Core::FastRandom(random) % NumAsteroidTypes;
+            constexpr float span = 20.0f;
+            vec3 translation(
+                Core::RandomFloatNTP(random) * span,
+                Core::RandomFloatNTP(random) * span,
+                Core::RandomFloatNTP(random) * span
+            );
+            vec3 rotationAxis = normalize(translation);
+            const float rotation = translation.x;
+            mat4 transform = mat4(Deterministic::AxisAngleToQuat(rotation, rotationAxis)) * translate(translation);
+            spawn(type, transform);
+        }
+
+        // Setup asteroids far
+        for (int i = 0; i < numFar; i++) {
+            const uint32 type = Core::FastRandom(random) % NumAsteroidTypes;
+            constexpr float span = 80.0f;
+            const vec3 translation(
+                Core::RandomFloatNTP(random) * span,
+                Core::RandomFloatNTP(random) * span,
+                Core::RandomFloatNTP(random) * span
+            );
+            vec3 rotationAxis = normalize(translation);
+            const float rotation = translation.x;
+            const mat4 transform = mat4(Deterministic::AxisAngleToQuat(rotation, rotationAxis)) * translate(translation);
+            spawn(type, transform);
+        }
+    }
+}
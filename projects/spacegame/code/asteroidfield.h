@@ -0,0 +1,15 @@
+#pragma once
+#include <functional>
+
+namespace Game {
+    // Seed of the asteroid layout, clients and server must agree on this.
+    constexpr uint32 AsteroidFieldSeed = 123456789;
+
+    constexpr uint32 NumAsteroidTypes = 6;
+
+    extern const char *AsteroidModelPaths[NumAsteroidTypes];
+    extern const char *AsteroidColliderPaths[NumAsteroidTypes];
+
+    // Generates the asteroid layout for a seed, calls spawn once for every asteroid.
+    void GenerateAsteroidField(uint32 seed, const std::function<void(uint32 type, const mat4 &transform)> &spawn);
+}
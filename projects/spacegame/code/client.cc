@@ -20,6 +20,7 @@ namespace Game {
     void
     Client::Disconnect() {
         s_Instance.m_Client.Disconnect();
+        s_Instance.m_Connected = false;
     }
 
     const char *
@@ -30,7 +31,17 @@ namespace Game {
     void
     Client::UpdateImpl() {
         m_CurrentTime = Time::Now();
+
+        // Sent before polling so that the ping leaves right away and its timestamp is accurate.
+        const double now = Time::NowPrecise();
+        if (m_Connected && m_TimeSync.ShouldPing(now)) {
+            const auto fbb = Packet::PingC2S(now);
+            m_Client.SendPacket(fbb.GetBufferPointer(), fbb.GetSize());
+            m_TimeSync.OnPingSent(now);
+        }
+
         m_Client.Poll();
+        m_PlayoutClock.Update(m_CurrentTime);
         m_LastUpdateTime = m_CurrentTime;
     }
 
@@ -43,15 +54,15 @@ namespace Game {
             A packet used to notify the client about what ship it will be controlling when it receives
             the initial game state.
             - uuid: Unique identifier of the player that will be controlled by the client.
-            - time: The server time when this packet was sent, add the packet transmit time to this
-              to get accurate server time on the client (use this to find difference).
+            - time: The server time when this packet was sent, only used as a first coarse estimate of the
+              server clock until the ping exchange has synchronized it.
              */
             case Protocol::PacketType_ClientConnectS2C: {
                 LOG("Received connect packet\n");
                 const auto clientConnectS2C = wrapper.AsClientConnectS2C();
                 m_ClientId = clientConnectS2C->uuid;
-                m_ClientTimeZero = m_CurrentTime;
-                m_ServerTimeZero = clientConnectS2C->time;
+                m_TimeSync.Reset(static_cast<double>(clientConnectS2C->time), Time::NowPrecise());
+                m_Connected = true;
                 LOG("Received connect packet. uuid is: " << clientConnectS2C->uuid << '\n');
                 break;
             }
@@ -129,8 +140,8 @@ namespace Game {
 
                 SpaceShip &ship = m_SpaceShips->at(player->uuid());
 
-                //const uint64 latency = std::max(m_CurrentTime - m_LastUpdateTime, m_CurrentTime - updatePlayer->time);
-                ship.SetServerData(*player, m_CurrentTime, player->uuid() == m_ClientId);
+                m_PlayoutClock.OnSnapshot(updatePlayer->time, ServerNow());
+                ship.SetServerData(*player, updatePlayer->time, m_CurrentTime, player->uuid() == m_ClientId);
                 //LOG(m_CurrentTime << "Receive update player packet.\n");
                 break;
             }
@@ -167,10 +178,8 @@ namespace Game {
                 laser.endTime = laserPacket->end_time();
 
                 // Sync the laser with the server
-                const uint64 packetSentTime = laserPacket->start_time() - m_ServerTimeZero;
-                const uint64 packetReceivedTime = m_CurrentTime - m_ClientTimeZero;
-                const float dt = float(packetReceivedTime - packetSentTime) / 1000.0f;
-                laser.Update(dt);
+                const double dt = (ServerNow() - static_cast<double>(laserPacket->start_time())) / 1000.0;
+                laser.Update(static_cast<float>(std::max(0.0, dt)));
                 break;
             }
 
@@ -204,6 +213,19 @@ namespace Game {
                 LOG("Client received text: " << textS2C->text << '\n');
                 break;
             }
+
+            /**
+            A packet used to answer a ping, gives one sample of the offset between the client and server clocks.
+            - client_time: The client time when the ping was sent.
+            - server_receive_time: The server time when the ping was received.
+            - server_transmit_time: The server time when this packet was sent.
+             */
+            case Protocol::PacketType_PongS2C: {
+                const auto pong = wrapper.AsPongS2C();
+                m_TimeSync.AddSample(pong->client_time, pong->server_receive_time, pong->server_transmit_time,
+                                     Time::NowPrecise());
+                break;
+            }
             default: break;
         }
     }
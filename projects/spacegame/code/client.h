@@ -2,6 +2,8 @@
 #include "packets.h"
 #include "network/network.h"
 #include "spaceship.h"
+#include "snapshotbuffer.h"
+#include "timesync.h"
 
 namespace Game {
     class Client {
@@ -20,6 +22,16 @@ namespace Game {
 
         static uint32 GetId() { return s_Instance.m_ClientId; }
 
+        // Estimate of the current server time in ms.
+        static double ServerNow() { return s_Instance.m_TimeSync.ServerTime(Time::NowPrecise()); }
+
+        // Server time in ms that remote entities should be rendered at.
+        static double GetRenderTime() { return s_Instance.m_PlayoutClock.GetRenderTime(ServerNow()); }
+
+        static const TimeSync &GetTimeSync() { return s_Instance.m_TimeSync; }
+
+        static const PlayoutClock &GetPlayoutClock() { return s_Instance.m_PlayoutClock; }
+
         static void SetScene(std::unordered_map<uint32, SpaceShip> *spaceShips,
                              std::unordered_map<uint32, Laser> *lasers) {
             s_Instance.m_SpaceShips = spaceShips;
@@ -44,7 +56,9 @@ namespace Game {
 
         uint64 m_CurrentTime = 0;
         uint64 m_LastUpdateTime = 0;
-        uint64 m_ClientTimeZero = 0;
-        uint64 m_ServerTimeZero = 0;
+        bool m_Connected = false;
+
+        TimeSync m_TimeSync;
+        PlayoutClock m_PlayoutClock;
     };
 }
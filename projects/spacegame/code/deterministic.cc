@@ -0,0 +1,64 @@
+#include "deterministic.h"
+
+namespace Game::Deterministic {
+    static constexpr float Pi = 3.14159265358979f;
+    static constexpr float HalfPi = Pi * 0.5f;
+    static constexpr float TwoPi = Pi * 2.0f;
+    static constexpr float InvTwoPi = 1.0f / TwoPi;
+
+    float
+    Sin(float x) {
+        // Range reduce to [-pi, pi], then fold to [-pi/2, pi/2] using sin(pi - x) = sin(x).
+        x -= TwoPi * std::floor(x * InvTwoPi + 0.5f);
+        if (x > HalfPi) {
+            x = Pi - x;
+        } else if (x < -HalfPi) {
+            x = -Pi - x;
+        }
+
+        // Taylor series to x^11, error is below float precision on [-pi/2, pi/2].
+        const float x2 = x * x;
+        float p = -2.5052108e-8f;
+        p = p * x2 + 2.7557319e-6f;
+        p = p * x2 - 1.9841270e-4f;
+        p = p * x2 + 8.3333333e-3f;
+        p = p * x2 - 1.6666667e-1f;
+        return x + x * x2 * p;
+    }
+
+    float
+    Cos(const float x) {
+        return Sin(x + HalfPi);
+    }
+
+    quat
+    EulerToQuat(const vec3 &eulerAngles) {
+        const vec3 half = eulerAngles * 0.5f;
+        const vec3 c(Cos(half.x), Cos(half.y), Cos(half.z));
+        const vec3 s(Sin(half.x), Sin(half.y), Sin(half.z));
+
+        return {
+            c.x * c.y * c.z + s.x * s.y * s.z,
+            s.x * c.y * c.z - c.x * s.y * s.z,
+            c.x * s.y * c.z + s.x * c.y * s.z,
+            c.x * c.y * s.z - s.x * s.y * c.z
+        };
+    }
+
+    quat
+    AxisAngleToQuat(const float angle, const vec3 &axis) {
+        const float half = angle * 0.5f;
+        const float s = Sin(half);
+        return { Cos(half), axis.x * s, axis.y * s, axis.z * s };
+    }
+
+    uint32
+    Hash(const void *data, const size_t size, uint32 seed) {
+        const auto *bytes = static_cast<const uint8 *>(data);
+        for (size_t i = 0; i < size; ++i) {
+            seed ^= bytes[i];
+            seed *= 16777619u;
+        }
+        return seed;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace Game {
+    /**
+    Helpers for simulation code that must produce bit identical results on every platform. Only IEEE-754
+    operations that are required to be correctly rounded (+, -, *, /, sqrt) are used, libm trig is avoided since
+    its results differ between implementations. The spacegame target is compiled with FP contraction disabled so
+    the compiler does not fuse multiply-adds differently per platform.
+     */
+    namespace Deterministic {
+        // Fixed simulation rate shared by the server and client prediction.
+        constexpr uint32 SimulationFrequency = 50;
+        constexpr float SimulationTimeStep = 1.0f / static_cast<float>(SimulationFrequency);
+
+        float Sin(float x);
+
+        float Cos(float x);
+
+        // Same as glm's quat(eulerAngles) constructor but with deterministic trig.
+        quat EulerToQuat(const vec3 &eulerAngles);
+
+        // Same as glm's angleAxis(angle, axis) but with deterministic trig, axis must be normalized.
+        quat AxisAngleToQuat(float angle, const vec3 &axis);
+
+        // FNV-1a hash of raw bytes, continue an existing hash by passing it as seed.
+        uint32 Hash(const void *data, size_t size, uint32 seed = 2166136261u);
+
+        template<typename T>
+        uint32 Hash(const T &value, const uint32 seed = 2166136261u) {
+            return Hash(&value, sizeof(T), seed);
+        }
+    }
+}
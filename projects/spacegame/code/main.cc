@@ -4,6 +4,7 @@
 //------------------------------------------------------------------------------
 #include "config.h"
 #include "spacegameapp.h"
+#include "core/cvar.h"
 
 using namespace std::chrono;
 using namespace std::chrono_literals;
@@ -12,6 +13,25 @@ milliseconds Time::start = 0ms;
 
 int
 main(int argc, const char **argv) {
+	for (int i = 1; i + 1 < argc; i++) {
+		// Headless playback of a recorded server session.
+		if (std::strcmp(argv[i], "--replay") == 0) {
+			return Game::Server::Playback(argv[i + 1]) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		// Record the hosted server session.
+		if (std::strcmp(argv[i], "--record") == 0) {
+			Core::CVar *replayRecord = Core::CVarCreate(Core::CVar_String, "sv_replay_record", "",
+			                                            "Path to record a replay of the server session to");
+			Core::CVarWriteString(replayRecord, argv[i + 1]);
+		}
+		// Player cap of the hosted server.
+		if (std::strcmp(argv[i], "--max-players") == 0) {
+			Core::CVar *maxPlayers = Core::CVarCreate(Core::CVar_Int, "sv_max_players", "32",
+			                                          "Maximum number of connected players");
+			Core::CVarWriteInt(maxPlayers, std::atoi(argv[i + 1]));
+		}
+	}
+
 	if (argc == 2) {
 		Time::start = milliseconds(std::stoi(argv[1]));
 	}
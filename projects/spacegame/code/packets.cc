@@ -87,6 +87,14 @@ namespace Packet {
         return fbb;
     }
 
+    FlatBufferBuilder PongS2C(const double clientTimeMs, const double receiveTimeMs, const double transmitTimeMs) {
+        FlatBufferBuilder fbb;
+        const auto pong = CreatePongS2C(fbb, clientTimeMs, receiveTimeMs, transmitTimeMs);
+        const auto wrapper = CreatePacketWrapper(fbb, PacketType_PongS2C, pong.Union());
+        fbb.Finish(wrapper);
+        return fbb;
+    }
+
     FlatBufferBuilder InputC2S(const uint64 timeMs, const uint16 bitmap) {
         FlatBufferBuilder fbb;
         const auto input = CreateInputC2S(fbb, timeMs, bitmap);
@@ -102,4 +110,12 @@ namespace Packet {
         fbb.Finish(wrapper);
         return fbb;
     }
+
+    FlatBufferBuilder PingC2S(const double clientTimeMs) {
+        FlatBufferBuilder fbb;
+        const auto ping = CreatePingC2S(fbb, clientTimeMs);
+        const auto wrapper = CreatePacketWrapper(fbb, PacketType_PingC2S, ping.Union());
+        fbb.Finish(wrapper);
+        return fbb;
+    }
 }
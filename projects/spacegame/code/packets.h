@@ -25,8 +25,12 @@ namespace Packet {
 
     flatbuffers::FlatBufferBuilder TextS2C(const std::string &text);
 
+    flatbuffers::FlatBufferBuilder PongS2C(double clientTimeMs, double receiveTimeMs, double transmitTimeMs);
+
     // Client to server.
     flatbuffers::FlatBufferBuilder InputC2S(uint64 timeMs, uint16 bitmap);
 
     flatbuffers::FlatBufferBuilder TextC2S(const std::string &text);
+
+    flatbuffers::FlatBufferBuilder PingC2S(double clientTimeMs);
 }
@@ -75,6 +75,14 @@ struct TextC2S;
 struct TextC2SBuilder;
 struct TextC2ST;
 
+struct PingC2S;
+struct PingC2SBuilder;
+struct PingC2ST;
+
+struct PongS2C;
+struct PongS2CBuilder;
+struct PongS2CT;
+
 enum PacketType : uint8_t {
   PacketType_NONE = 0,
   PacketType_InputC2S = 1,
@@ -89,11 +97,13 @@ enum PacketType : uint8_t {
   PacketType_DespawnLaserS2C = 10,
   PacketType_CollisionS2C = 11,
   PacketType_TextS2C = 12,
+  PacketType_PingC2S = 13,
+  PacketType_PongS2C = 14,
   PacketType_MIN = PacketType_NONE,
-  PacketType_MAX = PacketType_TextS2C
+  PacketType_MAX = PacketType_PongS2C
 };
 
-inline const PacketType (&EnumValuesPacketType())[13] {
+inline const PacketType (&EnumValuesPacketType())[15] {
   static const PacketType values[] = {
     PacketType_NONE,
     PacketType_InputC2S,
@@ -107,13 +117,15 @@ inline const PacketType (&EnumValuesPacketType())[13] {
     PacketType_SpawnLaserS2C,
     PacketType_DespawnLaserS2C,
     PacketType_CollisionS2C,
-    PacketType_TextS2C
+    PacketType_TextS2C,
+    PacketType_PingC2S,
+    PacketType_PongS2C
   };
   return values;
 }
 
 inline const char * const *EnumNamesPacketType() {
-  static const char * const names[14] = {
+  static const char * const names[16] = {
     "NONE",
     "InputC2S",
     "TextC2S",
@@ -127,13 +139,15 @@ inline const char * const *EnumNamesPacketType() {
     "DespawnLaserS2C",
     "CollisionS2C",
     "TextS2C",
+    "PingC2S",
+    "PongS2C",
     nullptr
   };
   return names;
 }
 
 inline const char *EnumNamePacketType(PacketType e) {
-  if (::flatbuffers::IsOutRange(e, PacketType_NONE, PacketType_TextS2C)) return "";
+  if (::flatbuffers::IsOutRange(e, PacketType_NONE, PacketType_PongS2C)) return "";
   const size_t index = static_cast<size_t>(e);
   return EnumNamesPacketType()[index];
 }
@@ -190,6 +204,14 @@ template<> struct PacketTypeTraits<Protocol::TextS2C> {
   static const PacketType enum_value = PacketType_TextS2C;
 };
 
+template<> struct PacketTypeTraits<Protocol::PingC2S> {
+  static const PacketType enum_value = PacketType_PingC2S;
+};
+
+template<> struct PacketTypeTraits<Protocol::PongS2C> {
+  static const PacketType enum_value = PacketType_PongS2C;
+};
+
 template<typename T> struct PacketTypeUnionTraits {
   static const PacketType enum_value = PacketType_NONE;
 };
@@ -242,6 +264,14 @@ template<> struct PacketTypeUnionTraits<Protocol::TextS2CT> {
   static const PacketType enum_value = PacketType_TextS2C;
 };
 
+template<> struct PacketTypeUnionTraits<Protocol::PingC2ST> {
+  static const PacketType enum_value = PacketType_PingC2S;
+};
+
+template<> struct PacketTypeUnionTraits<Protocol::PongS2CT> {
+  static const PacketType enum_value = PacketType_PongS2C;
+};
+
 struct PacketTypeUnion {
   PacketType type;
   void *value;
@@ -368,6 +398,22 @@ struct PacketTypeUnion {
     return type == PacketType_TextS2C ?
       reinterpret_cast<const Protocol::TextS2CT *>(value) : nullptr;
   }
+  Protocol::PingC2ST *AsPingC2S() {
+    return type == PacketType_PingC2S ?
+      reinterpret_cast<Protocol::PingC2ST *>(value) : nullptr;
+  }
+  const Protocol::PingC2ST *AsPingC2S() const {
+    return type == PacketType_PingC2S ?
+      reinterpret_cast<const Protocol::PingC2ST *>(value) : nullptr;
+  }
+  Protocol::PongS2CT *AsPongS2C() {
+    return type == PacketType_PongS2C ?
+      reinterpret_cast<Protocol::PongS2CT *>(value) : nullptr;
+  }
+  const Protocol::PongS2CT *AsPongS2C() const {
+    return type == PacketType_PongS2C ?
+      reinterpret_cast<const Protocol::PongS2CT *>(value) : nullptr;
+  }
 };
 
 bool VerifyPacketType(::flatbuffers::Verifier &verifier, const void *obj, PacketType type);
@@ -635,6 +681,12 @@ struct PacketWrapper FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   const Protocol::TextS2C *packet_as_TextS2C() const {
     return packet_type() == Protocol::PacketType_TextS2C ? static_cast<const Protocol::TextS2C *>(packet()) : nullptr;
   }
+  const Protocol::PingC2S *packet_as_PingC2S() const {
+    return packet_type() == Protocol::PacketType_PingC2S ? static_cast<const Protocol::PingC2S *>(packet()) : nullptr;
+  }
+  const Protocol::PongS2C *packet_as_PongS2C() const {
+    return packet_type() == Protocol::PacketType_PongS2C ? static_cast<const Protocol::PongS2C *>(packet()) : nullptr;
+  }
   void *mutable_packet() {
     return GetPointer<void *>(VT_PACKET);
   }
@@ -698,6 +750,14 @@ template<> inline const Protocol::TextS2C *PacketWrapper::packet_as<Protocol::Te
   return packet_as_TextS2C();
 }
 
+template<> inline const Protocol::PingC2S *PacketWrapper::packet_as<Protocol::PingC2S>() const {
+  return packet_as_PingC2S();
+}
+
+template<> inline const Protocol::PongS2C *PacketWrapper::packet_as<Protocol::PongS2C>() const {
+  return packet_as_PongS2C();
+}
+
 struct PacketWrapperBuilder {
   typedef PacketWrapper Table;
   ::flatbuffers::FlatBufferBuilder &fbb_;
@@ -1525,6 +1585,144 @@ inline ::flatbuffers::Offset<TextC2S> CreateTextC2SDirect(
 
 ::flatbuffers::Offset<TextC2S> CreateTextC2S(::flatbuffers::FlatBufferBuilder &_fbb, const TextC2ST *_o, const ::flatbuffers::rehasher_function_t *_rehasher = nullptr);
 
+struct PingC2ST : public ::flatbuffers::NativeTable {
+  typedef PingC2S TableType;
+  double client_time = 0.0;
+};
+
+struct PingC2S FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
+  typedef PingC2ST NativeTableType;
+  typedef PingC2SBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_CLIENT_TIME = 4
+  };
+  double client_time() const {
+    return GetField<double>(VT_CLIENT_TIME, 0.0);
+  }
+  bool mutate_client_time(double _client_time = 0.0) {
+    return SetField<double>(VT_CLIENT_TIME, _client_time, 0.0);
+  }
+  bool Verify(::flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<double>(verifier, VT_CLIENT_TIME, 8) &&
+           verifier.EndTable();
+  }
+  PingC2ST *UnPack(const ::flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(PingC2ST *_o, const ::flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static ::flatbuffers::Offset<PingC2S> Pack(::flatbuffers::FlatBufferBuilder &_fbb, const PingC2ST* _o, const ::flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct PingC2SBuilder {
+  typedef PingC2S Table;
+  ::flatbuffers::FlatBufferBuilder &fbb_;
+  ::flatbuffers::uoffset_t start_;
+  void add_client_time(double client_time) {
+    fbb_.AddElement<double>(PingC2S::VT_CLIENT_TIME, client_time, 0.0);
+  }
+  explicit PingC2SBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  ::flatbuffers::Offset<PingC2S> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = ::flatbuffers::Offset<PingC2S>(end);
+    return o;
+  }
+};
+
+inline ::flatbuffers::Offset<PingC2S> CreatePingC2S(
+    ::flatbuffers::FlatBufferBuilder &_fbb,
+    double client_time = 0.0) {
+  PingC2SBuilder builder_(_fbb);
+  builder_.add_client_time(client_time);
+  return builder_.Finish();
+}
+
+::flatbuffers::Offset<PingC2S> CreatePingC2S(::flatbuffers::FlatBufferBuilder &_fbb, const PingC2ST *_o, const ::flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
+struct PongS2CT : public ::flatbuffers::NativeTable {
+  typedef PongS2C TableType;
+  double client_time = 0.0;
+  double server_receive_time = 0.0;
+  double server_transmit_time = 0.0;
+};
+
+struct PongS2C FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
+  typedef PongS2CT NativeTableType;
+  typedef PongS2CBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_CLIENT_TIME = 4,
+    VT_SERVER_RECEIVE_TIME = 6,
+    VT_SERVER_TRANSMIT_TIME = 8
+  };
+  double client_time() const {
+    return GetField<double>(VT_CLIENT_TIME, 0.0);
+  }
+  bool mutate_client_time(double _client_time = 0.0) {
+    return SetField<double>(VT_CLIENT_TIME, _client_time, 0.0);
+  }
+  double server_receive_time() const {
+    return GetField<double>(VT_SERVER_RECEIVE_TIME, 0.0);
+  }
+  bool mutate_server_receive_time(double _server_receive_time = 0.0) {
+    return SetField<double>(VT_SERVER_RECEIVE_TIME, _server_receive_time, 0.0);
+  }
+  double server_transmit_time() const {
+    return GetField<double>(VT_SERVER_TRANSMIT_TIME, 0.0);
+  }
+  bool mutate_server_transmit_time(double _server_transmit_time = 0.0) {
+    return SetField<double>(VT_SERVER_TRANSMIT_TIME, _server_transmit_time, 0.0);
+  }
+  bool Verify(::flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<double>(verifier, VT_CLIENT_TIME, 8) &&
+           VerifyField<double>(verifier, VT_SERVER_RECEIVE_TIME, 8) &&
+           VerifyField<double>(verifier, VT_SERVER_TRANSMIT_TIME, 8) &&
+           verifier.EndTable();
+  }
+  PongS2CT *UnPack(const ::flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(PongS2CT *_o, const ::flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static ::flatbuffers::Offset<PongS2C> Pack(::flatbuffers::FlatBufferBuilder &_fbb, const PongS2CT* _o, const ::flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct PongS2CBuilder {
+  typedef PongS2C Table;
+  ::flatbuffers::FlatBufferBuilder &fbb_;
+  ::flatbuffers::uoffset_t start_;
+  void add_client_time(double client_time) {
+    fbb_.AddElement<double>(PongS2C::VT_CLIENT_TIME, client_time, 0.0);
+  }
+  void add_server_receive_time(double server_receive_time) {
+    fbb_.AddElement<double>(PongS2C::VT_SERVER_RECEIVE_TIME, server_receive_time, 0.0);
+  }
+  void add_server_transmit_time(double server_transmit_time) {
+    fbb_.AddElement<double>(PongS2C::VT_SERVER_TRANSMIT_TIME, server_transmit_time, 0.0);
+  }
+  explicit PongS2CBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  ::flatbuffers::Offset<PongS2C> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = ::flatbuffers::Offset<PongS2C>(end);
+    return o;
+  }
+};
+
+inline ::flatbuffers::Offset<PongS2C> CreatePongS2C(
+    ::flatbuffers::FlatBufferBuilder &_fbb,
+    double client_time = 0.0,
+    double server_receive_time = 0.0,
+    double server_transmit_time = 0.0) {
+  PongS2CBuilder builder_(_fbb);
+  builder_.add_server_transmit_time(server_transmit_time);
+  builder_.add_server_receive_time(server_receive_time);
+  builder_.add_client_time(client_time);
+  return builder_.Finish();
+}
+
+::flatbuffers::Offset<PongS2C> CreatePongS2C(::flatbuffers::FlatBufferBuilder &_fbb, const PongS2CT *_o, const ::flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
 inline PacketWrapperT *PacketWrapper::UnPack(const ::flatbuffers::resolver_function_t *_resolver) const {
   auto _o = std::unique_ptr<PacketWrapperT>(new PacketWrapperT());
   UnPackTo(_o.get(), _resolver);
@@ -1924,6 +2122,64 @@ inline ::flatbuffers::Offset<TextC2S> CreateTextC2S(::flatbuffers::FlatBufferBui
       _text);
 }
 
+inline PingC2ST *PingC2S::UnPack(const ::flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = std::unique_ptr<PingC2ST>(new PingC2ST());
+  UnPackTo(_o.get(), _resolver);
+  return _o.release();
+}
+
+inline void PingC2S::UnPackTo(PingC2ST *_o, const ::flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = client_time(); _o->client_time = _e; }
+}
+
+inline ::flatbuffers::Offset<PingC2S> PingC2S::Pack(::flatbuffers::FlatBufferBuilder &_fbb, const PingC2ST* _o, const ::flatbuffers::rehasher_function_t *_rehasher) {
+  return CreatePingC2S(_fbb, _o, _rehasher);
+}
+
+inline ::flatbuffers::Offset<PingC2S> CreatePingC2S(::flatbuffers::FlatBufferBuilder &_fbb, const PingC2ST *_o, const ::flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { ::flatbuffers::FlatBufferBuilder *__fbb; const PingC2ST* __o; const ::flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _client_time = _o->client_time;
+  return Protocol::CreatePingC2S(
+      _fbb,
+      _client_time);
+}
+
+inline PongS2CT *PongS2C::UnPack(const ::flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = std::unique_ptr<PongS2CT>(new PongS2CT());
+  UnPackTo(_o.get(), _resolver);
+  return _o.release();
+}
+
+inline void PongS2C::UnPackTo(PongS2CT *_o, const ::flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = client_time(); _o->client_time = _e; }
+  { auto _e = server_receive_time(); _o->server_receive_time = _e; }
+  { auto _e = server_transmit_time(); _o->server_transmit_time = _e; }
+}
+
+inline ::flatbuffers::Offset<PongS2C> PongS2C::Pack(::flatbuffers::FlatBufferBuilder &_fbb, const PongS2CT* _o, const ::flatbuffers::rehasher_function_t *_rehasher) {
+  return CreatePongS2C(_fbb, _o, _rehasher);
+}
+
+inline ::flatbuffers::Offset<PongS2C> CreatePongS2C(::flatbuffers::FlatBufferBuilder &_fbb, const PongS2CT *_o, const ::flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { ::flatbuffers::FlatBufferBuilder *__fbb; const PongS2CT* __o; const ::flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _client_time = _o->client_time;
+  auto _server_receive_time = _o->server_receive_time;
+  auto _server_transmit_time = _o->server_transmit_time;
+  return Protocol::CreatePongS2C(
+      _fbb,
+      _client_time,
+      _server_receive_time,
+      _server_transmit_time);
+}
+
 inline bool VerifyPacketType(::flatbuffers::Verifier &verifier, const void *obj, PacketType type) {
   switch (type) {
     case PacketType_NONE: {
@@ -1977,6 +2233,14 @@ inline bool VerifyPacketType(::flatbuffers::Verifier &verifier, const void *obj,
       auto ptr = reinterpret_cast<const Protocol::TextS2C *>(obj);
       return verifier.VerifyTable(ptr);
     }
+    case PacketType_PingC2S: {
+      auto ptr = reinterpret_cast<const Protocol::PingC2S *>(obj);
+      return verifier.VerifyTable(ptr);
+    }
+    case PacketType_PongS2C: {
+      auto ptr = reinterpret_cast<const Protocol::PongS2C *>(obj);
+      return verifier.VerifyTable(ptr);
+    }
     default: return true;
   }
 }
@@ -2044,6 +2308,14 @@ inline void *PacketTypeUnion::UnPack(const void *obj, PacketType type, const ::f
       auto ptr = reinterpret_cast<const Protocol::TextS2C *>(obj);
       return ptr->UnPack(resolver);
     }
+    case PacketType_PingC2S: {
+      auto ptr = reinterpret_cast<const Protocol::PingC2S *>(obj);
+      return ptr->UnPack(resolver);
+    }
+    case PacketType_PongS2C: {
+      auto ptr = reinterpret_cast<const Protocol::PongS2C *>(obj);
+      return ptr->UnPack(resolver);
+    }
     default: return nullptr;
   }
 }
@@ -2099,6 +2371,14 @@ inline ::flatbuffers::Offset<void> PacketTypeUnion::Pack(::flatbuffers::FlatBuff
       auto ptr = reinterpret_cast<const Protocol::TextS2CT *>(value);
       return CreateTextS2C(_fbb, ptr, _rehasher).Union();
     }
+    case PacketType_PingC2S: {
+      auto ptr = reinterpret_cast<const Protocol::PingC2ST *>(value);
+      return CreatePingC2S(_fbb, ptr, _rehasher).Union();
+    }
+    case PacketType_PongS2C: {
+      auto ptr = reinterpret_cast<const Protocol::PongS2CT *>(value);
+      return CreatePongS2C(_fbb, ptr, _rehasher).Union();
+    }
     default: return 0;
   }
 }
@@ -2153,6 +2433,14 @@ inline PacketTypeUnion::PacketTypeUnion(const PacketTypeUnion &u) : type(u.type)
       value = new Protocol::TextS2CT(*reinterpret_cast<Protocol::TextS2CT *>(u.value));
       break;
     }
+    case PacketType_PingC2S: {
+      value = new Protocol::PingC2ST(*reinterpret_cast<Protocol::PingC2ST *>(u.value));
+      break;
+    }
+    case PacketType_PongS2C: {
+      value = new Protocol::PongS2CT(*reinterpret_cast<Protocol::PongS2CT *>(u.value));
+      break;
+    }
     default:
       break;
   }
@@ -2220,6 +2508,16 @@ inline void PacketTypeUnion::Reset() {
       delete ptr;
       break;
     }
+    case PacketType_PingC2S: {
+      auto ptr = reinterpret_cast<Protocol::PingC2ST *>(value);
+      delete ptr;
+      break;
+    }
+    case PacketType_PongS2C: {
+      auto ptr = reinterpret_cast<Protocol::PongS2CT *>(value);
+      delete ptr;
+      break;
+    }
     default: break;
   }
   value = nullptr;
@@ -0,0 +1,164 @@
+#include "replay.h"
+
+namespace Game {
+    static constexpr char ReplayMagic[4] = {'S', 'G', 'R', 'P'};
+    static constexpr uint32 ReplayVersion = 2;
+
+    ReplayWriter::~ReplayWriter() {
+        if (IsOpen()) {
+            Close(m_LastTick);
+        }
+    }
+
+    bool
+    ReplayWriter::Open(const std::string &path, const ReplayHeader &header) {
+        m_File.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_File.is_open()) {
+            std::cout << "Failed to open replay file '" << path << "' for writing.\n";
+            return false;
+        }
+
+        // Header is written as raw little endian values.
+        ReplayHeader out = header;
+        out.version = ReplayVersion;
+        m_File.write(ReplayMagic, sizeof(ReplayMagic));
+        m_File.write((const char *) &out.version, sizeof(out.version));
+        m_File.write((const char *) &out.asteroidSeed, sizeof(out.asteroidSeed));
+        m_File.write((const char *) &out.updateFrequency, sizeof(out.updateFrequency));
+        m_File.write((const char *) &out.startTime, sizeof(out.startTime));
+        m_File.write((const char *) &out.maxPlayers, sizeof(out.maxPlayers));
+
+        m_LastTick = 0;
+        LOG("Recording replay to " << path << '\n');
+        return true;
+    }
+
+    void
+    ReplayWriter::Close(const uint32 tick) {
+        ReplayEvent end;
+        end.tick = std::max(tick, m_LastTick);
+        end.type = ReplayEventType::End;
+        Write(end);
+        m_File.close();
+    }
+
+    void
+    ReplayWriter::Write(const ReplayEvent &event) {
+        if (!IsOpen()) {
+            return;
+        }
+
+        assert(event.tick >= m_LastTick);
+        WriteVarint(event.tick - m_LastTick);
+        m_LastTick = event.tick;
+
+        m_File.put(static_cast<char>(event.type));
+        WriteVarint(event.entity);
+
+        if (event.type == ReplayEventType::Input) {
+            WriteVarint(event.time);
+            WriteVarint(event.bitmap);
+        } else if (event.type == ReplayEventType::Checksum) {
+            m_File.write((const char *) &event.checksum, sizeof(event.checksum));
+        }
+    }
+
+    void
+    ReplayWriter::Flush() {
+        if (IsOpen()) {
+            m_File.flush();
+        }
+    }
+
+    void
+    ReplayWriter::WriteVarint(uint64 value) {
+        do {
+            uint8 bits = value & 0x7F;
+            value >>= 7;
+            if (value != 0) {
+                bits |= 0x80;
+            }
+            m_File.put(static_cast<char>(bits));
+        } while (value != 0);
+    }
+
+    bool
+    ReplayReader::Open(const std::string &path) {
+        m_File.open(path, std::ios::binary);
+        if (!m_File.is_open()) {
+            std::cout << "Failed to open replay file '" << path << "'.\n";
+            return false;
+        }
+
+        char magic[4];
+        m_File.read(magic, sizeof(magic));
+        m_File.read((char *) &m_Header.version, sizeof(m_Header.version));
+        m_File.read((char *) &m_Header.asteroidSeed, sizeof(m_Header.asteroidSeed));
+        m_File.read((char *) &m_Header.updateFrequency, sizeof(m_Header.updateFrequency));
+        m_File.read((char *) &m_Header.startTime, sizeof(m_Header.startTime));
+        m_File.read((char *) &m_Header.maxPlayers, sizeof(m_Header.maxPlayers));
+
+        if (!m_File || std::memcmp(magic, ReplayMagic, sizeof(magic)) != 0 || m_Header.version != ReplayVersion) {
+            std::cout << "'" << path << "' is not a valid replay file.\n";
+            m_File.close();
+            return false;
+        }
+
+        m_LastTick = 0;
+        return true;
+    }
+
+    bool
+    ReplayReader::Next(ReplayEvent &event) {
+        if (!IsOpen()) {
+            return false;
+        }
+
+        uint64 tickDelta = 0;
+        if (!ReadVarint(tickDelta)) {
+            return false;
+        }
+
+        const int type = m_File.get();
+        uint64 entity = 0;
+        if (type == std::char_traits<char>::eof() || !ReadVarint(entity)) {
+            return false;
+        }
+
+        event = ReplayEvent();
+        m_LastTick += static_cast<uint32>(tickDelta);
+        event.tick = m_LastTick;
+        event.type = static_cast<ReplayEventType>(type);
+        event.entity = static_cast<uint32>(entity);
+
+        if (event.type == ReplayEventType::Input) {
+            uint64 bitmap = 0;
+            if (!ReadVarint(event.time) || !ReadVarint(bitmap)) {
+                return false;
+            }
+            event.bitmap = static_cast<uint16>(bitmap);
+        } else if (event.type == ReplayEventType::Checksum) {
+            m_File.read((char *) &event.checksum, sizeof(event.checksum));
+            if (!m_File) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool
+    ReplayReader::ReadVarint(uint64 &value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const int byte = m_File.get();
+            if (byte == std::char_traits<char>::eof()) {
+                return false;
+            }
+            value |= static_cast<uint64>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
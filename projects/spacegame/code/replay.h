@@ -0,0 +1,86 @@
+#pragma once
+#include <fstream>
+#include <string>
+
+namespace Game {
+    /**
+    Binary log of everything that drives the server simulation. A log starts with a header followed by a stream
+    of events, each event is stamped with the server tick it was received on. Integers in events are written as
+    LEB128 varints and ticks are delta encoded, so an input event is usually 6-12 bytes.
+     */
+    enum class ReplayEventType : uint8 {
+        Connect = 0,
+        Disconnect = 1,
+        Input = 2,
+        End = 3,
+        // Simulation state checksum at the end of a tick.
+        Checksum = 4
+    };
+
+    struct ReplayEvent {
+        uint32 tick = 0;
+        ReplayEventType type = ReplayEventType::End;
+        uint32 entity = 0;
+
+        // Only used by input events.
+        uint64 time = 0;
+        uint16 bitmap = 0;
+
+        // Only used by checksum events.
+        uint32 checksum = 0;
+    };
+
+    struct ReplayHeader {
+        uint32 version = 2;
+        uint32 asteroidSeed = 0;
+        uint32 updateFrequency = 0;
+        uint64 startTime = 0;
+        // Decides the spawn point layout.
+        uint32 maxPlayers = 0;
+    };
+
+    class ReplayWriter {
+    public:
+        ReplayWriter() = default;
+
+        ~ReplayWriter();
+
+        bool Open(const std::string &path, const ReplayHeader &header);
+
+        // Writes an End event and closes the file.
+        void Close(uint32 tick);
+
+        void Write(const ReplayEvent &event);
+
+        void Flush();
+
+        bool IsOpen() const { return m_File.is_open(); }
+
+    private:
+        void WriteVarint(uint64 value);
+
+        std::ofstream m_File;
+        uint32 m_LastTick = 0;
+    };
+
+    class ReplayReader {
+    public:
+        ReplayReader() = default;
+
+        bool Open(const std::string &path);
+
+        // Reads the next event, returns false when there are no more events.
+        bool Next(ReplayEvent &event);
+
+        const ReplayHeader &GetHeader() const { return m_Header; }
+
+        bool IsOpen() const { return m_File.is_open(); }
+
+    private:
+        bool ReadVarint(uint64 &value);
+
+        std::ifstream m_File;
+        ReplayHeader m_Header;
+        uint32 m_LastTick = 0;
+    };
+}
@@ -1,6 +1,9 @@
 #include "server.h"
 #include "proto.h"
 #include "packets.h"
+#include "asteroidfield.h"
+#include "core/cvar.h"
+#include "core/jobsystem.h"
 #include <thread>
 
 using namespace flatbuffers;
@@ -31,24 +34,153 @@ namespace Game {
         };
     }
 
+    Server::~Server() {
+        if (m_ReplayWriter.IsOpen()) {
+            m_ReplayWriter.Close(m_CurrentFrame);
+        }
+    }
+
     void
     Server::CreateImpl(const uint16 port) {
-        m_Server.Create(port);
+        Core::CVar *maxPlayers = Core::CVarCreate(Core::CVar_Int, "sv_max_players", "32",
+                                                  "Maximum number of connected players");
+        Core::CVar *bandwidthIn = Core::CVarCreate(Core::CVar_Int, "sv_bandwidth_in", "0",
+                                                   "Incoming bandwidth limit in bytes/s, 0 is unlimited");
+        Core::CVar *bandwidthOut = Core::CVarCreate(Core::CVar_Int, "sv_bandwidth_out", "0",
+                                                    "Outgoing bandwidth limit in bytes/s, 0 is unlimited");
+        const uint32 numPlayers = static_cast<uint32>(std::max(1, Core::CVarReadInt(maxPlayers)));
+
+        m_Server.Create(port, numPlayers, static_cast<uint32>(std::max(0, Core::CVarReadInt(bandwidthIn))),
+                        static_cast<uint32>(std::max(0, Core::CVarReadInt(bandwidthOut))));
         m_Server.SetConnectCallback(Connect);
         m_Server.SetReceiveCallback(Receive);
         m_Server.SetDisconnectCallback(Disconnect);
 
-        m_ShipColliderMesh = Physics::LoadColliderMesh("assets/space/spaceship_physics.glb");
+        Initialize(AsteroidFieldSeed, Time::Now(), numPlayers);
+
+        Core::CVar *replayRecord = Core::CVarCreate(Core::CVar_String, "sv_replay_record", "",
+                                                    "Path to record a replay of the server session to");
+        const char *replayPath = Core::CVarReadString(replayRecord);
+        if (replayPath != nullptr && replayPath[0] != '\0') {
+            ReplayHeader header;
+            header.asteroidSeed = AsteroidFieldSeed;
+            header.updateFrequency = m_UpdateFrequency;
+            header.startTime = m_StartTime;
+            header.maxPlayers = m_MaxPlayers;
+            m_ReplayWriter.Open(replayPath, header);
+        }
+
+        m_Active = true;
+    }
+
+    void
+    Server::Initialize(const uint32 asteroidSeed, const uint64 startTime, const uint32 maxPlayers) {
+        // Load the collider meshes in parallel, the last job loads the ship.
+        Physics::ColliderMeshId asteroidMeshes[NumAsteroidTypes];
+        Core::ParallelFor(NumAsteroidTypes + 1, [this, &asteroidMeshes](const uint i) {
+            if (i < NumAsteroidTypes) {
+                asteroidMeshes[i] = Physics::LoadColliderMesh(AsteroidColliderPaths[i]);
+            } else {
+                m_ShipColliderMesh = Physics::LoadColliderMesh("assets/space/spaceship_physics.glb");
+            }
+        });
+
+        // Generate asteroids, the clients generate the same layout from the seed.
+        GenerateAsteroidField(asteroidSeed, [this, &asteroidMeshes](const uint32 type, const mat4 &transform) {
+            AddAsteroidImpl(asteroidMeshes[type], transform);
+        });
+
+        // Generate spawn points, at least one per player so that a full server does not have to share.
+        m_MaxPlayers = maxPlayers;
+        m_SpawnAllocator.Generate(std::max<uint32>(32, maxPlayers), 100.0f);
+
+        m_StartTime = startTime;
+        m_CurrentTime = startTime;
+        m_CurrentFrame = 0;
+    }
+
+    bool
+    Server::PlaybackImpl(const char *path) {
+        if (!m_ReplayReader.Open(path)) {
+            return false;
+        }
+
+        const ReplayHeader &header = m_ReplayReader.GetHeader();
+        if (header.updateFrequency != m_UpdateFrequency) {
+            std::cout << "Warning: replay was recorded at " << header.updateFrequency << " ticks/s, server runs at "
+                    << m_UpdateFrequency << " ticks/s.\n";
+        }
+
+        Initialize(header.asteroidSeed, header.startTime, header.maxPlayers);
+        m_Playback = true;
         m_Active = true;
+        m_ReplayFinished = !m_ReplayReader.Next(m_NextReplayEvent);
 
-        // Generate spawn points
+        const auto timeStart = std::chrono::steady_clock::now();
+        while (!m_ReplayFinished) {
+            UpdateImpl();
+        }
+        const auto timeEnd = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(timeEnd - timeStart).count();
+
+        std::cout << "Replayed " << m_CurrentFrame << " ticks (" << m_CurrentFrame / m_UpdateFrequency
+                << " s of game time) in " << seconds << " s, " << m_CurrentFrame / seconds << " ticks/s.\n";
+        std::cout << "Verified " << m_NumChecksumsVerified << " state checksums, " << m_NumChecksumMismatches
+                << " mismatches. Final checksum: " << std::hex << m_StateChecksum << std::dec << "\n";
 
-        for (int i = 0; i < 32; ++i) {
-            constexpr float pi2 = M_PI * 2.0f;
-            const float x = std::sin(pi2 * static_cast<float>(i) / 32.0f);
-            const float y = std::cos(pi2 * static_cast<float>(i) / 32.0f);
+        m_Active = false;
+        m_Playback = false;
+        return m_NumChecksumMismatches == 0;
+    }
 
-            m_SpawnPoints[i].point = vec3(x, 0.0f, y) * 100.0f;
+    void
+    Server::PlaybackEvents() {
+        while (!m_ReplayFinished && m_NextReplayEvent.tick <= m_CurrentFrame) {
+            const ReplayEvent &event = m_NextReplayEvent;
+
+            switch (event.type) {
+                case ReplayEventType::Connect: {
+                    ENetPeer &peer = m_ReplayPeers[event.entity];
+                    peer = {};
+                    ConnectImpl(Net::Packet(&peer));
+                    if (m_Connections[&peer] != event.entity) {
+                        std::cout << "Warning: replay diverged, connection got id " << m_Connections[&peer]
+                                << " but was recorded as " << event.entity << ".\n";
+                    }
+                    break;
+                }
+                case ReplayEventType::Disconnect: {
+                    auto peer = m_ReplayPeers.find(event.entity);
+                    if (peer != m_ReplayPeers.end()) {
+                        DisconnectImpl(Net::Packet(&peer->second));
+                        m_ReplayPeers.erase(peer);
+                    }
+                    break;
+                }
+                case ReplayEventType::Input: {
+                    auto peer = m_ReplayPeers.find(event.entity);
+                    if (peer != m_ReplayPeers.end()) {
+                        // Go through the same path as a received packet.
+                        const auto fbb = Packet::InputC2S(event.time, event.bitmap);
+                        ReceiveImpl(Net::Packet(&peer->second, fbb.GetBufferPointer(), fbb.GetSize()));
+                    }
+                    break;
+                }
+                case ReplayEventType::Checksum: {
+                    // Recorded after the tick was simulated, compared at the end of UpdateImpl.
+                    m_HasExpectedChecksum = true;
+                    m_ExpectedChecksum = event.checksum;
+                    break;
+                }
+                case ReplayEventType::End:
+                default:
+                    m_ReplayFinished = true;
+                    continue;
+            }
+
+            if (!m_ReplayReader.Next(m_NextReplayEvent)) {
+                m_ReplayFinished = true;
+            }
         }
     }
 
@@ -62,9 +194,21 @@ namespace Game {
         constexpr uint updateTime = 1000 / m_UpdateFrequency;
         constexpr float dt = 1.0f / static_cast<float>(m_UpdateFrequency);
 
-        m_CurrentTime = Time::Now();
+        m_CurrentTime = m_StartTime + static_cast<uint64>(m_CurrentFrame) * updateTime;
+        m_TickStartTime = Time::NowPrecise();
 
-        m_Server.Poll(0);
+        m_ShipPositions.clear();
+        for (const auto &player: m_Players) {
+            m_ShipPositions.push_back(player.second.transform.GetPosition());
+        }
+        m_SpawnAllocator.Update(m_ShipPositions);
+
+        if (m_Playback) {
+            PlaybackEvents();
+        } else {
+            m_Server.Poll(0);
+            DispatchPendingEvents();
+        }
 
         CheckCollisions();
 
@@ -87,11 +231,29 @@ namespace Game {
             }
 
             shipState.Update(dt);
-            SetTransform(m_PlayerColliders[shipState.id], shipState.transform.GetMatrix());
+            m_PhysicsWorld.SetTransform(m_PlayerColliders[shipState.id], shipState.transform.GetMatrix());
         }
 
         RemoveLasers();
 
+        m_StateChecksum = ComputeStateChecksum();
+        if (m_Playback) {
+            if (m_HasExpectedChecksum) {
+                if (m_StateChecksum == m_ExpectedChecksum) {
+                    m_NumChecksumsVerified++;
+                } else if (m_NumChecksumMismatches++ == 0) {
+                    std::cout << "Replay desync at tick " << m_CurrentFrame << ".\n";
+                }
+                m_HasExpectedChecksum = false;
+            }
+        } else if (m_ReplayWriter.IsOpen()) {
+            ReplayEvent checksum;
+            checksum.tick = m_CurrentFrame;
+            checksum.type = ReplayEventType::Checksum;
+            checksum.checksum = m_StateChecksum;
+            m_ReplayWriter.Write(checksum);
+        }
+
         // Only publish state every 10 updates. (5 times / s)
         if (m_CurrentFrame % 10 == 0) {
             // Send packets.
@@ -108,15 +270,16 @@ namespace Game {
                 m_DespawnPlayerPackets.pop();
             }
 
-            while (!m_RespawnPlayerPackets.empty()) {
-                const EntityId respawnId = m_RespawnPlayerPackets.front();
+            for (const EntityId respawnId: m_RespawnPlayerPackets) {
+                // The player may have disconnected since the collision, the despawn was sent then.
+                if (!m_Players.contains(respawnId)) continue;
+
                 const auto fbb = Packet::DespawnPlayerS2C(respawnId);
                 m_Server.BroadCast(fbb.GetBufferPointer(), fbb.GetSize());
 
-                m_RespawnPlayerPackets.pop();
-
                 SpawnPlayer(respawnId);
             }
+            m_RespawnPlayerPackets.clear();
 
             while (!m_SpawnLaserPackets.empty()) {
                 const auto fbb = Packet::SpawnLaserS2C(&m_SpawnLaserPackets.front());
@@ -145,8 +308,16 @@ namespace Game {
             }
         }
 
-        while (Time::Now() - m_CurrentTime < updateTime) {
-            // Wait.
+        if (!m_Playback) {
+            if (m_CurrentFrame % m_UpdateFrequency == 0) {
+                m_ReplayWriter.Flush();
+            }
+
+            // Keep receiving while waiting so that pings are answered, and stamped, when they arrive.
+            const uint64 nextUpdateTime = m_CurrentTime + updateTime;
+            while (Time::Now() < nextUpdateTime) {
+                m_Server.Poll(0);
+            }
         }
         m_CurrentFrame++;
     }
@@ -158,6 +329,7 @@ namespace Game {
 
         // Client connect
         m_Connections[packet.sender] = uuid;
+        m_ReplayWriter.Write({m_CurrentFrame, ReplayEventType::Connect, uuid});
 
         auto fbb = Packet::ClientConnectS2C(uuid, m_CurrentTime);
 
@@ -188,17 +360,49 @@ namespace Game {
 
 
         // Spawn player
+        m_Players[uuid].id = uuid;
+        SpawnPlayer(uuid);
+    }
 
-        // Claim spawn point
-        for (auto &spawnPoint: m_SpawnPoints) {
-            if (!spawnPoint.occupied) {
-                spawnPoint.occupied = true;
-                spawnPoint.playerId = uuid;
-                break;
+    void
+    Server::OnReceive(const Net::Packet &packet) {
+        const auto wrapper = Protocol::GetPacketWrapper(&packet.data[0]);
+
+        /**
+        A packet used by clients to synchronize their clock with the server, answered as soon as it arrives
+        with a pong. Both stamps are simulation time, the clock snapshots and lasers are stamped with.
+        - client_time: The client time when the ping was sent.
+         */
+        if (wrapper->packet_type() == Protocol::PacketType_PingC2S) {
+            const double receiveTime = SimulationNow();
+            const auto fbb = Packet::PongS2C(wrapper->packet_as_PingC2S()->client_time(), receiveTime,
+                                             SimulationNow());
+            m_Server.Send(packet.sender, fbb.GetBufferPointer(), fbb.GetSize());
+            return;
+        }
+
+        m_PendingEvents.push({PendingEvent::Receive, packet});
+    }
+
+    void
+    Server::DispatchPendingEvents() {
+        while (!m_PendingEvents.empty()) {
+            const PendingEvent &event = m_PendingEvents.front();
+            switch (event.type) {
+                case PendingEvent::Connect: ConnectImpl(event.packet);
+                    break;
+                case PendingEvent::Receive: ReceiveImpl(event.packet);
+                    break;
+                case PendingEvent::Disconnect: DisconnectImpl(event.packet);
+                    break;
             }
+            m_PendingEvents.pop();
         }
+    }
 
-        SpawnPlayer(uuid);
+    double
+    Server::SimulationNow() const {
+        return static_cast<double>(m_CurrentTime) + (Time::NowPrecise() - m_TickStartTime);
     }
 
     void
@@ -214,7 +418,11 @@ namespace Game {
              */
             case Protocol::PacketType_InputC2S: {
                 const auto inputData = wrapper.AsInputC2S();
-                auto &player = m_Players[m_Connections[packet.sender]];
+                const EntityId playerId = m_Connections[packet.sender];
+                auto &player = m_Players[playerId];
+                m_ReplayWriter.Write({
+                    m_CurrentFrame, ReplayEventType::Input, playerId, inputData->time, inputData->bitmap
+                });
 
                 // This check is to make sure a "shoot" command isn't overwritten.
                 const uint16 mask = player.input.Space()
@@ -246,19 +454,25 @@ namespace Game {
     Server::DisconnectImpl(const Net::Packet &packet) {
         LOG("Player disconnected\n");
         const EntityId disconnectedId = m_Connections[packet.sender];
+        m_ReplayWriter.Write({m_CurrentFrame, ReplayEventType::Disconnect, disconnectedId});
 
-        m_PlayerColliders.erase(disconnectedId);
+        const auto collider = m_PlayerColliders.find(disconnectedId);
+        if (collider != m_PlayerColliders.end()) {
+            m_PhysicsWorld.DestroyCollider(collider->second);
+            m_PlayerColliders.erase(collider);
+        }
 
         const auto fbb = Packet::DespawnPlayerS2C(disconnectedId);
         m_Server.BroadCast(fbb.GetBufferPointer(), fbb.GetSize());
 
         m_Players.erase(disconnectedId);
+        m_RespawnPlayerPackets.erase(disconnectedId);
         m_Connections.erase(packet.sender);
     }
 
     void
     Server::AddAsteroidImpl(const Physics::ColliderMeshId &colliderMesh, const mat4 &transform) {
-        m_AsteroidColliders.push_back(Physics::CreateCollider(colliderMesh, transform));
+        m_AsteroidColliders.push_back(m_PhysicsWorld.CreateCollider(colliderMesh, transform, AsteroidColliderMask));
         m_NextEntityId++;
     }
 
@@ -285,10 +499,30 @@ namespace Game {
 
     void
     Server::CheckCollisions() {
-        // Player vs player & player vs asteroid collision
+        // Player vs asteroid collision
         for (auto &player: m_Players) {
-            if (player.second.CheckCollisions()) {
-                m_RespawnPlayerPackets.push(player.first);
+            if (player.second.CheckCollisions(m_PhysicsWorld)) {
+                m_RespawnPlayerPackets.insert(player.first);
+            }
+        }
+
+        // Player vs player collision
+        m_ShipPairs.clear();
+        m_PhysicsWorld.FindOverlappingPairs(m_ShipPairs, ShipColliderMask);
+        const auto entityOf = [this](const Physics::ColliderId collider) {
+            return static_cast<EntityId>(reinterpret_cast<uintptr_t>(m_PhysicsWorld.GetUserData(collider)));
+        };
+        for (const auto &pair: m_ShipPairs) {
+            const EntityId first = entityOf(pair.first);
+            const EntityId second = entityOf(pair.second);
+            const auto firstIt = m_Players.find(first);
+            const auto secondIt = m_Players.find(second);
+            if (firstIt == m_Players.end() || secondIt == m_Players.end()) continue;
+
+            if (firstIt->second.Overlaps(secondIt->second)) {
+                m_CollisionPackets.push({first, second});
+                m_RespawnPlayerPackets.insert(first);
+                m_RespawnPlayerPackets.insert(second);
             }
         }
 
@@ -299,7 +533,7 @@ namespace Game {
             //Debug::DrawLine(rayStart, rayStart + laser.second.direction, 2, vec4(0, 1, 0, 1), vec4(0, 1, 0, 1),
             //                Debug::AlwaysOnTop);
 
-            Physics::RaycastPayload payload = Physics::Raycast(rayStart, laser.second.direction, 1.0f);
+            Physics::RaycastPayload payload = m_PhysicsWorld.Raycast(rayStart, laser.second.direction, 1.0f);
 
             if (payload.hit) {
                 auto playerIt = m_PlayerColliders.begin();
@@ -315,7 +549,7 @@ namespace Game {
                         continue; // ignore collisions with sender.
                     }
                     m_CollisionPackets.push({laser.first, playerIt->first});
-                    m_RespawnPlayerPackets.push(playerIt->first);
+                    m_RespawnPlayerPackets.insert(playerIt->first);
                 }
 
                 //if (m_Players.contains(playerIt->first))
@@ -358,30 +592,40 @@ namespace Game {
 
     void
     Server::SpawnPlayer(const EntityId id) {
-        auto spawnPoint = m_SpawnPoints.begin();
-        for (; spawnPoint != m_SpawnPoints.end(); ++spawnPoint) {
-            if (spawnPoint->playerId == id) {
-                break;
-            }
+        // Only connected players have a ship, ConnectImpl adds it and DisconnectImpl removes it.
+        const auto player = m_Players.find(id);
+        if (player == m_Players.end()) {
+            return;
         }
+        auto &ship = player->second;
 
-        auto &ship = m_Players[id];
-
-        ship.id = id;
+        const vec3 spawnPoint = m_SpawnAllocator.Get(m_SpawnAllocator.Allocate()).point;
         Transform transform;
-        transform.SetPosition(spawnPoint->point);
-        const vec3 dirToOrigin = normalize(-spawnPoint->point);
+        transform.SetPosition(spawnPoint);
+        const vec3 dirToOrigin = normalize(-spawnPoint);
         transform.SetOrientation(quat(vec3(0.0f, 0.0f, 1.0f), dirToOrigin));
 
         if (!m_PlayerColliders.contains(id)) {
-            m_PlayerColliders[id] = Physics::CreateCollider(m_ShipColliderMesh, transform.GetMatrix());
+            m_PlayerColliders[id] = m_PhysicsWorld.CreateCollider(m_ShipColliderMesh, transform.GetMatrix(),
+                                                            ShipColliderMask, reinterpret_cast<void *>(uintptr_t(id)));
         } else {
-            Physics::SetTransform(m_PlayerColliders[id], transform.GetMatrix());
+            m_PhysicsWorld.SetTransform(m_PlayerColliders[id], transform.GetMatrix());
         }
         ship.transform = transform;
         ship.linearVelocity = vec3();
         m_SpawnPlayerPackets.push(PackPlayer(ship));
     }
-}
-
 
+    uint32
+    Server::ComputeStateChecksum() const {
+        uint32 hash = Deterministic::Hash(m_NextEntityId);
+        for (const auto &player: m_Players) {
+            hash = Deterministic::Hash(player.second.Checksum(), hash);
+        }
+        for (const auto &laser: m_Lasers) {
+            hash = Deterministic::Hash(laser.first, hash);
+            hash = Deterministic::Hash(laser.second.transform.GetPosition(), hash);
+        }
+        return hash;
+    }
+}
@@ -1,38 +1,57 @@
 #pragma once
 #include "network/network.h"
+#include <map>
+#include <set>
 #include <unordered_map>
 
 #include "spaceship.h"
+#include "replay.h"
+#include "deterministic.h"
+#include "spawnallocator.h"
 #include "render/physics.h"
 
 
 namespace Game {
     typedef uint32 EntityId;
 
-    struct SpawnPoint {
-        uint32 playerId = 0;
-        vec3 point = vec3();
-        bool occupied = false;
-    };
-
     class Server {
     public:
+        ~Server();
+
         static void Create(const uint16 port) { s_Instance.CreateImpl(port); }
 
         static void Update() { s_Instance.UpdateImpl(); }
 
-        static void AddAsteroid(const Physics::ColliderMeshId &colliderMesh, const mat4 &transform) {
-            s_Instance.AddAsteroidImpl(colliderMesh, transform);
-        }
+        // Re-drives the server from a replay log without networking, as fast as possible.
+        // Fails if the log can't be read or the simulation diverged from the recorded checksums.
+        static bool Playback(const char *path) { return s_Instance.PlaybackImpl(path); }
+
+        // Checksum of the simulation state after the last tick.
+        static uint32 GetStateChecksum() { return s_Instance.m_StateChecksum; }
 
     private:
         void CreateImpl(uint16 port);
 
+        void Initialize(uint32 asteroidSeed, uint64 startTime, uint32 maxPlayers);
+
+        bool PlaybackImpl(const char *path);
+
+        void PlaybackEvents();
+
         void UpdateImpl();
 
-        static void Connect(const Net::Packet &packet) { s_Instance.ConnectImpl(packet); }
-        static void Receive(const Net::Packet &packet) { s_Instance.ReceiveImpl(packet); }
-        static void Disconnect(const Net::Packet &packet) { s_Instance.DisconnectImpl(packet); }
+        // Network events are queued as they arrive and handled at the start of the next tick, so the simulation
+        // sees them at the same point whether the server was waiting or polling. Pings are answered right away.
+        static void Connect(const Net::Packet &packet) { s_Instance.m_PendingEvents.push({PendingEvent::Connect, packet}); }
+        static void Receive(const Net::Packet &packet) { s_Instance.OnReceive(packet); }
+        static void Disconnect(const Net::Packet &packet) { s_Instance.m_PendingEvents.push({PendingEvent::Disconnect, packet}); }
+
+        void OnReceive(const Net::Packet &packet);
+
+        void DispatchPendingEvents();
+
+        // Simulation time in ms, the tick time advanced by the wall clock time since the tick started.
+        double SimulationNow() const;
 
         void ConnectImpl(const Net::Packet &packet);
 
@@ -50,34 +69,67 @@ namespace Game {
 
         void SpawnPlayer(EntityId id);
 
+        uint32 ComputeStateChecksum() const;
+
         bool m_Active = false;
+        bool m_Playback = false;
 
-        static constexpr uint m_UpdateFrequency = 50;
+        static constexpr uint m_UpdateFrequency = Deterministic::SimulationFrequency;
 
         std::unordered_map<const ENetPeer *, EntityId> m_Connections;
-        std::unordered_map<EntityId, SpaceShipState> m_Players;
+        // Ordered containers so that iteration order, and with it the simulation, is the same on every platform.
+        std::map<EntityId, SpaceShipState> m_Players;
+        // Kept apart from the default world so a hosting client's physics never sees the server's colliders.
+        Physics::World m_PhysicsWorld;
         Physics::ColliderMeshId m_ShipColliderMesh = {};
         std::unordered_map<EntityId, Physics::ColliderId> m_PlayerColliders;
+        std::vector<Physics::ColliderPair> m_ShipPairs;
 
-        std::unordered_map<EntityId, Laser> m_Lasers;
+        std::map<EntityId, Laser> m_Lasers;
         std::queue<EntityId> m_LasersToRemove;
 
         std::vector<Physics::ColliderId> m_AsteroidColliders;
 
-        std::array<SpawnPoint, 32> m_SpawnPoints;
+        SpawnAllocator m_SpawnAllocator;
+        std::vector<vec3> m_ShipPositions;
+        uint32 m_MaxPlayers = 0;
 
         static Server s_Instance;
 
         Net::Server m_Server;
         EntityId m_NextEntityId = 0;
 
+        // Simulation time is derived from the tick count so that a replay reproduces it exactly.
+        uint64 m_StartTime = 0;
         uint64 m_CurrentTime = 0;
+        // Wall clock time the current tick started at.
+        double m_TickStartTime = 0.0;
+
+        struct PendingEvent {
+            enum Type { Connect, Receive, Disconnect } type;
+            Net::Packet packet;
+        };
+        std::queue<PendingEvent> m_PendingEvents;
 
         uint32 m_CurrentFrame = 0;
 
+        uint32 m_StateChecksum = 0;
+
+        ReplayWriter m_ReplayWriter;
+        ReplayReader m_ReplayReader;
+        ReplayEvent m_NextReplayEvent;
+        bool m_ReplayFinished = false;
+        bool m_HasExpectedChecksum = false;
+        uint32 m_ExpectedChecksum = 0;
+        uint32 m_NumChecksumsVerified = 0;
+        uint32 m_NumChecksumMismatches = 0;
+        // Stand-in peers for the connections in a replay, keyed by the entity id they were given.
+        std::unordered_map<EntityId, ENetPeer> m_ReplayPeers;
+
         std::queue<Protocol::Player> m_SpawnPlayerPackets;
         std::queue<EntityId> m_DespawnPlayerPackets;
-        std::queue<EntityId> m_RespawnPlayerPackets;
+        // A set, a ship can collide several times before the next publish but is respawned once.
+        std::set<EntityId> m_RespawnPlayerPackets;
 
         std::queue<Protocol::Laser> m_SpawnLaserPackets;
         std::queue<EntityId> m_DespawnLaserPackets;
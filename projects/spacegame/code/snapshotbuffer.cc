@@ -0,0 +1,94 @@
+#include "config.h"
+#include "snapshotbuffer.h"
+
+namespace Game {
+    void
+    SnapshotBuffer::Push(const Snapshot &snapshot) {
+        if (m_Count > 0 && snapshot.time <= Newest().time) return;
+
+        if (m_Count == Capacity) {
+            m_Head = (m_Head + 1) % Capacity;
+            m_Count--;
+        }
+        m_Snapshots[(m_Head + m_Count) % Capacity] = snapshot;
+        m_Count++;
+    }
+
+    bool
+    SnapshotBuffer::Sample(const double time, Snapshot &result) const {
+        if (m_Count == 0) return false;
+
+        const Snapshot &newest = Newest();
+        if (time >= static_cast<double>(newest.time)) {
+            const double ahead = std::min(time - static_cast<double>(newest.time), MaxExtrapolationMs);
+            result = newest;
+            result.position += newest.velocity * static_cast<float>(ahead / 1000.0);
+            return true;
+        }
+
+        if (time <= static_cast<double>(At(0).time)) {
+            result = At(0);
+            return true;
+        }
+
+        // Updates are sampled close to the newest snapshot, search backwards.
+        uint32 i = m_Count - 2;
+        while (static_cast<double>(At(i).time) > time) {
+            i--;
+        }
+        const Snapshot &a = At(i);
+        const Snapshot &b = At(i + 1);
+
+        const float span = static_cast<float>(b.time - a.time) / 1000.0f;
+        const float t = static_cast<float>((time - static_cast<double>(a.time)) / static_cast<double>(b.time - a.time));
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+
+        // Cubic Hermite basis and its derivative.
+        const float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+        const float h10 = t3 - 2.0f * t2 + t;
+        const float h01 = -2.0f * t3 + 3.0f * t2;
+        const float h11 = t3 - t2;
+        const float dh00 = 6.0f * t2 - 6.0f * t;
+        const float dh10 = 3.0f * t2 - 4.0f * t + 1.0f;
+        const float dh11 = 3.0f * t2 - 2.0f * t;
+
+        result.time = static_cast<uint64>(time);
+        result.position = h00 * a.position + h10 * span * a.velocity + h01 * b.position + h11 * span * b.velocity;
+        result.velocity = dh00 * (a.position - b.position) / span + dh10 * a.velocity + dh11 * b.velocity;
+        result.orientation = slerp(a.orientation, b.orientation, t);
+        return true;
+    }
+
+    void
+    PlayoutClock::OnSnapshot(const uint64 serverTime, const double arrivalTime) {
+        // All entities updated in the same server tick share a timestamp, only measure the first one.
+        if (m_NumSnapshots > 0 && serverTime <= m_LastServerTime) return;
+
+        const float transit = static_cast<float>(arrivalTime - static_cast<double>(serverTime));
+        if (m_NumSnapshots == 0) {
+            m_Transit = transit;
+            m_Delay = m_Transit + m_Interval + DelayMargin;
+        } else {
+            const float sendDelta = static_cast<float>(serverTime - m_LastServerTime);
+            m_Interval += (sendDelta - m_Interval) / 8.0f;
+            m_Transit += (transit - m_Transit) / 16.0f;
+            // Interarrival jitter as in RFC 3550.
+            m_Jitter += (std::abs(transit - m_LastTransit) - m_Jitter) / 16.0f;
+        }
+
+        m_LastServerTime = serverTime;
+        m_LastTransit = transit;
+        m_NumSnapshots++;
+    }
+
+    void
+    PlayoutClock::Update(const uint64 now) {
+        if (m_LastUpdate != 0 && m_NumSnapshots > 0) {
+            const float target = m_Transit + m_Interval + JitterScale * m_Jitter + DelayMargin;
+            const float step = DelaySlewRate * static_cast<float>(now - m_LastUpdate);
+            m_Delay += clamp(target - m_Delay, -step, step);
+        }
+        m_LastUpdate = now;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+namespace Game {
+    // Server state of a remote entity at a point in server time.
+    struct Snapshot {
+        uint64 time = 0;
+        vec3 position = vec3(0.0f);
+        vec3 velocity = vec3(0.0f);
+        quat orientation = identity<quat>();
+    };
+
+    /**
+    Ring buffer of the latest snapshots of one entity. Sampling between two snapshots uses cubic Hermite
+    interpolation with the snapshot velocities as tangents, sampling past the newest snapshot extrapolates
+    for a short while and then holds.
+     */
+    class SnapshotBuffer {
+    public:
+        // Snapshots older than or equal to the newest one are dropped.
+        void Push(const Snapshot &snapshot);
+
+        bool Sample(double time, Snapshot &result) const;
+
+        void Clear() { m_Count = 0; }
+
+        uint32 Size() const { return m_Count; }
+
+        bool Empty() const { return m_Count == 0; }
+
+        const Snapshot &Newest() const { return At(m_Count - 1); }
+
+    private:
+        // Index 0 is the oldest snapshot in the buffer.
+        const Snapshot &At(const uint32 i) const { return m_Snapshots[(m_Head + i) % Capacity]; }
+
+        static constexpr uint32 Capacity = 32;
+        static constexpr double MaxExtrapolationMs = 250.0;
+
+        Snapshot m_Snapshots[Capacity];
+        uint32 m_Head = 0;
+        uint32 m_Count = 0;
+    };
+
+    /**
+    Decides at what server time remote entities are rendered. The render time trails the synchronized server
+    clock by a playout delay made up of the average snapshot transit time, one send interval and a multiple of
+    the measured jitter, so that there usually is a snapshot on both sides of it even when updates arrive
+    bunched.
+     */
+    class PlayoutClock {
+    public:
+        // Call once per received snapshot with the server clock estimate at arrival, times in ms.
+        void OnSnapshot(uint64 serverTime, double arrivalTime);
+
+        // Moves the playout delay towards its target, call once per frame.
+        void Update(uint64 now);
+
+        // Server time in ms to sample snapshot buffers at.
+        double GetRenderTime(const double serverNow) const { return serverNow - m_Delay; }
+
+        float GetDelay() const { return m_Delay; }
+
+        float GetJitter() const { return m_Jitter; }
+
+        float GetInterval() const { return m_Interval; }
+
+        float GetTransit() const { return m_Transit; }
+
+        bool IsValid() const { return m_NumSnapshots > 0; }
+
+    private:
+        static constexpr float JitterScale = 3.0f;
+        static constexpr float DelayMargin = 10.0f;
+        // How fast the delay may change, in ms per ms, so that the render time never jumps.
+        static constexpr float DelaySlewRate = 0.1f;
+
+        uint64 m_LastServerTime = 0;
+        uint64 m_LastUpdate = 0;
+        uint32 m_NumSnapshots = 0;
+
+        float m_LastTransit = 0.0f;
+        float m_Transit = 0.0f;
+        float m_Interval = 200.0f;
+        float m_Jitter = 0.0f;
+        float m_Delay = 0.0f;
+    };
+}
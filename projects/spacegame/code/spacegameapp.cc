@@ -23,6 +23,10 @@
 
 #include "proto.h"
 #include "spaceship.h"
+#include "asteroidfield.h"
+#include "deterministic.h"
+#include "core/cvar.h"
+#include "core/jobsystem.h"
 
 using namespace Display;
 using namespace Render;
@@ -76,63 +80,20 @@ namespace Game {
         Camera *cam = CameraManager::GetCamera(CAMERA_MAIN);
         cam->projection = projection;
 
-        // load all resources
-        const ModelId models[6] = {
-            LoadModel("assets/space/Asteroid_1.glb"),
-            LoadModel("assets/space/Asteroid_2.glb"),
-            LoadModel("assets/space/Asteroid_3.glb"),
-            LoadModel("assets/space/Asteroid_4.glb"),
-            LoadModel("assets/space/Asteroid_5.glb"),
-            LoadModel("assets/space/Asteroid_6.glb")
-        };
-
-
-        const Physics::ColliderMeshId colliderMeshes[6] = {
-            Physics::LoadColliderMesh("assets/space/Asteroid_1_physics.glb"),
-            Physics::LoadColliderMesh("assets/space/Asteroid_2_physics.glb"),
-            Physics::LoadColliderMesh("assets/space/Asteroid_3_physics.glb"),
-            Physics::LoadColliderMesh("assets/space/Asteroid_4_physics.glb"),
-            Physics::LoadColliderMesh("assets/space/Asteroid_5_physics.glb"),
-            Physics::LoadColliderMesh("assets/space/Asteroid_6_physics.glb")
-        };
-
-        constexpr int numNear = 100;
-        constexpr int numFar = 50;
-        m_Asteroids.reserve(numNear + numFar);
-
-        // Setup asteroids near
-        for (int i = 0; i < numNear; i++) {
-            const size_t resourceIndex = Core::FastRandom() % 6;
-            constexpr float span = 20.0f;
-            vec3 translation(
-                Core::RandomFloatNTP() * span,
-                Core::RandomFloatNTP() * span,
-                Core::RandomFloatNTP() * span
-            );
-            vec3 rotationAxis = normalize(translation);
-            const float rotation = translation.x;
-            mat4 transform = rotate(rotation, rotationAxis) * translate(translation);
-            m_Asteroids.emplace_back(models[resourceIndex], transform);
-
-            Server::AddAsteroid(colliderMeshes[resourceIndex], transform);
-        }
-
-        // Setup asteroids far
-        for (int i = 0; i < numFar; i++) {
-            const size_t resourceIndex = Core::FastRandom() % 6;
-            constexpr float span = 80.0f;
-            const vec3 translation(
-                Core::RandomFloatNTP() * span,
-                Core::RandomFloatNTP() * span,
-                Core::RandomFloatNTP() * span
-            );
-            vec3 rotationAxis = normalize(translation);
-            const float rotation = translation.x;
-            const mat4 transform = rotate(rotation, rotationAxis) * translate(translation);
-            m_Asteroids.emplace_back(models[resourceIndex], transform);
-
-            Server::AddAsteroid(colliderMeshes[resourceIndex], transform);
-        }
+        // load all resources, the files are parsed in parallel
+        std::vector<std::string> modelPaths(AsteroidModelPaths, AsteroidModelPaths + NumAsteroidTypes);
+        modelPaths.emplace_back("assets/space/spaceship.glb");
+        modelPaths.emplace_back("assets/space/laser.glb");
+        const std::vector<ModelId> loadedModels = LoadModels(modelPaths);
+        ModelId models[NumAsteroidTypes];
+        std::copy_n(loadedModels.begin(), NumAsteroidTypes, models);
+        const ModelId shipModel = loadedModels[NumAsteroidTypes];
+        const ModelId laserModel = loadedModels[NumAsteroidTypes + 1];
+
+        // Setup asteroids, the server generates its colliders from the same seed
+        GenerateAsteroidField(AsteroidFieldSeed, [this, &models](const uint32 type, const mat4 &transform) {
+            m_Asteroids.push_back({ models[type], transform });
+        });
 
         // Setup skybox
         std::vector<const char *> skybox
@@ -167,8 +128,6 @@ namespace Game {
                                                               1.0f + (15 + Core::RandomFloat() * 10.0f));
         }
 
-        const ModelId shipModel = LoadModel("assets/space/spaceship.glb");
-        const ModelId laserModel = LoadModel("assets/space/laser.glb");
 
 
         SpaceShipCamera camera;
@@ -180,6 +139,11 @@ namespace Game {
         float dt = 0.01667f;
         glfwSwapInterval(1);
 
+        // Step the predicted ship with the server's fixed time step so it follows the same path as the simulation.
+        Core::CVar *cl_fixed_step_prediction = Core::CVarCreate(Core::CVar_Int, "cl_fixed_step_prediction", "0",
+                                                                "Predict own ship at the fixed simulation rate");
+        float predictionAccumulator = 0.0f;
+
         bool isOpen = window->IsOpen();
 
         std::thread serverThread([&isOpen] {
@@ -216,25 +180,62 @@ namespace Game {
 
 
             // Store all drawcalls in the render device
-            for (auto const &asteroid: m_Asteroids) {
-                RenderDevice::Draw(asteroid.first, asteroid.second);
-            }
+            RenderDevice::Draw(m_Asteroids);
 
+            // The own ship moves the camera and reads input, update it before the rest
+            const double renderTime = Client::GetRenderTime();
+            m_RemoteShips.clear();
             for (auto &ship: m_SpaceShips) {
-                if (Client::GetId() == ship.first) {
-                    camera.target = ship.second.transform.GetMatrix();
-                    camera.Update(dt);
-                    ship.second.UserUpdate(input, dt);
+                if (Client::GetId() != ship.first) {
+                    m_RemoteShips.push_back(&ship.second);
+                    continue;
+                }
+                camera.target = ship.second.transform.GetMatrix();
+                camera.Update(dt);
+                if (Core::CVarReadInt(cl_fixed_step_prediction) > 0) {
+                    predictionAccumulator += dt;
+                    while (predictionAccumulator >= Deterministic::SimulationTimeStep) {
+                        ship.second.UserUpdate(input, Deterministic::SimulationTimeStep);
+                        predictionAccumulator -= Deterministic::SimulationTimeStep;
+                    }
                 } else {
-                    ship.second.Interpolate(dt);
+                    ship.second.UserUpdate(input, dt);
                 }
                 ship.second.Update(dt);
                 RenderDevice::Draw(shipModel, ship.second.transform.GetMatrix());
             }
 
+            m_LaserList.clear();
             for (auto &laser: m_Lasers) {
-                laser.second.Update(dt);
-                RenderDevice::Draw(laserModel, laser.second.transform.GetMatrix());
+                m_LaserList.push_back(&laser.second);
+            }
+
+            // Remote ships and lasers only touch their own state, update them and record their draws in parallel
+            constexpr uint32 entityChunkSize = 256;
+            const uint32 numRemoteShips = static_cast<uint32>(m_RemoteShips.size());
+            const uint32 numEntities = numRemoteShips + static_cast<uint32>(m_LaserList.size());
+            const uint32 numChunks = (numEntities + entityChunkSize - 1) / entityChunkSize;
+            if (m_DrawLists.size() < numChunks)
+                m_DrawLists.resize(numChunks);
+            Core::ParallelFor(numChunks, [&](const uint chunk) {
+                std::vector<DrawCommand> &list = m_DrawLists[chunk];
+                list.clear();
+                const uint32 end = std::min(numEntities, (chunk + 1) * entityChunkSize);
+                for (uint32 i = chunk * entityChunkSize; i < end; i++) {
+                    if (i < numRemoteShips) {
+                        SpaceShip *ship = m_RemoteShips[i];
+                        ship->Interpolate(renderTime);
+                        ship->Update(dt);
+                        list.push_back({ shipModel, ship->transform.GetMatrix() });
+                    } else {
+                        Laser *laser = m_LaserList[i - numRemoteShips];
+                        laser->Update(dt);
+                        list.push_back({ laserModel, laser->transform.GetMatrix() });
+                    }
+                }
+            });
+            for (uint32 i = 0; i < numChunks; i++) {
+                RenderDevice::Draw(m_DrawLists[i]);
             }
 
             // Execute the entire rendering pipeline
@@ -278,6 +279,12 @@ namespace Game {
             static bool isConnected = false;
             if (m_IsHost || isConnected) {
                 ImGui::Text("%s", Client::Status());
+                const PlayoutClock &playout = Client::GetPlayoutClock();
+                ImGui::Text("Playout delay: %.1f ms (transit %.1f ms, jitter %.1f ms, interval %.1f ms)",
+                            playout.GetDelay(), playout.GetTransit(), playout.GetJitter(), playout.GetInterval());
+                const TimeSync &timeSync = Client::GetTimeSync();
+                ImGui::Text("Clock offset: %.3f ms, drift: %.1f ppm, rtt: %.3f ms", timeSync.GetOffset(),
+                            timeSync.GetDrift() * 1e6, timeSync.GetRoundTripTime());
                 if (ImGui::Button("Disconnect")) {
                     Client::Disconnect();
                 }
@@ -36,7 +36,12 @@ namespace Game {
 
 		std::unordered_map<uint32, SpaceShip> m_SpaceShips;
 		std::unordered_map<uint32, Laser> m_Lasers;
-		std::vector<std::pair<Render::ModelId, mat4> > m_Asteroids;
+		std::vector<Render::DrawCommand> m_Asteroids;
+		/// entities updated and recorded in parallel each frame, rebuilt from the maps above
+		std::vector<SpaceShip *> m_RemoteShips;
+		std::vector<Laser *> m_LaserList;
+		/// one command list per chunk of entities
+		std::vector<std::vector<Render::DrawCommand> > m_DrawLists;
 		Display::Window *window = nullptr;
 
 		bool m_IsHost = false;
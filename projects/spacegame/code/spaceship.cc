@@ -1,5 +1,6 @@
 #include "config.h"
 #include "spaceship.h"
+#include "deterministic.h"
 
 #include "input/inputserver.h"
 #include "render/cameramanager.h"
@@ -131,13 +132,13 @@ namespace Game {
         rotXSmooth = mix(rotXSmooth, rotX * rotationSpeed, dt * smoothFactor);
         rotYSmooth = mix(rotYSmooth, rotY * rotationSpeed, dt * smoothFactor);
         rotZSmooth = mix(rotZSmooth, rotZ * rotationSpeed, dt * smoothFactor);
-        quat localOrientation = quat(vec3(-rotYSmooth, rotXSmooth, rotZSmooth));
+        const quat localOrientation = Deterministic::EulerToQuat(vec3(-rotYSmooth, rotXSmooth, rotZSmooth));
         this->rotationZ -= rotXSmooth;
         this->rotationZ = clamp(this->rotationZ, -45.0f, 45.0f);
 
         transform.SetOrientation(transform.GetOrientation() * localOrientation);
         //mat4 T = translate(this->position) * (mat4) this->orientation;
-        transform.GetMatrix() *= mat4(quat(vec3(0, 0, rotationZ)));
+        transform.GetMatrix() *= mat4(Deterministic::EulerToQuat(vec3(0, 0, rotationZ)));
         this->rotationZ = mix(this->rotationZ, 0.0f, dt * smoothFactor);
 
         //const vec3 &position = transform.GetPosition();
@@ -157,55 +158,34 @@ namespace Game {
     }
 
     void
-    SpaceShip::Interpolate(const float dt) {
+    SpaceShip::Interpolate(const double renderTime) {
         if (!init) return;
-        if (currentServerUpdate == 0 || lastServerUpdate == 0) return;
 
-        const float timeBetweenUpdates = static_cast<float>(currentServerUpdate - lastServerUpdate) / 1000.0f;
+        Snapshot sample;
+        if (!snapshots.Sample(renderTime, sample)) return;
 
-        const float normalT = timeSinceUpdate / timeBetweenUpdates;
-        timeSinceUpdate = timeSinceUpdate > timeBetweenUpdates ? timeBetweenUpdates : timeSinceUpdate + dt;
-
-        const vec3 &lastKnownPosition = *(vec3 *) &serverState.position();
-        const vec3 &lastKnownVelocity = *(vec3 *) &serverState.velocity();
-        const quat &lastKnownDirection = *(quat *) &serverState.direction();
-
-
-        assert(timeBetweenUpdates != 0);
-
-        const vec3 blendVelocity = mix(velocityStart, lastKnownVelocity, normalT);
-        const vec3 prevProjection = transformStart.GetPosition()
-                                    + blendVelocity * timeSinceUpdate;
-
-        const vec3 latestProjection = lastKnownPosition
-                                      + lastKnownVelocity * timeSinceUpdate;
-
-        transform.SetPosition(mix(prevProjection, latestProjection, normalT));
-
-        transform.SetOrientation(mix(transformStart.GetOrientation(), lastKnownDirection, normalT));
-
-        velocity = blendVelocity;
+        transform.SetPosition(sample.position);
+        transform.SetOrientation(sample.orientation);
+        velocity = sample.velocity;
     }
 
     void
-    SpaceShip::SetServerData(const Protocol::Player &data, const uint64 time, const bool reset) {
-        if (currentServerUpdate >= time) return;
-
-        lastServerUpdate = currentServerUpdate;
-        currentServerUpdate = time;
+    SpaceShip::SetServerData(const Protocol::Player &data, const uint64 serverTime, const uint64 receiveTime,
+                             const bool reset) {
+        if (!snapshots.Empty() && snapshots.Newest().time >= serverTime) return;
 
-        transformStart = transform;
-        velocityStart = velocity;
-        serverState = data;
-        timeSinceUpdate = 0.0f;
-
-        Interpolate(0.0f);
+        Snapshot snapshot;
+        snapshot.time = serverTime;
+        snapshot.position = *(vec3 *) &data.position();
+        snapshot.velocity = *(vec3 *) &data.velocity();
+        snapshot.orientation = *(quat *) &data.direction();
+        snapshots.Push(snapshot);
 
         if (reset) {
-            float dt = static_cast<float>(Time::Now() - time) / 1000.0f;
-            transform.SetOrientation(*(quat *) &data.direction());
-            velocity = *(vec3 *) &data.velocity();
-            transform.SetPosition(*(vec3 *) &data.position() + velocity * dt);
+            float dt = static_cast<float>(Time::Now() - receiveTime) / 1000.0f;
+            transform.SetOrientation(snapshot.orientation);
+            velocity = snapshot.velocity;
+            transform.SetPosition(snapshot.position + velocity * dt);
         }
     }
 
@@ -235,33 +215,87 @@ namespace Game {
         rotXSmooth = mix(rotXSmooth, rotX * rotationSpeed, dt * smoothFactor);
         rotYSmooth = mix(rotYSmooth, rotY * rotationSpeed, dt * smoothFactor);
         rotZSmooth = mix(rotZSmooth, rotZ * rotationSpeed, dt * smoothFactor);
-        quat localOrientation = quat(vec3(-rotYSmooth, rotXSmooth, rotZSmooth));
+        const quat localOrientation = Deterministic::EulerToQuat(vec3(-rotYSmooth, rotXSmooth, rotZSmooth));
         this->rotationZ -= rotXSmooth;
         this->rotationZ = clamp(this->rotationZ, -45.0f, 45.0f);
 
         transform.SetOrientation(transform.GetOrientation() * localOrientation);
         //mat4 T = translate(this->position) * (mat4) this->orientation;
-        transform.GetMatrix() *= mat4(quat(vec3(0, 0, rotationZ)));
+        transform.GetMatrix() *= mat4(Deterministic::EulerToQuat(vec3(0, 0, rotationZ)));
         this->rotationZ = mix(this->rotationZ, 0.0f, dt * smoothFactor);
     }
 
     bool
-    SpaceShipState::CheckCollisions() {
-        const mat4 rotation(transform.GetOrientation());
-        const vec3 position = transform.GetPosition();
-        bool hit = false;
-        for (int i = 0; i < 8; i++) {
-            const vec3 dir = rotation * vec4(normalize(colliderEndPoints[i]), 0.0f);
-            const float len = length(colliderEndPoints[i]);
-            const Physics::RaycastPayload payload = Physics::Raycast(position, dir, len);
-
-            // debug draw collision rays
-            // Debug::DrawLine(pos, pos + dir * len, 1.0f, glm::vec4(0, 1, 0, 1), glm::vec4(0, 1, 0, 1), Debug::RenderMode::AlwaysOnTop);
-            if (payload.hit) {
-                Debug::DrawDebugText("HIT", payload.hitPoint, vec4(1, 1, 1, 1));
-                hit = true;
+    SpaceShipState::CheckCollisions(const Physics::World &world) const {
+        const vec3 motion = linearVelocity * Deterministic::SimulationTimeStep;
+        const float distance = length(motion);
+        // A cast of length zero still reports overlaps at the start.
+        const vec3 dir = distance > 0.0f ? motion / distance : vec3(0.0f, 0.0f, 1.0f);
+        for (const vec4 &sphere: colliderSpheres) {
+            const vec3 center = transform.GetPosition() + transform.GetOrientation() * vec3(sphere);
+            if (world.SphereCast(center - motion, dir, sphere.w, distance, AsteroidColliderMask).hit)
+                return true;
+        }
+        return false;
+    }
+
+    bool
+    SpaceShipState::Overlaps(const SpaceShipState &other) const {
+        // Separating axis test between two oriented boxes, the 3 + 3 face axes and the 9 edge cross products.
+        const mat3 rotA(transform.GetOrientation());
+        const mat3 rotB(other.transform.GetOrientation());
+        const vec3 &a = hullHalfExtents;
+        const vec3 &b = other.hullHalfExtents;
+
+        // B's orientation and center expressed in A's frame.
+        mat3 r, absR;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                r[i][j] = dot(rotA[i], rotB[j]);
+                // Epsilon avoids false separation when edges are near parallel.
+                absR[i][j] = std::abs(r[i][j]) + 1e-6f;
+            }
+        }
+        const vec3 centerA = transform.GetPosition() + rotA * hullCenter;
+        const vec3 centerB = other.transform.GetPosition() + rotB * other.hullCenter;
+        const vec3 d = centerB - centerA;
+        const vec3 t(dot(d, rotA[0]), dot(d, rotA[1]), dot(d, rotA[2]));
+
+        for (int i = 0; i < 3; i++) {
+            const float rb = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+            if (std::abs(t[i]) > a[i] + rb) return false;
+        }
+        for (int j = 0; j < 3; j++) {
+            const float ra = a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+            const float tb = t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j];
+            if (std::abs(tb) > ra + b[j]) return false;
+        }
+        for (int i = 0; i < 3; i++) {
+            const int i1 = (i + 1) % 3;
+            const int i2 = (i + 2) % 3;
+            for (int j = 0; j < 3; j++) {
+                const int j1 = (j + 1) % 3;
+                const int j2 = (j + 2) % 3;
+                const float ra = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+                const float rb = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+                const float tl = t[i2] * r[i1][j] - t[i1] * r[i2][j];
+                if (std::abs(tl) > ra + rb) return false;
             }
         }
-        return hit;
+        return true;
+    }
+
+    uint32
+    SpaceShipState::Checksum() const {
+        uint32 hash = Deterministic::Hash(id);
+        hash = Deterministic::Hash(transform.GetPosition(), hash);
+        hash = Deterministic::Hash(transform.GetOrientation(), hash);
+        hash = Deterministic::Hash(linearVelocity, hash);
+        hash = Deterministic::Hash(currentSpeed, hash);
+        hash = Deterministic::Hash(rotationZ, hash);
+        hash = Deterministic::Hash(rotXSmooth, hash);
+        hash = Deterministic::Hash(rotYSmooth, hash);
+        hash = Deterministic::Hash(rotZSmooth, hash);
+        return hash;
     }
 }
@@ -2,7 +2,7 @@
 #include "keymap.h"
 #include "proto.h"
 #include "transform.h"
-#include "deadreckoning.h"
+#include "snapshotbuffer.h"
 #include "render/physics.h"
 
 namespace Render {
@@ -10,6 +10,10 @@ namespace Render {
 }
 
 namespace Game {
+    // Collider masks used by the server.
+    constexpr uint16 AsteroidColliderMask = 1 << 0;
+    constexpr uint16 ShipColliderMask = 1 << 1;
+
     struct Laser {
         explicit Laser(const Transform &transform);
 
@@ -49,9 +53,10 @@ namespace Game {
 
         void UserUpdate(KeyMap input, float dt);
 
-        void Interpolate(float dt);
+        // Places the ship at the given server time, in ms, using the buffered server snapshots.
+        void Interpolate(double renderTime);
 
-        void SetServerData(const Protocol::Player &data, uint64 time, bool reset);
+        void SetServerData(const Protocol::Player &data, uint64 serverTime, uint64 receiveTime, bool reset);
 
         uint32 id = 0;
         Transform transform;
@@ -65,14 +70,7 @@ namespace Game {
         //Render::ParticleEmitter *particleEmitterRight = nullptr;
 
     private:
-        float timeSinceUpdate = 0.0f;
-        uint64 lastServerUpdate = 0;
-        uint64 currentServerUpdate = 0;
-
-        Transform transformStart;
-        vec3 velocityStart = vec3();
-        Protocol::Player serverState;
-
+        SnapshotBuffer snapshots;
 
         const float normalSpeed = 1.0f;
         const float boostSpeed = normalSpeed * 2.0f;
@@ -106,17 +104,27 @@ namespace Game {
 
         void Update(float dt);
 
-        bool CheckCollisions();
-
-        const vec3 colliderEndPoints[8] = {
-            vec3(-1.10657, -0.480347, -0.346542), // right wing
-            vec3(1.10657, -0.480347, -0.346542), // left wing
-            vec3(-0.342382, 0.25109, -0.010299), // right top
-            vec3(0.342382, 0.25109, -0.010299), // left top
-            vec3(-0.285614, -0.10917, 0.869609), // right front
-            vec3(0.285614, -0.10917, 0.869609), // left front
-            vec3(-0.279064, -0.10917, -0.98846), // right back
-            vec3(0.279064, -0.10917, -0.98846) // right back
+        // Hull spheres swept over the distance moved in the last tick against the asteroids, so fast ships do not tunnel.
+        bool CheckCollisions(const Physics::World &world) const;
+
+        // Oriented box test around the hulls, narrow phase for ship vs ship collisions.
+        bool Overlaps(const SpaceShipState &other) const;
+
+        // Hash of the simulated state, equal on all platforms for equal inputs.
+        uint32 Checksum() const;
+
+        // Spheres covering the hull out to the wingtips, nose and tail, in ship space, swept against the asteroids.
+        static constexpr int NumColliderSpheres = 5;
+        const vec4 colliderSpheres[NumColliderSpheres] = {
+            vec4(-0.75f, -0.36f, -0.26f, 0.45f), // right wing
+            vec4(0.75f, -0.36f, -0.26f, 0.45f), // left wing
+            vec4(0.0f, -0.10917f, 0.5f, 0.5f), // front
+            vec4(0.0f, -0.10917f, -0.6f, 0.5f), // back
+            vec4(0.0f, 0.0f, -0.05f, 0.5f) // cockpit
         };
+
+        // Box enclosing the hull, in ship space.
+        const vec3 hullCenter = vec3(0.0f, -0.114629f, -0.059426f);
+        const vec3 hullHalfExtents = vec3(1.10657f, 0.365719f, 0.929035f);
     };
 }
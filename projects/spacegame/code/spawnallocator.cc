@@ -0,0 +1,75 @@
+#include "config.h"
+#include "spawnallocator.h"
+#include "deterministic.h"
+
+namespace Game {
+    void
+    SpawnAllocator::Generate(const uint32 count, const float radius) {
+        m_SpawnPoints.clear();
+        m_SpawnPoints.resize(count);
+        m_NumAllocations = 0;
+
+        // Fibonacci sphere, close to evenly spaced for any count.
+        constexpr float goldenAngle = 2.39996323f;
+        for (uint32 i = 0; i < count; ++i) {
+            const float y = 1.0f - 2.0f * (static_cast<float>(i) + 0.5f) / static_cast<float>(count);
+            const float ringRadius = std::sqrt(std::max(0.0f, 1.0f - y * y));
+            const float theta = goldenAngle * static_cast<float>(i);
+            m_SpawnPoints[i].point = vec3(Deterministic::Sin(theta) * ringRadius, y,
+                                          Deterministic::Cos(theta) * ringRadius) * radius;
+        }
+    }
+
+    void
+    SpawnAllocator::Update(const std::vector<vec3> &shipPositions) {
+        m_Occupancy.clear();
+        for (const vec3 &position: shipPositions) {
+            m_Occupancy[CellKey(position)]++;
+        }
+    }
+
+    uint32
+    SpawnAllocator::Allocate() {
+        assert(!m_SpawnPoints.empty());
+
+        uint32 best = 0;
+        uint32 bestContention = UINT32_MAX;
+        for (uint32 i = 0; i < m_SpawnPoints.size(); ++i) {
+            const uint32 contention = Contention(m_SpawnPoints[i].point);
+            if (contention < bestContention
+                || (contention == bestContention && m_SpawnPoints[i].lastUsed < m_SpawnPoints[best].lastUsed)) {
+                best = i;
+                bestContention = contention;
+            }
+        }
+
+        m_SpawnPoints[best].lastUsed = ++m_NumAllocations;
+        m_Occupancy[CellKey(m_SpawnPoints[best].point)]++;
+        return best;
+    }
+
+    uint64
+    SpawnAllocator::CellKey(const vec3 &position) const {
+        // 21 bits per axis is plenty for a grid of 25 unit cells.
+        const ivec3 cell = ivec3(floor(position / CellSize)) + ivec3(1 << 20);
+        return (static_cast<uint64>(cell.x & 0x1FFFFF) << 42)
+               | (static_cast<uint64>(cell.y & 0x1FFFFF) << 21)
+               | static_cast<uint64>(cell.z & 0x1FFFFF);
+    }
+
+    uint32
+    SpawnAllocator::Contention(const vec3 &position) const {
+        uint32 count = 0;
+        for (int x = -1; x <= 1; ++x) {
+            for (int y = -1; y <= 1; ++y) {
+                for (int z = -1; z <= 1; ++z) {
+                    const auto it = m_Occupancy.find(CellKey(position + vec3(x, y, z) * CellSize));
+                    if (it != m_Occupancy.end()) {
+                        count += it->second;
+                    }
+                }
+            }
+        }
+        return count;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+namespace Game {
+    struct SpawnPoint {
+        vec3 point = vec3();
+        // Allocation counter value when the point was last handed out.
+        uint32 lastUsed = 0;
+    };
+
+    /**
+    Hands out spawn points spread over a sphere around the asteroid field. Ship positions are binned into a
+    coarse grid, and the point with the fewest ships in its neighbouring cells is chosen, ties go to the point
+    that has been unused the longest. Points handed out are counted as occupied until the next Update so
+    that players spawning on the same tick are spread out as well.
+     */
+    class SpawnAllocator {
+    public:
+        void Generate(uint32 count, float radius);
+
+        // Rebuilds the occupancy grid, call once per tick before allocating.
+        void Update(const std::vector<vec3> &shipPositions);
+
+        // Returns the index of the least contended spawn point.
+        uint32 Allocate();
+
+        const SpawnPoint &Get(const uint32 index) const { return m_SpawnPoints[index]; }
+
+        uint32 Size() const { return static_cast<uint32>(m_SpawnPoints.size()); }
+
+    private:
+        uint64 CellKey(const vec3 &position) const;
+
+        uint32 Contention(const vec3 &position) const;
+
+        static constexpr float CellSize = 25.0f;
+
+        std::vector<SpawnPoint> m_SpawnPoints;
+        std::unordered_map<uint64, uint32> m_Occupancy;
+        uint32 m_NumAllocations = 0;
+    };
+}
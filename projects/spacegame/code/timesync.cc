@@ -0,0 +1,89 @@
+#include "config.h"
+#include "timesync.h"
+
+namespace Game {
+    void
+    TimeSync::Reset(const double serverTime, const double localTime) {
+        m_Offset = serverTime - localTime;
+        m_ReferenceTime = localTime;
+        m_Drift = 0.0;
+        m_RoundTripTime = 0.0;
+        m_NumSamples = 0;
+        m_HistoryCount = 0;
+        m_LastPing = -PingInterval;
+    }
+
+    void
+    TimeSync::AddSample(const double t0, const double t1, const double t2, const double t3) {
+        Sample sample;
+        sample.localTime = t3;
+        sample.offset = ((t1 - t0) + (t2 - t3)) * 0.5;
+        sample.delay = std::max(0.0, (t3 - t0) - (t2 - t1));
+        m_Filter[m_NumSamples % FilterSize] = sample;
+        m_NumSamples++;
+
+        const uint32 numFiltered = std::min(m_NumSamples, FilterSize);
+        const Sample *best = &m_Filter[0];
+        for (uint32 i = 1; i < numFiltered; i++) {
+            if (m_Filter[i].delay < best->delay) {
+                best = &m_Filter[i];
+            }
+        }
+        m_RoundTripTime = best->delay;
+
+        // The same sample stays the best one for a while, only add it to the history once.
+        if (m_HistoryCount == 0 || best->localTime > m_History[(m_HistoryCount - 1) % HistorySize].localTime) {
+            m_History[m_HistoryCount % HistorySize] = *best;
+            m_HistoryCount++;
+        }
+
+        Fit();
+    }
+
+    void
+    TimeSync::Fit() {
+        const uint32 count = std::min(m_HistoryCount, HistorySize);
+        const Sample &newest = m_History[(m_HistoryCount - 1) % HistorySize];
+        const Sample &oldest = m_History[m_HistoryCount > HistorySize ? m_HistoryCount % HistorySize : 0];
+
+        if (count < 4 || newest.localTime - oldest.localTime < MinDriftSpan) {
+            m_Offset = newest.offset;
+            m_ReferenceTime = newest.localTime;
+            m_Drift = 0.0;
+            return;
+        }
+
+        // Least squares line through the filtered offsets, relative to the mean to keep precision.
+        double meanTime = 0.0;
+        double meanOffset = 0.0;
+        for (uint32 i = 0; i < count; i++) {
+            meanTime += m_History[i].localTime - newest.localTime;
+            meanOffset += m_History[i].offset;
+        }
+        meanTime = meanTime / count + newest.localTime;
+        meanOffset /= count;
+
+        double covariance = 0.0;
+        double variance = 0.0;
+        for (uint32 i = 0; i < count; i++) {
+            const double dt = m_History[i].localTime - meanTime;
+            covariance += dt * (m_History[i].offset - meanOffset);
+            variance += dt * dt;
+        }
+
+        m_Offset = meanOffset;
+        m_ReferenceTime = meanTime;
+        m_Drift = variance > 0.0 ? std::clamp(covariance / variance, -MaxDrift, MaxDrift) : 0.0;
+    }
+
+    double
+    TimeSync::ServerTime(const double localTime) const {
+        return localTime + m_Offset + m_Drift * (localTime - m_ReferenceTime);
+    }
+
+    bool
+    TimeSync::ShouldPing(const double localTime) const {
+        const double interval = m_NumSamples < FilterSize ? FastPingInterval : PingInterval;
+        return localTime - m_LastPing >= interval;
+    }
+}
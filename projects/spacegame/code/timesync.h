@@ -0,0 +1,62 @@
+#pragma once
+
+namespace Game {
+    /**
+    NTP style estimate of the server clock. Every ping round trip gives an offset sample together with the
+    round trip delay it was measured over. The sample with the lowest delay among the latest few is the least
+    affected by queuing, those filtered samples are then fitted with a line over a longer window so that
+    clock drift between the machines is tracked as well. All times are in ms.
+     */
+    class TimeSync {
+    public:
+        // Coarse estimate used until the first round trip completes.
+        void Reset(double serverTime, double localTime);
+
+        // t0: ping sent, t1: ping received by server, t2: pong sent by server, t3: pong received.
+        void AddSample(double t0, double t1, double t2, double t3);
+
+        double ServerTime(double localTime) const;
+
+        bool ShouldPing(double localTime) const;
+
+        void OnPingSent(const double localTime) { m_LastPing = localTime; }
+
+        double GetOffset() const { return m_Offset; }
+
+        // Server clock rate relative to the local clock, minus one.
+        double GetDrift() const { return m_Drift; }
+
+        double GetRoundTripTime() const { return m_RoundTripTime; }
+
+        bool IsSynchronized() const { return m_NumSamples > 0; }
+
+    private:
+        struct Sample {
+            double localTime = 0.0;
+            double offset = 0.0;
+            double delay = 0.0;
+        };
+
+        void Fit();
+
+        static constexpr uint32 FilterSize = 8;
+        static constexpr uint32 HistorySize = 32;
+        // Ping quickly until the filter is full, then settle down.
+        static constexpr double FastPingInterval = 100.0;
+        static constexpr double PingInterval = 1000.0;
+        // Drift is only estimated over a window at least this long, shorter ones are dominated by noise.
+        static constexpr double MinDriftSpan = 10000.0;
+        static constexpr double MaxDrift = 0.0005;
+
+        Sample m_Filter[FilterSize];
+        Sample m_History[HistorySize];
+        uint32 m_NumSamples = 0;
+        uint32 m_HistoryCount = 0;
+
+        double m_Offset = 0.0;
+        double m_ReferenceTime = 0.0;
+        double m_Drift = 0.0;
+        double m_RoundTripTime = 0.0;
+        double m_LastPing = -PingInterval;
+    };
+}
@@ -32,8 +32,10 @@ public:
     }
 
     mat4 &GetMatrix() {
-        if (m_NeedsUpdate)
+        if (m_NeedsUpdate) {
             m_Transform = translate(m_Position) * mat4(m_Orientation) * scale(m_Scale);
+            m_NeedsUpdate = false;
+        }
         return m_Transform;
     }
 
@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+//  asteroidraycastbench.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/physics.h"
+#include "asteroidfield.h"
+#include <chrono>
+#include <filesystem>
+
+/// ctest reports the test as skipped instead of failed, see SKIP_RETURN_CODE
+static int const SkipReturnCode = 77;
+
+static uint32_t seed = 1;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static float
+RandomFloat(float min, float max)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return min + (float)(seed >> 8) / (float)(1 << 24) * (max - min);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static glm::vec3
+RandomPoint(float span)
+{
+    return glm::vec3(RandomFloat(-span, span), RandomFloat(-span, span), RandomFloat(-span, span));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Raycast throughput over the spacegame's asteroid field, with the real collider meshes and the
+    layout the server generates. Only uses the default world's free functions, so the same file
+    measures older versions of physics.cc too.
+    The assets are not part of the repository, they are looked for in the working directory or the
+    directory given as the first argument. Without them the benchmark is skipped.
+    Prints the times rather than checking them, they depend on the machine, and only mean something
+    in an optimized build.
+*/
+int
+main(int argc, char** argv)
+{
+    if (argc > 1)
+        std::filesystem::current_path(argv[1]);
+    for (char const* path : Game::AsteroidColliderPaths)
+    {
+        if (!std::filesystem::exists(path))
+        {
+            std::printf("%s not found, skipped\n", path);
+            return SkipReturnCode;
+        }
+    }
+
+    Physics::ColliderMeshId meshes[Game::NumAsteroidTypes];
+    for (uint32 i = 0; i < Game::NumAsteroidTypes; i++)
+        meshes[i] = Physics::LoadColliderMesh(Game::AsteroidColliderPaths[i]);
+    size_t numAsteroids = 0;
+    Game::GenerateAsteroidField(Game::AsteroidFieldSeed, [&meshes, &numAsteroids](uint32 type, glm::mat4 const& transform)
+    {
+        Physics::CreateCollider(meshes[type], transform);
+        numAsteroids++;
+    });
+
+    // lasers fired from anywhere in the field, in any direction
+    float const maxDistance = 200.0f;
+    struct Ray
+    {
+        glm::vec3 start;
+        glm::vec3 dir;
+    };
+    std::vector<Ray> rays(100000);
+    for (Ray& ray : rays)
+    {
+        ray.start = RandomPoint(80.0f);
+        ray.dir = glm::normalize(RandomPoint(1.0f) + glm::vec3(1e-3f));
+    }
+
+    std::vector<Physics::RaycastPayload> hits(rays.size());
+    std::vector<double> times;
+    for (int run = 0; run < 5; run++)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size(); i++)
+            hits[i] = Physics::Raycast(rays[i].start, rays[i].dir, maxDistance);
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+
+    // every hit is on its ray and in range
+    size_t numHits = 0;
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+        if (!hits[i].hit)
+            continue;
+        numHits++;
+        glm::vec3 const expected = rays[i].start + rays[i].dir * hits[i].hitDistance;
+        TEST_CHECK(hits[i].hitDistance >= 0.0f && hits[i].hitDistance <= maxDistance);
+        TEST_CHECK(glm::length(hits[i].hitPoint - expected) <= 1e-3f * glm::max(1.0f, hits[i].hitDistance));
+    }
+    TEST_CHECK(numAsteroids == 150);
+    TEST_CHECK(numHits > 0);
+
+    std::printf("%zu asteroids, %zu of %zu rays hit: fastest %.0f rays/s, median %.0f rays/s\n",
+        numAsteroids, numHits, rays.size(), (double)rays.size() / times.front(), (double)rays.size() / times[times.size() / 2]);
+    return Test::Result();
+}
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+//  drawsortbench.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/drawqueue.h"
+#include <chrono>
+
+using namespace Render;
+
+static uint32_t seed = 1;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static uint32_t
+Random(uint32_t n)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) % n;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Sorts copies of the items a number of times and prints the fastest and the median run next
+    to one std::stable_sort, which the result has to match.
+*/
+static void
+Benchmark(char const* name, std::vector<DrawItem> const& items)
+{
+    std::vector<DrawItem> expected = items;
+    auto const referenceStart = std::chrono::steady_clock::now();
+    std::stable_sort(expected.begin(), expected.end(), [](DrawItem const& a, DrawItem const& b)
+    {
+        return (a.key >> 28) < (b.key >> 28);
+    });
+    double const reference = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - referenceStart).count();
+
+    DrawSortScratch scratch;
+    std::vector<DrawItem> sorted;
+    std::vector<double> times;
+    for (int run = 0; run < 51; run++)
+    {
+        sorted = items;
+        auto const start = std::chrono::steady_clock::now();
+        SortDrawItems(sorted, scratch);
+        auto const end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+
+    bool same = sorted.size() == expected.size();
+    for (size_t i = 0; same && i < sorted.size(); i++)
+        same = sorted[i].key == expected[i].key && sorted[i].batch == expected[i].batch;
+    TEST_CHECK(same);
+
+    std::printf("%-12s %zu items: fastest %.3f ms, median %.3f ms, std::stable_sort %.3f ms\n", name, items.size(), times.front(), times[times.size() / 2], reference);
+}
+
+//------------------------------------------------------------------------------
+/**
+    SortDrawItems on a frame's worth of draws. Prints the times rather than checking them,
+    they depend on the machine, and only mean something in an optimized build.
+*/
+int
+main()
+{
+    size_t const count = 100000;
+    std::vector<DrawItem> items(count);
+
+    // what a scene looks like, few programs, a few hundred materials, depth all over
+    for (size_t i = 0; i < count; i++)
+    {
+        DrawQueue const queue = Random(10) == 0 ? DrawQueue::Mask : DrawQueue::Opaque;
+        items[i].key = MakeDrawKey(queue, Random(4), Random(300), (float)Random(10000) / 10000.0f);
+        items[i].batch = (uint32_t)i;
+    }
+    Benchmark("scene keys", items);
+
+    // every key bit random, no digit can be skipped
+    for (size_t i = 0; i < count; i++)
+        items[i].key = ((uint64_t)Random(1 << 18) << 46) | ((uint64_t)Random(1 << 18) << 28);
+    Benchmark("random keys", items);
+
+    // already sorted, as in a frame where nothing moved
+    DrawSortScratch scratch;
+    SortDrawItems(items, scratch);
+    Benchmark("sorted keys", items);
+
+    return Test::Result();
+}
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+//  frustumculltest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/frustumcull.h"
+
+using namespace Render;
+
+//------------------------------------------------------------------------------
+/**
+    Same test as CullSpheres, one sphere at a time, with the terms summed in the same order.
+*/
+static bool
+IsVisible(Frustum const& frustum, glm::vec3 const& center, float radius)
+{
+    for (glm::vec4 const& plane : frustum.planes)
+    {
+        if ((plane.x * center.x + plane.y * center.y) + (plane.z * center.z + plane.w) < -radius)
+            return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static std::vector<uint32_t>
+Cull(Frustum const& frustum, std::vector<glm::vec4> const& spheres)
+{
+    BoundingSpheres soa;
+    for (glm::vec4 const& sphere : spheres)
+        soa.Add(glm::vec3(sphere), sphere.w);
+    std::vector<uint32_t> visible;
+    CullSpheres(frustum, soa, visible);
+    return visible;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    float const epsilon = 1e-4f;
+
+    // orthographic planes are the box faces, pointing inwards
+    {
+        Frustum const frustum = ExtractFrustum(glm::ortho(-1.0f, 1.0f, -2.0f, 2.0f, 0.0f, 10.0f));
+        glm::vec4 const expected[6] = {
+            { 1, 0, 0, 1 }, { -1, 0, 0, 1 }, { 0, 1, 0, 2 }, { 0, -1, 0, 2 }, { 0, 0, -1, 0 }, { 0, 0, 1, 10 }
+        };
+        for (int p = 0; p < 6; p++)
+        {
+            for (int c = 0; c < 4; c++)
+                TEST_CHECK_NEAR(frustum.planes[p][c], expected[p][c], epsilon);
+        }
+    }
+
+    // perspective planes are normalized, so distances are in world units
+    glm::mat4 const view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum const frustum = ExtractFrustum(glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f) * view);
+    {
+        for (glm::vec4 const& plane : frustum.planes)
+            TEST_CHECK_NEAR(glm::length(glm::vec3(plane)), 1.0f, epsilon);
+        float const diagonal = glm::sqrt(0.5f);
+        TEST_CHECK_NEAR(frustum.planes[0].x, diagonal, epsilon); // left
+        TEST_CHECK_NEAR(frustum.planes[0].z, -diagonal, epsilon);
+        TEST_CHECK_NEAR(frustum.planes[0].w, 0.0f, epsilon);
+        TEST_CHECK_NEAR(frustum.planes[4].z, -1.0f, epsilon); // near
+        TEST_CHECK_NEAR(frustum.planes[4].w, -1.0f, epsilon);
+        TEST_CHECK_NEAR(frustum.planes[5].z, 1.0f, epsilon); // far
+        TEST_CHECK_NEAR(frustum.planes[5].w, 100.0f, 1e-2f);
+    }
+
+    // spheres just inside and just outside of every side
+    {
+        std::vector<glm::vec4> const spheres = {
+            { 0, 0, -10, 1 },       // in front of the camera
+            { 0, 0, 5, 1 },         // behind the camera
+            { 0, 0, 0.5f, 2 },      // reaches past the near plane
+            { 0, 0, -105, 4 },      // beyond the far plane
+            { 0, 0, -105, 6 },      // reaches back to the far plane
+            { 20, 0, -10, 1 },      // right of the frustum
+            { 20, 0, -10, 8 },      // reaches into it from the right
+            { 0, -20, -10, 1 },     // below
+            { 0, 20, -10, 8 },      // reaches into it from the top
+        };
+        std::vector<uint32_t> const visible = Cull(frustum, spheres);
+        std::vector<uint32_t> const expected = { 0, 2, 4, 6, 8 };
+        TEST_CHECK(visible == expected);
+    }
+
+    // no spheres, and no padding lanes showing up as visible
+    {
+        TEST_CHECK(Cull(frustum, {}).empty());
+        for (size_t count = 1; count <= 8; count++)
+        {
+            std::vector<glm::vec4> spheres(count, glm::vec4(0, 0, -10, 1));
+            TEST_CHECK(Cull(frustum, spheres).size() == count);
+        }
+    }
+
+    // random spheres agree with testing them one at a time, through both ways of filling the arrays
+    {
+        uint32_t seed = 987654321;
+        auto const random = [&seed](float lo, float hi)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * (float)(seed >> 8) / (float)(1 << 24);
+        };
+
+        size_t const count = 10003;
+        BoundingSpheres added;
+        BoundingSpheres set;
+        set.Resize(count);
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i < count; i++)
+        {
+            glm::vec3 const center(random(-150.0f, 150.0f), random(-150.0f, 150.0f), random(-150.0f, 50.0f));
+            float const radius = random(0.0f, 20.0f);
+            added.Add(center, radius);
+            set.Set(i, center, radius);
+            if (IsVisible(frustum, center, radius))
+                expected.push_back((uint32_t)i);
+        }
+        TEST_CHECK(!expected.empty() && expected.size() < count);
+
+        std::vector<uint32_t> visible;
+        CullSpheres(frustum, added, visible);
+        TEST_CHECK(visible == expected);
+        CullSpheres(frustum, set, visible);
+        TEST_CHECK(visible == expected);
+    }
+
+    return Test::Result();
+}
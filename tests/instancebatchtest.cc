@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+//  instancebatchtest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/instancebatch.h"
+
+using namespace Render;
+
+//------------------------------------------------------------------------------
+/**
+    The index of the command a transform came from, stored in its translation.
+*/
+static DrawCommand
+Command(ModelId model, int index)
+{
+    return { model, glm::translate(glm::vec3((float)index, 0.0f, 0.0f)) };
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    std::vector<InstanceBatch> batches;
+    std::vector<glm::mat4> transforms;
+
+    // nothing to draw
+    BuildInstanceBatches({}, batches, transforms);
+    TEST_CHECK(batches.empty());
+    TEST_CHECK(transforms.empty());
+
+    // one batch per model in ascending model order, instances in submission order
+    std::vector<DrawCommand> commands = {
+        Command(3, 0), Command(1, 1), Command(3, 2), Command(2, 3), Command(1, 4), Command(3, 5)
+    };
+    BuildInstanceBatches(commands, batches, transforms);
+    TEST_CHECK(batches.size() == 3);
+    TEST_CHECK(transforms.size() == commands.size());
+    if (batches.size() == 3)
+    {
+        TEST_CHECK(batches[0].modelId == 1 && batches[0].firstInstance == 0 && batches[0].numInstances == 2);
+        TEST_CHECK(batches[1].modelId == 2 && batches[1].firstInstance == 2 && batches[1].numInstances == 1);
+        TEST_CHECK(batches[2].modelId == 3 && batches[2].firstInstance == 3 && batches[2].numInstances == 3);
+    }
+    int const expectedOrder[] = { 1, 4, 3, 0, 2, 5 };
+    for (size_t i = 0; i < transforms.size(); i++)
+        TEST_CHECK(transforms[i][3].x == (float)expectedOrder[i]);
+
+    // every batch's instances use its model
+    for (InstanceBatch const& batch : batches)
+    {
+        for (uint32_t i = batch.firstInstance; i < batch.firstInstance + batch.numInstances; i++)
+            TEST_CHECK(commands[(int)transforms[i][3].x].modelId == batch.modelId);
+    }
+
+    // the output of the previous frame is replaced, not appended to
+    BuildInstanceBatches({ Command(7, 0), Command(7, 1) }, batches, transforms);
+    TEST_CHECK(batches.size() == 1);
+    TEST_CHECK(transforms.size() == 2);
+    if (batches.size() == 1)
+        TEST_CHECK(batches[0].modelId == 7 && batches[0].firstInstance == 0 && batches[0].numInstances == 2);
+
+    // many commands of a few models, the counts add up and the order within a model is kept
+    commands.clear();
+    for (int i = 0; i < 1000; i++)
+        commands.push_back(Command((ModelId)((i * 7) % 5), i));
+    BuildInstanceBatches(commands, batches, transforms);
+    TEST_CHECK(batches.size() == 5);
+    uint32_t total = 0;
+    for (size_t b = 0; b < batches.size(); b++)
+    {
+        TEST_CHECK(batches[b].firstInstance == total);
+        TEST_CHECK(b == 0 || batches[b - 1].modelId < batches[b].modelId);
+        total += batches[b].numInstances;
+        for (uint32_t i = batches[b].firstInstance + 1; i < batches[b].firstInstance + batches[b].numInstances; i++)
+            TEST_CHECK(transforms[i - 1][3].x < transforms[i][3].x);
+    }
+    TEST_CHECK(total == commands.size());
+
+    return Test::Result();
+}
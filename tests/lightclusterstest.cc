@@ -0,0 +1,166 @@
+//------------------------------------------------------------------------------
+//  lightclusterstest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/lightclusters.h"
+#include <vector>
+
+using namespace Render;
+
+static uint32_t seed = 31337;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static float
+Random(float lo, float hi)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float)(seed >> 8) / (float)(1 << 24);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+ClusterHasLight(LightClusters const& clusters, size_t cluster, uint32_t light)
+{
+    glm::uvec2 const range = clusters.clusters[cluster];
+    for (uint32_t i = range.x; i < range.x + range.y; i++)
+    {
+        if (clusters.lightIndices[i] == light)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    uint const width = 1280;
+    uint const height = 720;
+    float const nearPlane = 0.1f;
+    float const farPlane = 1000.0f;
+    glm::mat4 const projection = glm::perspective(glm::radians(60.0f), (float)width / (float)height, nearPlane, farPlane);
+    glm::mat4 const view = glm::lookAt(glm::vec3(5.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    LightClusters clusters;
+    ResizeLightClusters(clusters, width, height);
+    TEST_CHECK(clusters.dimensions == glm::uvec3(20, 12, ClusterDepthSlices));
+    TEST_CHECK(clusters.clusters.size() == 20 * 12 * ClusterDepthSlices);
+
+    // lights around the camera, behind it and beyond the far plane, a count that is not a multiple of four
+    size_t const count = 1001;
+    std::vector<glm::vec4> positions(count);
+    std::vector<float> radii(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        positions[i] = glm::vec4(Random(-100.0f, 100.0f), Random(-50.0f, 50.0f), Random(-1200.0f, 40.0f), 1.0f);
+        radii[i] = Random(0.5f, 20.0f);
+    }
+    // no radius, never in a cluster
+    radii[count - 1] = 0.0f;
+    positions[count - 1] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    AssignLightsToClusters(clusters, view, projection, positions.data(), radii.data(), count);
+
+    // every cluster's range is in the index list, the ranges are back to back and ascending within
+    uint32_t next = 0;
+    for (glm::uvec2 const range : clusters.clusters)
+    {
+        TEST_CHECK(range.x == next);
+        next = range.x + range.y;
+        for (uint32_t i = range.x + 1; i < range.x + range.y; i++)
+            TEST_CHECK(clusters.lightIndices[i - 1] < clusters.lightIndices[i]);
+    }
+    TEST_CHECK(next == clusters.lightIndices.size());
+    for (uint32_t light : clusters.lightIndices)
+        TEST_CHECK(light < count - 1);
+
+    // exponential depth slices, the planes read back from the projection are a little off at this far plane
+    float const sliceScale = clusters.depthSlicing.x;
+    float const sliceBias = clusters.depthSlicing.y;
+    TEST_CHECK_NEAR(sliceScale, (float)ClusterDepthSlices / glm::log(farPlane / nearPlane), 1e-3f);
+    TEST_CHECK_NEAR(sliceBias, -glm::log(nearPlane) * (float)ClusterDepthSlices / glm::log(farPlane / nearPlane), 1e-3f);
+    auto const clusterOf = [&](glm::vec3 const& viewPoint, size_t& cluster) -> bool
+    {
+        float const depth = -viewPoint.z;
+        if (depth <= nearPlane || depth >= farPlane * 0.99f)
+            return false;
+        float const slice = glm::log(depth) * sliceScale + sliceBias;
+        float const tileX = (projection[0][0] * viewPoint.x / depth * 0.5f + 0.5f) * width / ClusterTileSize;
+        float const tileY = (projection[1][1] * viewPoint.y / depth * 0.5f + 0.5f) * height / ClusterTileSize;
+        // the last row and column of tiles reach past the edges of the screen
+        if (tileX <= 0.0f || tileY <= 0.0f || tileX >= (float)width / ClusterTileSize || tileY >= (float)height / ClusterTileSize)
+            return false;
+        // points right on a cluster boundary could go either way
+        float const margin = 1e-3f;
+        for (float v : { slice, tileX, tileY })
+        {
+            if (glm::abs(v - glm::round(v)) < margin)
+                return false;
+        }
+        cluster = ((size_t)slice * clusters.dimensions.y + (size_t)tileY) * clusters.dimensions.x + (size_t)tileX;
+        return true;
+    };
+
+    // every point in a light's sphere is in a cluster that lists the light
+    size_t sampled = 0;
+    for (uint32_t light = 0; light < count - 1; light++)
+    {
+        glm::vec3 const center = glm::vec3(view * positions[light]);
+        for (int s = 0; s < 200; s++)
+        {
+            glm::vec3 offset(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+            if (glm::dot(offset, offset) > 1.0f)
+                continue;
+            size_t cluster;
+            if (!clusterOf(center + offset * radii[light] * 0.999f, cluster))
+                continue;
+            TEST_CHECK(ClusterHasLight(clusters, cluster, light));
+            sampled++;
+        }
+    }
+    TEST_CHECK(sampled > 10000);
+
+    // and no light is listed in a cluster whose view space box it does not reach
+    glm::uvec3 const dims = clusters.dimensions;
+    for (uint slice = 0; slice < dims.z; slice++)
+    {
+        float const sliceNear = glm::exp(((float)slice - sliceBias) / sliceScale);
+        float const sliceFar = glm::exp(((float)slice + 1.0f - sliceBias) / sliceScale);
+        for (uint ty = 0; ty < dims.y; ty++)
+        {
+            for (uint tx = 0; tx < dims.x; tx++)
+            {
+                glm::vec2 const ndcMin = glm::vec2(tx, ty) * (float)ClusterTileSize / glm::vec2(width, height) * 2.0f - 1.0f;
+                glm::vec2 const ndcMax = glm::min(glm::vec2(tx + 1, ty + 1) * (float)ClusterTileSize / glm::vec2(width, height) * 2.0f - 1.0f, glm::vec2(1.0f));
+                glm::vec2 const scale = glm::vec2(projection[0][0], projection[1][1]);
+                glm::vec3 const boxMin(glm::min(ndcMin * sliceNear, ndcMin * sliceFar) / scale, -sliceFar);
+                glm::vec3 const boxMax(glm::max(ndcMax * sliceNear, ndcMax * sliceFar) / scale, -sliceNear);
+
+                glm::uvec2 const range = clusters.clusters[((size_t)slice * dims.y + ty) * dims.x + tx];
+                for (uint32_t i = range.x; i < range.x + range.y; i++)
+                {
+                    uint32_t const light = clusters.lightIndices[i];
+                    glm::vec3 const center = glm::vec3(view * positions[light]);
+                    glm::vec3 const closest = glm::clamp(center, boxMin, boxMax);
+                    float const reach = radii[light] * 1.001f + 1e-3f;
+                    TEST_CHECK(glm::dot(center - closest, center - closest) <= reach * reach);
+                }
+            }
+        }
+    }
+
+    // nothing in range, nothing listed
+    AssignLightsToClusters(clusters, view, projection, positions.data() + count - 1, radii.data() + count - 1, 1);
+    TEST_CHECK(clusters.lightIndices.empty());
+    AssignLightsToClusters(clusters, view, projection, nullptr, nullptr, 0);
+    TEST_CHECK(clusters.lightIndices.empty());
+
+    return Test::Result();
+}
@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+//  physicssoakbench.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/physics.h"
+#include "render/gltf.h"
+#include <chrono>
+#include <filesystem>
+
+static uint32_t seed = 1;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static float
+RandomFloat(float min, float max)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return min + (float)(seed >> 8) / (float)(1 << 24) * (max - min);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static glm::vec3
+RandomPoint(float span)
+{
+    return glm::vec3(RandomFloat(-span, span), RandomFloat(-span, span), RandomFloat(-span, span));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Writes a unit uv sphere of about 2200 triangles as a glb, the collider meshes can only be loaded from files.
+*/
+static void
+WriteSphereMesh(std::filesystem::path const& path)
+{
+    uint32_t const rings = 24;
+    uint32_t const segments = 48;
+    std::vector<glm::vec3> vertices;
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        float const theta = glm::pi<float>() * (float)ring / (float)rings;
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            float const phi = glm::two_pi<float>() * (float)segment / (float)segments;
+            vertices.push_back(glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi)));
+        }
+    }
+    std::vector<uint32_t> indices;
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            uint32_t const a = ring * (segments + 1) + segment;
+            uint32_t const b = a + segments + 1;
+            if (ring > 0)
+                indices.insert(indices.end(), { a, a + 1, b });
+            if (ring < rings - 1)
+                indices.insert(indices.end(), { a + 1, b + 1, b });
+        }
+    }
+
+    fx::gltf::Document doc;
+    fx::gltf::Buffer& buffer = doc.buffers.emplace_back();
+    buffer.data.resize(vertices.size() * sizeof(glm::vec3) + indices.size() * sizeof(uint32_t));
+    buffer.byteLength = (uint32_t)buffer.data.size();
+    std::memcpy(buffer.data.data(), vertices.data(), vertices.size() * sizeof(glm::vec3));
+    std::memcpy(buffer.data.data() + vertices.size() * sizeof(glm::vec3), indices.data(), indices.size() * sizeof(uint32_t));
+
+    fx::gltf::BufferView& vertexView = doc.bufferViews.emplace_back();
+    vertexView.buffer = 0;
+    vertexView.byteLength = (uint32_t)(vertices.size() * sizeof(glm::vec3));
+    fx::gltf::BufferView& indexView = doc.bufferViews.emplace_back();
+    indexView.buffer = 0;
+    indexView.byteOffset = vertexView.byteLength;
+    indexView.byteLength = (uint32_t)(indices.size() * sizeof(uint32_t));
+
+    fx::gltf::Accessor& positions = doc.accessors.emplace_back();
+    positions.bufferView = 0;
+    positions.count = (uint32_t)vertices.size();
+    positions.componentType = fx::gltf::Accessor::ComponentType::Float;
+    positions.type = fx::gltf::Accessor::Type::Vec3;
+    positions.min = { -1.0f, -1.0f, -1.0f };
+    positions.max = { 1.0f, 1.0f, 1.0f };
+    fx::gltf::Accessor& triangles = doc.accessors.emplace_back();
+    triangles.bufferView = 1;
+    triangles.count = (uint32_t)indices.size();
+    triangles.componentType = fx::gltf::Accessor::ComponentType::UnsignedInt;
+    triangles.type = fx::gltf::Accessor::Type::Scalar;
+
+    fx::gltf::Primitive& primitive = doc.meshes.emplace_back().primitives.emplace_back();
+    primitive.attributes["POSITION"] = 0;
+    primitive.indices = 1;
+
+    fx::gltf::Save(doc, path, true);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+struct Ray
+{
+    glm::vec3 start;
+    glm::vec3 dir;
+};
+
+//------------------------------------------------------------------------------
+/**
+    Casts every ray a few times and returns the best throughput in rays per second.
+*/
+static double
+CastRays(Physics::World const& world, std::vector<Ray> const& rays, std::vector<Physics::RaycastPayload>& hits)
+{
+    double best = 0.0;
+    for (int pass = 0; pass < 3; pass++)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size(); i++)
+            hits[i] = world.Raycast(rays[i].start, rays[i].dir, 300.0f);
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = glm::max(best, (double)rays.size() / seconds);
+    }
+    return best;
+}
+
+//------------------------------------------------------------------------------
+/**
+    A server's life in colliders: an asteroid field that never changes and ships that come and go.
+    Churns through thousands of connects and disconnects, destroying and creating a ship collider
+    for each, and prints the raycast throughput after every round. It should stay where it started.
+    Reconnected ships return to the same place, so every round has to give the same hits.
+    Prints the times rather than checking them, they depend on the machine.
+*/
+int
+main()
+{
+    std::filesystem::path const meshPath = std::filesystem::temp_directory_path() / "physicssoakbench_sphere.glb";
+    WriteSphereMesh(meshPath);
+    Physics::ColliderMeshId const mesh = Physics::LoadColliderMesh(meshPath.string());
+
+    uint16_t const asteroidMask = 1;
+    uint16_t const shipMask = 2;
+    Physics::World world;
+    for (int i = 0; i < 150; i++)
+    {
+        glm::vec3 const position = RandomPoint(i < 100 ? 20.0f : 80.0f);
+        world.CreateCollider(mesh, glm::translate(position) * glm::scale(glm::vec3(RandomFloat(1.0f, 3.0f))), asteroidMask);
+    }
+
+    size_t const numShips = 32;
+    std::vector<glm::mat4> shipTransforms;
+    std::vector<Physics::ColliderId> ships;
+    for (size_t i = 0; i < numShips; i++)
+    {
+        shipTransforms.push_back(glm::translate(RandomPoint(30.0f)) * glm::scale(glm::vec3(0.5f)));
+        ships.push_back(world.CreateCollider(mesh, shipTransforms[i], shipMask));
+    }
+
+    std::vector<Ray> rays(20000);
+    for (Ray& ray : rays)
+    {
+        ray.start = glm::normalize(RandomPoint(1.0f)) * 120.0f;
+        ray.dir = glm::normalize(RandomPoint(30.0f) - ray.start);
+    }
+
+    std::vector<Physics::RaycastPayload> expected(rays.size());
+    double const first = CastRays(world, rays, expected);
+    size_t numHits = 0;
+    for (Physics::RaycastPayload const& hit : expected)
+        numHits += hit.hit ? 1 : 0;
+    TEST_CHECK(numHits > 0 && numHits < rays.size());
+    std::printf("%zu colliders, %zu of %zu rays hit: %.0f rays/s\n", 150 + numShips, numHits, rays.size(), first);
+
+    std::vector<Physics::RaycastPayload> hits(rays.size());
+    int const cyclesPerRound = 1000;
+    double last = first;
+    for (int round = 1; round <= 10; round++)
+    {
+        for (int cycle = 0; cycle < cyclesPerRound; cycle++)
+        {
+            size_t const ship = (size_t)RandomFloat(0.0f, (float)numShips);
+            world.DestroyCollider(ships[ship]);
+            ships[ship] = world.CreateCollider(mesh, shipTransforms[ship], shipMask);
+        }
+
+        last = CastRays(world, rays, hits);
+        bool same = true;
+        for (size_t i = 0; same && i < rays.size(); i++)
+            same = hits[i].hit == expected[i].hit && hits[i].hitDistance == expected[i].hitDistance;
+        TEST_CHECK(same);
+        std::printf("after %5d connects and disconnects: %.0f rays/s\n", round * cyclesPerRound, last);
+    }
+    std::printf("last round at %.0f%% of the first\n", 100.0 * last / first);
+
+    std::error_code error;
+    std::filesystem::remove(meshPath, error);
+    std::filesystem::remove(meshPath.string() + ".collider", error);
+    return Test::Result();
+}
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+//  rangeallocatortest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "core/rangeallocator.h"
+#include <vector>
+
+using Util::RangeAllocator;
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    // nothing fits in an empty allocator, and zero sized ranges are never handed out
+    {
+        RangeAllocator allocator;
+        TEST_CHECK(allocator.Allocate(1) == RangeAllocator::InvalidOffset);
+        allocator.Grow(16);
+        TEST_CHECK(allocator.Allocate(0) == RangeAllocator::InvalidOffset);
+        TEST_CHECK(allocator.Allocate(16) == 0);
+        TEST_CHECK(allocator.Allocate(1) == RangeAllocator::InvalidOffset);
+    }
+
+    // ranges are handed out back to back and freed ranges merge with their neighbours
+    {
+        RangeAllocator allocator(100);
+        uint32_t const a = allocator.Allocate(10);
+        uint32_t const b = allocator.Allocate(20);
+        uint32_t const c = allocator.Allocate(30);
+        TEST_CHECK(a == 0 && b == 10 && c == 30);
+        TEST_CHECK(allocator.GetUsed() == 60);
+        TEST_CHECK(allocator.GetNumFreeRanges() == 1);
+        TEST_CHECK(allocator.GetLargestFreeRange() == 40);
+
+        allocator.Free(a, 10);
+        allocator.Free(c, 30);
+        TEST_CHECK(allocator.GetUsed() == 20);
+        // [0, 10) and [30, 100), the second merged with the tail
+        TEST_CHECK(allocator.GetNumFreeRanges() == 2);
+        TEST_CHECK(allocator.GetLargestFreeRange() == 70);
+
+        allocator.Free(b, 20);
+        TEST_CHECK(allocator.GetUsed() == 0);
+        TEST_CHECK(allocator.GetNumFreeRanges() == 1);
+        TEST_CHECK(allocator.GetLargestFreeRange() == 100);
+    }
+
+    // the smallest free range that fits is taken
+    {
+        RangeAllocator allocator(100);
+        uint32_t const a = allocator.Allocate(30);
+        uint32_t const b = allocator.Allocate(10);
+        uint32_t const c = allocator.Allocate(8);
+        uint32_t const d = allocator.Allocate(10);
+        TEST_CHECK(a == 0 && b == 30 && c == 40 && d == 48);
+        // free [0, 30) and [40, 48), the tail [58, 100) is free as well
+        allocator.Free(a, 30);
+        allocator.Free(c, 8);
+        TEST_CHECK(allocator.Allocate(8) == 40);
+        TEST_CHECK(allocator.Allocate(20) == 0);
+        TEST_CHECK(allocator.Allocate(40) == 58);
+        TEST_CHECK(allocator.Allocate(11) == RangeAllocator::InvalidOffset);
+        TEST_CHECK(allocator.Allocate(10) == 20);
+        TEST_CHECK(allocator.GetUsed() == 98);
+    }
+
+    // growing keeps the allocations where they are and merges with a free tail
+    {
+        RangeAllocator allocator(10);
+        uint32_t const a = allocator.Allocate(6);
+        TEST_CHECK(allocator.Allocate(8) == RangeAllocator::InvalidOffset);
+        allocator.Grow(20);
+        TEST_CHECK(allocator.GetCapacity() == 20);
+        TEST_CHECK(allocator.GetNumFreeRanges() == 1);
+        TEST_CHECK(allocator.Allocate(8) == 6);
+        allocator.Free(a, 6);
+        TEST_CHECK(allocator.Allocate(6) == 0);
+        TEST_CHECK(allocator.GetUsed() == 14);
+        TEST_CHECK(allocator.GetNumFreeRanges() == 1);
+        TEST_CHECK(allocator.GetLargestFreeRange() == 6);
+    }
+
+    // random allocations and frees never hand out overlapping ranges
+    {
+        uint32_t const capacity = 4096;
+        RangeAllocator allocator(capacity);
+        std::vector<uint8_t> owner(capacity, 0);
+        struct Range { uint32_t offset, size; };
+        std::vector<Range> live;
+        uint32_t seed = 12345;
+        auto const random = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+        for (int i = 0; i < 20000; i++)
+        {
+            if (live.empty() || random() % 3 != 0)
+            {
+                uint32_t const size = 1 + random() % 64;
+                uint32_t const offset = allocator.Allocate(size);
+                if (offset == RangeAllocator::InvalidOffset)
+                {
+                    TEST_CHECK(allocator.GetLargestFreeRange() < size);
+                    continue;
+                }
+                TEST_CHECK(offset + size <= capacity);
+                for (uint32_t e = offset; e < offset + size; e++)
+                {
+                    TEST_CHECK(owner[e] == 0);
+                    owner[e] = 1;
+                }
+                live.push_back({ offset, size });
+            }
+            else
+            {
+                size_t const index = random() % live.size();
+                Range const range = live[index];
+                live[index] = live.back();
+                live.pop_back();
+                for (uint32_t e = range.offset; e < range.offset + range.size; e++)
+                    owner[e] = 0;
+                allocator.Free(range.offset, range.size);
+            }
+        }
+        uint32_t used = 0;
+        for (Range const& range : live)
+            used += range.size;
+        TEST_CHECK(allocator.GetUsed() == used);
+
+        for (Range const& range : live)
+            allocator.Free(range.offset, range.size);
+        TEST_CHECK(allocator.GetUsed() == 0);
+        TEST_CHECK(allocator.GetNumFreeRanges() == 1);
+        TEST_CHECK(allocator.GetLargestFreeRange() == capacity);
+    }
+
+    return Test::Result();
+}
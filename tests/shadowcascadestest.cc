@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+//  shadowcascadestest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/shadowcascades.h"
+
+using namespace Render;
+
+//------------------------------------------------------------------------------
+/**
+    True if the world space point is inside the shadow volume, with a little slack for float noise.
+*/
+static bool
+InsideShadowVolume(glm::mat4 const& viewProjection, glm::vec3 const& point)
+{
+    glm::vec4 const clip = viewProjection * glm::vec4(point, 1.0f);
+    float const slack = 1e-4f;
+    return glm::all(glm::lessThanEqual(glm::abs(glm::vec3(clip) / clip.w), glm::vec3(1.0f + slack)));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Corners of the part of the camera's frustum between two view depths, in world space.
+*/
+static void
+SliceCorners(glm::mat4 const& invView, glm::mat4 const& projection, float sliceNear, float sliceFar, glm::vec3 corners[8])
+{
+    int i = 0;
+    for (float depth : { sliceNear, sliceFar })
+    {
+        for (float x : { -1.0f, 1.0f })
+        {
+            for (float y : { -1.0f, 1.0f })
+                corners[i++] = glm::vec3(invView * glm::vec4(x * depth / projection[0][0], y * depth / projection[1][1], -depth, 1.0f));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    // uniform, logarithmic and blended splits
+    {
+        float splits[4];
+        ComputeCascadeSplits(1.0f, 101.0f, 4, 0.0f, splits);
+        TEST_CHECK_NEAR(splits[0], 26.0f, 1e-4f);
+        TEST_CHECK_NEAR(splits[1], 51.0f, 1e-4f);
+        TEST_CHECK_NEAR(splits[2], 76.0f, 1e-4f);
+        TEST_CHECK(splits[3] == 101.0f);
+
+        ComputeCascadeSplits(1.0f, 10000.0f, 4, 1.0f, splits);
+        TEST_CHECK_NEAR(splits[0], 10.0f, 1e-3f);
+        TEST_CHECK_NEAR(splits[1], 100.0f, 1e-2f);
+        TEST_CHECK_NEAR(splits[2], 1000.0f, 1e-1f);
+        TEST_CHECK(splits[3] == 10000.0f);
+
+        ComputeCascadeSplits(0.1f, 500.0f, 4, 0.75f, splits);
+        float previous = 0.1f;
+        for (float split : splits)
+        {
+            TEST_CHECK(split > previous);
+            previous = split;
+        }
+        TEST_CHECK(splits[3] == 500.0f);
+
+        ComputeCascadeSplits(0.5f, 80.0f, 1, 0.75f, splits);
+        TEST_CHECK(splits[0] == 80.0f);
+    }
+
+    glm::mat4 const projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    glm::vec3 const lightDirection = glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f));
+    uint const resolution = 2048;
+    float const casterDistance = 50.0f;
+
+    // every slice corner is inside its cascade, and so is everything casterDistance towards the light from it
+    glm::vec3 const eyes[] = { { 0, 0, 0 }, { 13.7f, 2.5f, -40.1f }, { -300.25f, 80.0f, 1234.5f } };
+    glm::vec3 const targets[] = { { 0, 0, -1 }, { 1, -0.5f, 0.2f }, { -0.3f, 0.1f, 1 } };
+    for (glm::vec3 const& eye : eyes)
+    {
+        for (glm::vec3 const& target : targets)
+        {
+            glm::mat4 const invView = glm::inverse(glm::lookAt(eye, eye + target, glm::vec3(0.0f, 1.0f, 0.0f)));
+            ShadowCascades cascades;
+            ComputeShadowCascades(cascades, invView, projection, lightDirection * 3.0f, 4, resolution, 200.0f, casterDistance);
+            TEST_CHECK(cascades.count == 4);
+            TEST_CHECK(cascades.splits[3] == 200.0f);
+
+            float sliceNear = 0.1f;
+            for (uint c = 0; c < cascades.count; c++)
+            {
+                glm::vec3 corners[8];
+                SliceCorners(invView, projection, sliceNear, cascades.splits[c], corners);
+                for (glm::vec3 const& corner : corners)
+                {
+                    TEST_CHECK(InsideShadowVolume(cascades.viewProjections[c], corner));
+                    TEST_CHECK(InsideShadowVolume(cascades.viewProjections[c], corner + lightDirection * casterDistance));
+                }
+                sliceNear = cascades.splits[c];
+            }
+        }
+    }
+
+    // the count is clamped, and the cascades stop at the far plane
+    {
+        ShadowCascades cascades;
+        ComputeShadowCascades(cascades, glm::mat4(1.0f), projection, lightDirection, 9, resolution, 5000.0f, casterDistance);
+        TEST_CHECK(cascades.count == MaxShadowCascades);
+        TEST_CHECK_NEAR(cascades.splits[MaxShadowCascades - 1], 1000.0f, 1.0f);
+        ComputeShadowCascades(cascades, glm::mat4(1.0f), projection, lightDirection, 0, resolution, 100.0f, casterDistance);
+        TEST_CHECK(cascades.count == 1);
+    }
+
+    // turning the camera keeps the size of the projection, moving it moves the projection by whole texels
+    {
+        glm::mat4 const reference = ComputeCascadeViewProjection(glm::mat4(1.0f), projection, 5.0f, 40.0f, lightDirection, resolution, casterDistance);
+        for (float angle = 0.0f; angle < 6.0f; angle += 0.7f)
+        {
+            glm::vec3 const eye(angle * 3.1f, -angle, angle * angle);
+            glm::mat4 const invView = glm::translate(eye) * glm::rotate(angle, glm::normalize(glm::vec3(1.0f, angle, 0.5f)));
+            glm::mat4 const viewProjection = ComputeCascadeViewProjection(invView, projection, 5.0f, 40.0f, lightDirection, resolution, casterDistance);
+            TEST_CHECK_NEAR(glm::length(glm::vec3(viewProjection[0])), glm::length(glm::vec3(reference[0])), 1e-6f);
+
+            // the world origin lands on the same spot within a texel for every camera
+            glm::vec2 const texel = glm::vec2(viewProjection[3]) * (float)resolution * 0.5f;
+            glm::vec2 const referenceTexel = glm::vec2(reference[3]) * (float)resolution * 0.5f;
+            glm::vec2 const moved = texel - referenceTexel;
+            TEST_CHECK(glm::all(glm::lessThan(glm::abs(moved - glm::round(moved)), glm::vec2(1e-2f))));
+        }
+    }
+
+    return Test::Result();
+}
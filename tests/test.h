@@ -0,0 +1,33 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file test.h
+
+    Checks for the engine tests. Every test is its own executable that only uses
+    cpu side engine code, so the tests run without a window or a GPU. A failed
+    check prints where it failed and makes the executable return non-zero.
+
+    @copyright
+    (C) 2022 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include <cstdio>
+
+namespace Test
+{
+    inline int failures = 0;
+
+    /// exit code of the test executable
+    inline int
+    Result()
+    {
+        if (failures > 0)
+            std::printf("%d check(s) failed\n", failures);
+        return failures > 0 ? 1 : 0;
+    }
+}
+
+#define TEST_CHECK(exp) \
+    do { if (!(exp)) { std::printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp); Test::failures++; } } while (0)
+
+#define TEST_CHECK_NEAR(a, b, epsilon) TEST_CHECK(glm::abs((a) - (b)) <= (epsilon))
@@ -0,0 +1,307 @@
+//------------------------------------------------------------------------------
+//  texturecookertest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/texturecooker.h"
+#include <filesystem>
+#include <fstream>
+
+// the engine gets these from textureresource.cc, which needs GL
+#define STB_IMAGE_IMPLEMENTATION
+#include "render/stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "render/stb_image_write.h"
+
+using namespace Render;
+using namespace Render::TextureCooker;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static glm::ivec3
+Unpack565(uint16_t color)
+{
+    int const r = (color >> 11) & 31;
+    int const g = (color >> 5) & 63;
+    int const b = color & 31;
+    return glm::ivec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Largest difference of any channel between the pixels and the decoded four color block.
+*/
+static int
+BC1Error(uint8_t const rgba[64], uint8_t const block[8])
+{
+    uint16_t const c0 = (uint16_t)(block[0] | (block[1] << 8));
+    uint16_t const c1 = (uint16_t)(block[2] | (block[3] << 8));
+    glm::ivec3 const e0 = Unpack565(c0);
+    glm::ivec3 const e1 = Unpack565(c1);
+    glm::ivec3 const palette[4] = { e0, e1, (2 * e0 + e1) / 3, (e0 + 2 * e1) / 3 };
+    uint32_t const indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+
+    int error = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        glm::ivec3 const pixel(rgba[i * 4 + 0], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+        glm::ivec3 const d = glm::abs(pixel - palette[(indices >> (i * 2)) & 3]);
+        error = glm::max(error, glm::max(d.x, glm::max(d.y, d.z)));
+    }
+    return error;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Largest difference between the values and the decoded block.
+*/
+static int
+BC4Error(uint8_t const* values, uint32_t stride, uint8_t const block[8])
+{
+    int const v0 = block[0];
+    int const v1 = block[1];
+    int palette[8] = { v0, v1 };
+    for (int i = 1; i < 7; i++)
+        palette[i + 1] = v0 > v1 ? ((7 - i) * v0 + i * v1) / 7 : v0;
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++)
+        indices |= (uint64_t)block[2 + i] << (i * 8);
+
+    int error = 0;
+    for (int i = 0; i < 16; i++)
+        error = glm::max(error, glm::abs((int)values[i * stride] - palette[(indices >> (i * 3)) & 7]));
+    return error;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static std::vector<uint8_t>
+MakeImage(uint32_t width, uint32_t height, bool alpha)
+{
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* p = &pixels[((size_t)y * width + x) * 4];
+            p[0] = (uint8_t)(x * 255 / glm::max(width - 1, 1u));
+            p[1] = (uint8_t)(y * 255 / glm::max(height - 1, 1u));
+            p[2] = (uint8_t)((x + y) & 0xFF);
+            p[3] = alpha ? (uint8_t)(255 - x) : 255;
+        }
+    }
+    return pixels;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+WriteBytes(std::string const& path, void const* data, size_t size)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write((char const*)data, (std::streamsize)size);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    // block sizes
+    {
+        TEST_CHECK(BlockSize(Format::BC1) == 8);
+        TEST_CHECK(BlockSize(Format::BC3) == 16);
+        TEST_CHECK(BlockSize(Format::BC5) == 16);
+        TEST_CHECK(MipSize(Format::BC1, 1, 1) == 8);
+        TEST_CHECK(MipSize(Format::BC1, 5, 4) == 16);
+        TEST_CHECK(MipSize(Format::BC3, 16, 9) == 4 * 3 * 16);
+    }
+
+    // BC1 blocks, always in four color mode
+    {
+        uint8_t rgba[64];
+        uint8_t block[8];
+
+        // one color, only the 565 rounding is lost
+        for (int i = 0; i < 16; i++)
+        {
+            rgba[i * 4 + 0] = 200;
+            rgba[i * 4 + 1] = 100;
+            rgba[i * 4 + 2] = 37;
+            rgba[i * 4 + 3] = 255;
+        }
+        EncodeBC1Block(rgba, block);
+        TEST_CHECK(BC1Error(rgba, block) <= 4);
+
+        // two colors are both endpoints, or close to them
+        for (int i = 0; i < 16; i++)
+        {
+            bool const first = (i * 7) % 3 == 0;
+            rgba[i * 4 + 0] = first ? 250 : 10;
+            rgba[i * 4 + 1] = first ? 20 : 240;
+            rgba[i * 4 + 2] = first ? 128 : 64;
+        }
+        EncodeBC1Block(rgba, block);
+        TEST_CHECK((block[0] | (block[1] << 8)) >= (block[2] | (block[3] << 8)));
+        TEST_CHECK(BC1Error(rgba, block) <= 24);
+
+        // a gradient along one axis
+        for (int i = 0; i < 16; i++)
+        {
+            rgba[i * 4 + 0] = (uint8_t)(i * 16);
+            rgba[i * 4 + 1] = (uint8_t)(255 - i * 16);
+            rgba[i * 4 + 2] = (uint8_t)(64 + i * 8);
+        }
+        EncodeBC1Block(rgba, block);
+        TEST_CHECK((block[0] | (block[1] << 8)) >= (block[2] | (block[3] << 8)));
+        // four colors for sixteen values spread over 240, the ones between two colors are up to ~35 off
+        TEST_CHECK(BC1Error(rgba, block) <= 44);
+    }
+
+    // BC4 blocks, read with a stride out of rgba pixels
+    {
+        uint8_t rgba[64] = {};
+        uint8_t block[8];
+        for (int i = 0; i < 16; i++)
+            rgba[i * 4 + 3] = 77;
+        EncodeBC4Block(rgba + 3, 4, block);
+        TEST_CHECK(BC4Error(rgba + 3, 4, block) == 0);
+
+        for (int i = 0; i < 16; i++)
+            rgba[i * 4 + 1] = (uint8_t)(20 + i * i);
+        EncodeBC4Block(rgba + 1, 4, block);
+        // half a step of the eight values between 20 and 245, plus rounding
+        TEST_CHECK(BC4Error(rgba + 1, 4, block) <= (245 - 20) / 14 + 1);
+
+        for (int i = 0; i < 16; i++)
+            rgba[i * 4 + 1] = i < 8 ? 0 : 255;
+        EncodeBC4Block(rgba + 1, 4, block);
+        TEST_CHECK(BC4Error(rgba + 1, 4, block) == 0);
+    }
+
+    // format from the usage and the alpha channel, and a full mip chain down to 1x1
+    {
+        CookedTexture texture;
+        std::vector<uint8_t> const opaque = MakeImage(37, 19, false);
+        Encode(opaque.data(), 37, 19, Usage::Color, texture);
+        TEST_CHECK(texture.IsValid());
+        TEST_CHECK(texture.header.format == Format::BC1);
+        TEST_CHECK(texture.header.numMips == 6);
+        size_t expected = 0;
+        uint32_t const widths[] = { 37, 18, 9, 4, 2, 1 };
+        uint32_t const heights[] = { 19, 9, 4, 2, 1, 1 };
+        for (int mip = 0; mip < 6; mip++)
+            expected += MipSize(Format::BC1, widths[mip], heights[mip]);
+        TEST_CHECK(texture.size == expected);
+
+        std::vector<uint8_t> const transparent = MakeImage(16, 16, true);
+        Encode(transparent.data(), 16, 16, Usage::ColorSRGB, texture);
+        TEST_CHECK(texture.header.format == Format::BC3);
+        TEST_CHECK(texture.header.numMips == 5);
+        Encode(opaque.data(), 37, 19, Usage::NormalMap, texture);
+        TEST_CHECK(texture.header.format == Format::BC5);
+    }
+
+    std::filesystem::path const folder = std::filesystem::temp_directory_path() / "texturecookertest";
+    std::filesystem::remove_all(folder);
+    std::string const cacheFolder = folder.string();
+
+    // cache files round trip, and anything that doesn't match the header is refused
+    {
+        CookedTexture texture;
+        std::vector<uint8_t> const image = MakeImage(40, 24, false);
+        Encode(image.data(), 40, 24, Usage::Color, texture);
+        texture.header.sourceHash = 1234;
+        std::string const path = CachePath(cacheFolder, 1234);
+        TEST_CHECK(WriteCache(path, texture));
+
+        CookedTexture read;
+        TEST_CHECK(ReadCache(path, read));
+        TEST_CHECK(memcmp(&read.header, &texture.header, sizeof(Header)) == 0);
+        TEST_CHECK(read.size == texture.size);
+        TEST_CHECK(read.IsValid() && memcmp(read.data, texture.data, texture.size) == 0);
+        // mapped, not copied
+        TEST_CHECK(read.storage.empty());
+
+        CookedTexture rejected;
+        TEST_CHECK(!ReadCache(CachePath(cacheFolder, 5678), rejected));
+
+        std::vector<uint8_t> file(sizeof(Header) + texture.size);
+        memcpy(file.data(), &texture.header, sizeof(Header));
+        memcpy(file.data() + sizeof(Header), texture.data, texture.size);
+        std::string const broken = cacheFolder + "/broken.ctex";
+
+        WriteBytes(broken, file.data(), file.size() - 1);
+        TEST_CHECK(!ReadCache(broken, rejected));
+        WriteBytes(broken, file.data(), sizeof(Header) - 1);
+        TEST_CHECK(!ReadCache(broken, rejected));
+        file.push_back(0);
+        WriteBytes(broken, file.data(), file.size());
+        TEST_CHECK(!ReadCache(broken, rejected));
+        file.pop_back();
+
+        Header header = texture.header;
+        header.version = Version + 1;
+        memcpy(file.data(), &header, sizeof(Header));
+        WriteBytes(broken, file.data(), file.size());
+        TEST_CHECK(!ReadCache(broken, rejected));
+
+        header = texture.header;
+        header.magic = 0;
+        memcpy(file.data(), &header, sizeof(Header));
+        WriteBytes(broken, file.data(), file.size());
+        TEST_CHECK(!ReadCache(broken, rejected));
+
+        header = texture.header;
+        header.numMips = 0;
+        memcpy(file.data(), &header, sizeof(Header));
+        WriteBytes(broken, file.data(), sizeof(Header));
+        TEST_CHECK(!ReadCache(broken, rejected));
+
+        memcpy(file.data(), &texture.header, sizeof(Header));
+        WriteBytes(broken, file.data(), file.size());
+        TEST_CHECK(ReadCache(broken, rejected));
+    }
+
+    // cooking an image encodes it once, the second time it comes from the cache
+    {
+        std::vector<uint8_t> const image = MakeImage(33, 20, false);
+        std::vector<uint8_t> png;
+        stbi_write_png_to_func([](void* context, void* data, int size)
+        {
+            std::vector<uint8_t>& out = *(std::vector<uint8_t>*)context;
+            out.insert(out.end(), (uint8_t*)data, (uint8_t*)data + size);
+        }, &png, 33, 20, 4, image.data(), 33 * 4);
+        TEST_CHECK(!png.empty());
+
+        CookedTexture cooked;
+        TEST_CHECK(Cook(png.data(), png.size(), Usage::Color, cacheFolder, cooked));
+        TEST_CHECK(!cooked.storage.empty());
+        uint64_t const hash = HashSource(png.data(), png.size(), Usage::Color);
+        TEST_CHECK(cooked.header.sourceHash == hash);
+        TEST_CHECK(std::filesystem::exists(CachePath(cacheFolder, hash)));
+
+        CookedTexture cached;
+        TEST_CHECK(Cook(png.data(), png.size(), Usage::Color, cacheFolder, cached));
+        TEST_CHECK(cached.storage.empty());
+        TEST_CHECK(memcmp(&cached.header, &cooked.header, sizeof(Header)) == 0);
+        TEST_CHECK(cached.size == cooked.size && memcmp(cached.data, cooked.data, cooked.size) == 0);
+
+        // the usage is part of the key
+        TEST_CHECK(HashSource(png.data(), png.size(), Usage::NormalMap) != hash);
+        CookedTexture normalMap;
+        TEST_CHECK(Cook(png.data(), png.size(), Usage::NormalMap, cacheFolder, normalMap));
+        TEST_CHECK(normalMap.header.format == Format::BC5);
+
+        CookedTexture garbage;
+        uint8_t const notAnImage[16] = { 1, 2, 3 };
+        TEST_CHECK(!Cook(notAnImage, sizeof(notAnImage), Usage::Color, cacheFolder, garbage));
+    }
+
+    std::filesystem::remove_all(folder);
+    return Test::Result();
+}
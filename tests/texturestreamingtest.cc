@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------------
+//  texturestreamingtest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/texturestreaming.h"
+
+using namespace Render;
+
+/// BC1 sizes of a 1024x1024 texture's mips
+static size_t mipBytes[11];
+
+//------------------------------------------------------------------------------
+/**
+*/
+static uint32_t
+AddTexture(TextureStreamer& streamer)
+{
+    return AddStreamedTexture(streamer, 1024, 1024, 11, mipBytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Runs a frame and checks that the changes match the residency and that the budget is kept,
+    unless the requests alone are over it.
+*/
+static void
+Update(TextureStreamer& streamer, size_t budget, size_t uploadBytes, std::vector<StreamingChange>& changes)
+{
+    std::vector<uint32_t> before;
+    size_t requestedBytes = 0;
+    for (TextureStreamer::Texture const& t : streamer.textures)
+    {
+        before.push_back(t.residentMip);
+        for (uint32_t mip = glm::max(t.wantedMip, t.residentMip); mip < t.tailMip; mip++)
+            requestedBytes += t.mipBytes[mip];
+    }
+
+    UpdateTextureStreaming(streamer, budget, uploadBytes, changes);
+
+    size_t residentBytes = 0;
+    size_t change = 0;
+    for (uint32_t i = 0; i < (uint32_t)streamer.textures.size(); i++)
+    {
+        TextureStreamer::Texture const& t = streamer.textures[i];
+        TEST_CHECK(t.residentMip <= t.tailMip);
+        TEST_CHECK(t.wantedMip == t.tailMip);
+        // at most one level finer per frame
+        TEST_CHECK(t.residentMip + 1 >= before[i]);
+        for (uint32_t mip = t.residentMip; mip < t.tailMip; mip++)
+            residentBytes += t.mipBytes[mip];
+        if (t.residentMip != before[i])
+        {
+            TEST_CHECK(change < changes.size() && changes[change].texture == i);
+            if (change < changes.size())
+                TEST_CHECK(changes[change].previousMip == before[i] && changes[change].residentMip == t.residentMip);
+            change++;
+        }
+    }
+    TEST_CHECK(change == changes.size());
+    TEST_CHECK(residentBytes == streamer.residentBytes);
+    TEST_CHECK(streamer.residentBytes <= budget || streamer.residentBytes <= requestedBytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    for (uint32_t mip = 0; mip < 11; mip++)
+        mipBytes[mip] = glm::max((size_t)(1024 >> mip) * (1024 >> mip) / 2, (size_t)8);
+    size_t const fullBytes = mipBytes[0] + mipBytes[1] + mipBytes[2] + mipBytes[3];
+    size_t const unlimited = SIZE_MAX;
+    std::vector<StreamingChange> changes;
+
+    // the tail is the finest mip of at most StreamingTailSize, and resident from the start
+    {
+        TextureStreamer streamer;
+        TEST_CHECK(AddTexture(streamer) == 0);
+        TEST_CHECK(AddStreamedTexture(streamer, 64, 32, 7, mipBytes) == 1);
+        TEST_CHECK(AddStreamedTexture(streamer, 512, 128, 10, mipBytes) == 2);
+        TEST_CHECK(streamer.textures[0].tailMip == 4);
+        TEST_CHECK(streamer.textures[1].tailMip == 0);
+        TEST_CHECK(streamer.textures[2].tailMip == 3);
+        for (TextureStreamer::Texture const& t : streamer.textures)
+            TEST_CHECK(t.residentMip == t.tailMip);
+        TEST_CHECK(streamer.residentBytes == 0);
+    }
+
+    // about one texel per pixel
+    {
+        TEST_CHECK(RequiredMip(1024, 512, 11, 2048.0f) == 0);
+        TEST_CHECK(RequiredMip(1024, 512, 11, 1024.0f) == 0);
+        TEST_CHECK(RequiredMip(1024, 512, 11, 256.0f) == 2);
+        TEST_CHECK(RequiredMip(1024, 512, 11, 200.0f) == 2);
+        TEST_CHECK(RequiredMip(1024, 512, 11, 0.5f) == 10);
+        TEST_CHECK(RequiredMip(1024, 512, 4, 16.0f) == 3);
+    }
+
+    // the finest request of a frame wins, and the mips come in one level per frame
+    {
+        TextureStreamer streamer;
+        AddTexture(streamer);
+        RequestStreamedMip(streamer, 0, 2);
+        RequestStreamedMip(streamer, 0, 0);
+        RequestStreamedMip(streamer, 0, 3);
+        TEST_CHECK(streamer.textures[0].wantedMip == 0);
+        for (uint32_t frame = 0; frame < 4; frame++)
+        {
+            if (frame > 0)
+                RequestStreamedMip(streamer, 0, 0);
+            Update(streamer, unlimited, unlimited, changes);
+            TEST_CHECK(changes.size() == 1);
+            TEST_CHECK(streamer.textures[0].residentMip == 3 - frame);
+        }
+        TEST_CHECK(streamer.residentBytes == fullBytes);
+
+        // nothing changes while the budget holds, even without requests
+        Update(streamer, unlimited, unlimited, changes);
+        TEST_CHECK(changes.empty());
+        TEST_CHECK(streamer.textures[0].residentMip == 0);
+
+        // a smaller budget evicts what isn't needed at once, down to the tail
+        Update(streamer, 0, unlimited, changes);
+        TEST_CHECK(changes.size() == 1);
+        TEST_CHECK(streamer.textures[0].residentMip == 4);
+        TEST_CHECK(streamer.residentBytes == 0);
+    }
+
+    // what a frame requests is never evicted, even over the budget
+    {
+        TextureStreamer streamer;
+        AddTexture(streamer);
+        for (uint32_t frame = 0; frame < 4; frame++)
+        {
+            RequestStreamedMip(streamer, 0, 0);
+            Update(streamer, unlimited, unlimited, changes);
+        }
+        RequestStreamedMip(streamer, 0, 0);
+        Update(streamer, mipBytes[3], unlimited, changes);
+        TEST_CHECK(changes.empty());
+        TEST_CHECK(streamer.textures[0].residentMip == 0);
+
+        // and only the mips finer than the request are evicted
+        RequestStreamedMip(streamer, 0, 2);
+        Update(streamer, 0, unlimited, changes);
+        TEST_CHECK(streamer.textures[0].residentMip == 2);
+        TEST_CHECK(streamer.residentBytes == mipBytes[2] + mipBytes[3]);
+    }
+
+    // a texture that is needed takes the memory of one that isn't
+    {
+        TextureStreamer streamer;
+        AddTexture(streamer);
+        AddTexture(streamer);
+        for (uint32_t frame = 0; frame < 4; frame++)
+        {
+            RequestStreamedMip(streamer, 0, 0);
+            Update(streamer, fullBytes, unlimited, changes);
+        }
+        TEST_CHECK(streamer.textures[0].residentMip == 0);
+        for (uint32_t frame = 0; frame < 4; frame++)
+        {
+            RequestStreamedMip(streamer, 1, 0);
+            Update(streamer, fullBytes, unlimited, changes);
+            TEST_CHECK(streamer.textures[1].residentMip == 3 - frame);
+        }
+        TEST_CHECK(streamer.textures[0].residentMip == 4);
+        TEST_CHECK(streamer.residentBytes == fullBytes);
+    }
+
+    // the texture needed least recently is evicted first
+    {
+        TextureStreamer streamer;
+        for (int i = 0; i < 3; i++)
+            AddTexture(streamer);
+        RequestStreamedMip(streamer, 0, 3);
+        Update(streamer, unlimited, unlimited, changes);
+        RequestStreamedMip(streamer, 1, 3);
+        Update(streamer, unlimited, unlimited, changes);
+        TEST_CHECK(streamer.textures[0].residentMip == 3 && streamer.textures[1].residentMip == 3);
+
+        RequestStreamedMip(streamer, 2, 3);
+        Update(streamer, 2 * mipBytes[3], unlimited, changes);
+        TEST_CHECK(streamer.textures[0].residentMip == 4);
+        TEST_CHECK(streamer.textures[1].residentMip == 3);
+        TEST_CHECK(streamer.textures[2].residentMip == 3);
+    }
+
+    // uploads stop at the frame's limit, but at least one happens, and the textures missing most go first
+    {
+        TextureStreamer streamer;
+        for (int i = 0; i < 3; i++)
+            AddTexture(streamer);
+        auto const request = [&streamer]()
+        {
+            RequestStreamedMip(streamer, 0, 3);
+            RequestStreamedMip(streamer, 1, 0);
+            RequestStreamedMip(streamer, 2, 2);
+        };
+
+        request();
+        Update(streamer, unlimited, 1, changes);
+        TEST_CHECK(changes.size() == 1 && changes[0].texture == 1);
+
+        // exactly enough for a level of every texture
+        request();
+        Update(streamer, unlimited, mipBytes[2] + 2 * mipBytes[3], changes);
+        TEST_CHECK(changes.size() == 3);
+        TEST_CHECK(streamer.textures[0].residentMip == 3);
+        TEST_CHECK(streamer.textures[1].residentMip == 2);
+        TEST_CHECK(streamer.textures[2].residentMip == 3);
+
+        // texture 1 is missing two levels now, texture 2 one and texture 0 none
+        request();
+        Update(streamer, unlimited, 1, changes);
+        TEST_CHECK(changes.size() == 1 && changes[0].texture == 1);
+        request();
+        Update(streamer, unlimited, 1, changes);
+        TEST_CHECK(changes.size() == 1 && changes[0].texture == 1);
+        request();
+        Update(streamer, unlimited, 1, changes);
+        TEST_CHECK(changes.size() == 1 && changes[0].texture == 2);
+    }
+
+    // many textures and a changing budget keep the bookkeeping consistent
+    {
+        TextureStreamer streamer;
+        for (int i = 0; i < 50; i++)
+            AddTexture(streamer);
+        uint32_t seed = 4242;
+        auto const random = [&seed](uint32_t n) { seed = seed * 1664525u + 1013904223u; return (seed >> 8) % n; };
+        for (int frame = 0; frame < 500; frame++)
+        {
+            for (int r = 0; r < 10; r++)
+                RequestStreamedMip(streamer, random(50), random(5));
+            size_t const budget = fullBytes * (1 + random(20));
+            Update(streamer, budget, fullBytes, changes);
+        }
+    }
+
+    return Test::Result();
+}
@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+//  uniformtabletest.cc
+//  (C) 2022 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "test.h"
+#include "render/uniformtable.h"
+#include <unordered_map>
+
+using namespace Render;
+
+// names hashed at compile time and at runtime agree
+static_assert(UniformName("ViewProjection").hash == HashUniformName("ViewProjection"));
+static_assert(HashUniformName("") != 0);
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+main()
+{
+    // an empty table finds nothing
+    {
+        UniformTable table;
+        TEST_CHECK(table.Size() == 0);
+        TEST_CHECK(table.Find("ViewProjection") == UniformTable::NotFound);
+    }
+
+    // lookups by compile time and runtime names, and updating a name that is already in
+    {
+        UniformTable table;
+        TEST_CHECK(table.Insert("ViewProjection", 3));
+        TEST_CHECK(table.Insert("Model", 7));
+        TEST_CHECK(table.Insert("BaseColorFactor", 0));
+        TEST_CHECK(table.Size() == 3);
+        TEST_CHECK(table.Find("ViewProjection") == 3);
+        TEST_CHECK(table.Find("Model") == 7);
+        TEST_CHECK(table.Find("BaseColorFactor") == 0);
+        TEST_CHECK(table.Find(UniformName::FromString(std::string("Mod") + "el")) == 7);
+        TEST_CHECK(table.Find("model") == UniformTable::NotFound);
+
+        TEST_CHECK(table.Insert("Model", 9));
+        TEST_CHECK(table.Size() == 3);
+        TEST_CHECK(table.Find("Model") == 9);
+
+        table.Clear();
+        TEST_CHECK(table.Size() == 0);
+        TEST_CHECK(table.Find("Model") == UniformTable::NotFound);
+        TEST_CHECK(table.Insert("Model", 1));
+        TEST_CHECK(table.Find("Model") == 1);
+    }
+
+    // every name is still found after the table grew several times
+    {
+        UniformTable table;
+        int const count = 1000;
+        for (int i = 0; i < count; i++)
+            TEST_CHECK(table.Insert("Lights[" + std::to_string(i) + "]", i));
+        TEST_CHECK(table.Size() == count);
+        for (int i = 0; i < count; i++)
+            TEST_CHECK(table.Find(UniformName::FromString("Lights[" + std::to_string(i) + "]")) == i);
+        TEST_CHECK(table.Find(UniformName::FromString("Lights[1000]")) == UniformTable::NotFound);
+    }
+
+    // a different name with the same hash is refused instead of shadowing the first one
+    {
+        std::unordered_map<uint32_t, std::string> seen;
+        std::string first, second;
+        for (int i = 0; second.empty(); i++)
+        {
+            std::string name = "u";
+            name += std::to_string(i);
+            auto const inserted = seen.emplace(HashUniformName(name), name);
+            if (!inserted.second)
+            {
+                first = inserted.first->second;
+                second = name;
+            }
+        }
+        UniformTable table;
+        TEST_CHECK(table.Insert(first, 1));
+        TEST_CHECK(!table.Insert(second, 2));
+        TEST_CHECK(table.Size() == 1);
+        TEST_CHECK(table.Find(UniformName::FromString(first)) == 1);
+    }
+
+    return Test::Result();
+}